@@ -0,0 +1,421 @@
+// ============================================================================
+//
+//                              CONFIDENTIAL
+//
+//        GENOMICS INSTITUTE OF THE NOVARTIS RESEARCH FOUNDATION (GNF)
+//
+//  This is an unpublished work of authorship, which contains trade secrets,
+//  created in 2026.  GNF owns all rights to this work and intends to maintain
+//  it in confidence to preserve its trade secret status.  GNF reserves the
+//  right, under the copyright laws of the United States or those of any other
+//  country that may have jurisdiction, to protect this work as an unpublished
+//  work, in the event of an inadvertent or deliberate unauthorized publication.
+//  GNF also reserves its rights under all copyright laws to protect this work
+//  as a published work, when appropriate.  Those having access to this work
+//  may not copy it, use it, modify it or disclose the information contained
+//  in it without the written authorization of GNF.
+//
+// ============================================================================
+
+// ============================================================================
+//
+//            Name: TwinCATBench.cpp
+//
+//     Description: TwinCAT DLL control loop microbenchmarks
+//
+//          Author: agent
+//
+// ============================================================================
+
+// ============================================================================
+//
+//      %subsystem: 1 %
+//           %name: twincatbench.cpp %
+//        %version: 1 %
+//          %state: %
+//         %cvtype: c++ %
+//     %derived_by: mconner %
+//  %date_modified: %
+//
+// ============================================================================
+
+#include "StdAfx.h"
+#include "TwinCATADS.h"
+#include "TwinCATIO.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+// results are written to stdout as CSV, one row per benchmark and configuration:
+//
+//   benchmark,axes,programs,iterations,min_ns_per_call,median_ns_per_call
+//
+// the library runs against the in-process virtual PLC with no latency, so the figures are the
+// cost of the library itself and not of the router or the network; the first rows report the
+// resolution of the clocks the figures rest on...
+
+namespace
+{
+  CWinApp g_twinCATBench;
+
+  using CClock = std::chrono::steady_clock;
+
+  int       const MAX_COUNT       (256);               // axes and programs are swept 1, 2, 4, ... 256
+  int       const NUM_REPETITIONS (7);                 // the minimum and median of the repetitions are reported
+  ULONGLONG const MIN_DURATION    (20);                // milliseconds per repetition
+  DWORD     const MOTION_TIMEOUT  (1000);              // milliseconds for the virtual PLC to answer a motion
+  DWORD     const PLC_LATENCY     (100);               // microseconds per request, to check the virtual PLC pacing
+  WORD      const ANALOG_PORT     (AMSPORT_R0_IO + 1);
+  WORD      const DISCRETE_PORT   (AMSPORT_R0_IO + 2);
+
+  int const NUM_ANALOG_CHANNELS (static_cast <int> (sizeof (SAnalogInputs::m_analogInputData) / sizeof (SAnalogInputs::m_analogInputData[0])));
+
+  volatile LONGLONG g_sink (0);
+
+  template <typename F> void
+  Measure (LPCTSTR benchmark, int numAxes, int numPrograms, F && f)
+  {
+    // double the batch until one batch takes the minimum duration, this also warms up the caches...
+
+    ULONGLONG l_iterations (1);
+
+    for (;;)
+      {
+        auto const l_start (CClock::now ());
+
+        for (ULONGLONG l_i (0); l_i < l_iterations; ++l_i)
+          {
+            f ();
+          }
+
+        if (std::chrono::duration_cast <std::chrono::milliseconds> (CClock::now () - l_start).count () >= static_cast <LONGLONG> (MIN_DURATION))
+          {
+            break;
+          }
+
+        l_iterations *= 2;
+      }
+
+    std::vector <double> l_nsPerCall;
+
+    for (int l_repetition (0); l_repetition < NUM_REPETITIONS; ++l_repetition)
+      {
+        auto const l_start (CClock::now ());
+
+        for (ULONGLONG l_i (0); l_i < l_iterations; ++l_i)
+          {
+            f ();
+          }
+
+        l_nsPerCall.push_back (std::chrono::duration <double, std::nano> (CClock::now () - l_start).count () / static_cast <double> (l_iterations));
+      }
+
+    std::sort (l_nsPerCall.begin (), l_nsPerCall.end ());
+
+    _ftprintf (stdout, _T ("%s,%d,%d,%I64u,%.1f,%.1f\n"), benchmark, numAxes, numPrograms, l_iterations, l_nsPerCall.front (), l_nsPerCall[NUM_REPETITIONS / 2]);
+
+    ::fflush (stdout);
+  }
+
+  void
+  Report (LPCTSTR benchmark, double nsPerCall)
+  {
+    _ftprintf (stdout, _T ("%s,0,0,1,%.1f,%.1f\n"), benchmark, nsPerCall, nsPerCall);
+
+    ::fflush (stdout);
+  }
+
+  std::shared_ptr <CTwinCATADS>
+  CreateTwinCATADS (int numAxes, int numPrograms, DWORD latency = 0)
+  {
+    CTwinCATADS::SVirtualPLC const l_virtualPLC { latency, 0, 0.0, ADSERR_NOERR };
+
+    auto const l_twinCATADS (std::make_shared <CTwinCATADS> (0, numAxes, numPrograms, false));
+
+    // the handshakes are notified every 10 ms rather than at the default status rate...
+
+    for (auto l_identifier : { _T ("MotionComplete"), _T ("MotionStopped"), _T ("ProgramComplete") })
+      {
+        if (!l_twinCATADS->SetNotificationRate (l_identifier, CTwinCATADS::RATE_ON_CHANGE))
+          {
+            PDCLib::ThrowStringException (_T ("unable to set notification rate; %s"), (LPCTSTR) l_twinCATADS->GetErrorMessage ());
+          }
+      }
+
+    if (!l_twinCATADS->Create (l_virtualPLC, ANALOG_PORT, DISCRETE_PORT))
+      {
+        PDCLib::ThrowStringException (_T ("unable to create TwinCAT ADS; %s"), (LPCTSTR) l_twinCATADS->GetErrorMessage ());
+      }
+
+    return l_twinCATADS;
+  }
+
+  void
+  MeasureTwinCATADS (int count)
+  {
+    auto const l_twinCATADS (CreateTwinCATADS (count, count));
+
+    int    l_axis (0);
+    double l_position (0.0);
+
+    Measure (_T ("CTwinCATADS::UpdateInputs"), count, count, [&] { l_twinCATADS->UpdateInputs (); });
+
+    Measure (_T ("CTwinCATADS::UpdateOutputs (idle)"), count, count, [&] { l_twinCATADS->UpdateOutputs (); });
+
+    // the virtual PLC answers on its next 1 ms cycle, a round trip is the request, the acknowledge, the
+    // release of the request and the release of the acknowledge...
+
+    std::vector <int> l_axes;
+
+    for (int l_i (0); l_i < count; ++l_i)
+      {
+        l_axes.push_back (l_i);
+      }
+
+    Measure (_T ("CTwinCATADS motion round trip (all axes)"), count, count, [&]
+             {
+               for (auto l_i : l_axes)
+                 {
+                   l_twinCATADS->BeginMotion (l_i);
+                 }
+
+               if (!l_twinCATADS->WaitForAll (l_axes, {}, MOTION_TIMEOUT))
+                 {
+                   PDCLib::ThrowStringException (_T ("unable to complete motion; %s"), (LPCTSTR) l_twinCATADS->GetErrorMessage ());
+                 }
+             });
+
+    // the acknowledges are not taken in without UpdateInputs, alternating begin and stop leaves a request
+    // pending on every call...
+
+    bool l_isBegin (false);
+
+    Measure (_T ("CTwinCATADS::UpdateOutputs (all axes pending)"), count, count, [&]
+             {
+               for (int l_i (0); l_i < count; ++l_i)
+                 {
+                   if (l_isBegin)
+                     {
+                       l_twinCATADS->BeginMotion (l_i);
+                     }
+                   else
+                     {
+                       l_twinCATADS->StopMotion (l_i);
+                     }
+                 }
+
+               l_isBegin = !l_isBegin;
+
+               g_sink += l_twinCATADS->UpdateOutputs ();
+             });
+
+    // the public setters write through SetVariable_ in the immediate write mode, the program variables
+    // through SetVariable with an identifier...
+
+    Measure (_T ("CTwinCATADS::SetVariable_ (element)"), count, count, [&]
+             {
+               g_sink += l_twinCATADS->SetPosition (l_axis, l_position += 1.0);
+
+               l_axis = (l_axis + 1) % count;
+             });
+
+    std::vector <double> l_value (count, 0.0);
+
+    Measure (_T ("CTwinCATADS::SetVariable (identifier, array)"), count, count, [&]
+             {
+               l_value[l_axis] += 1.0;
+
+               g_sink += l_twinCATADS->SetVariable (_T ("benchmarkValue"), l_value);
+
+               l_axis = (l_axis + 1) % count;
+             });
+
+    Measure (_T ("CTwinCATADS::GetPosition"), count, count, [&]
+             {
+               for (int l_i (0); l_i < count; ++l_i)
+                 {
+                   g_sink += static_cast <LONGLONG> (l_twinCATADS->GetPosition (l_i));
+                 }
+             });
+  }
+
+  void
+  MeasureTwinCATIO (void)
+  {
+    auto const l_twinCATADS (CreateTwinCATADS (1, 1));
+
+    CTwinCATIO l_twinCATIO (ANALOG_PORT, DISCRETE_PORT, false, l_twinCATADS);
+
+    if (!l_twinCATIO.Create ())
+      {
+        PDCLib::ThrowStringException (_T ("unable to create TwinCAT I/O; %s"), (LPCTSTR) l_twinCATIO.GetErrorMessage ());
+      }
+
+    // the analog input filters are updated by UpdateInputs and sampled by UpdateOutputs...
+
+    Measure (_T ("CTwinCATIO::UpdateInputs"), 0, 0, [&] { l_twinCATIO.UpdateInputs (); });
+
+    Measure (_T ("CTwinCATIO::UpdateOutputs"), 0, 0, [&]
+             {
+               l_twinCATIO.TglOutputBit (0);
+               l_twinCATIO.UpdateOutputs ();
+             });
+
+    Measure (_T ("CFilteredADChannel::GetValue"), 0, 0, [&]
+             {
+               for (int l_channel (0); l_channel < NUM_ANALOG_CHANNELS; ++l_channel)
+                 {
+                   g_sink += l_twinCATIO.GetAnalogInput (l_channel);
+                 }
+             });
+
+    Measure (_T ("CTwinCATIO::IsInputBitSet"), 0, 0, [&]
+             {
+               for (int l_i (0); l_i < 256; ++l_i)
+                 {
+                   g_sink += l_twinCATIO.IsInputBitSet (l_i);
+                 }
+             });
+  }
+
+  void
+  MeasureTimer (void)
+  {
+    // the steady clock is the performance counter, a sleep lasts until the next scheduler tick...
+
+    LARGE_INTEGER l_frequency;
+
+    ::QueryPerformanceFrequency (&l_frequency);
+
+    Report (_T ("std::chrono::steady_clock period"), std::chrono::duration <double, std::nano> (CClock::duration (1)).count ());
+    Report (_T ("QueryPerformanceCounter period"), 1.0e9 / static_cast <double> (l_frequency.QuadPart));
+
+    Measure (_T ("PDCLib::Sleep (1)"), 0, 0, [] { PDCLib::Sleep (1); });
+
+    // the virtual PLC paces its latency on the steady clock, a write should take no more than the latency...
+
+    auto const l_twinCATADS (CreateTwinCATADS (1, 1, PLC_LATENCY));
+
+    double l_position (0.0);
+
+    Measure (_T ("CTwinCATADS::SetPosition (100 us virtual PLC latency)"), 1, 1, [&] { g_sink += l_twinCATADS->SetPosition (0, l_position += 1.0); });
+  }
+
+  void
+  MeasureBit (void)
+  {
+    std::vector <BYTE> l_vector (32, 0);
+    CByteArray         l_array;
+    WORD               l_word (0);
+
+    l_array.SetSize (32);
+
+    Measure (_T ("SetBit/ClrBit/TglBit (vector)"), 0, 0, [&]
+             {
+               for (int l_i (0); l_i < 256; ++l_i)
+                 {
+                   ::SetBit (l_vector, l_i);
+                   ::TglBit (l_vector, l_i);
+                   ::ClrBit (l_vector, l_i);
+                 }
+
+               g_sink += l_vector[0];
+             });
+
+    Measure (_T ("IsBitSet (vector)"), 0, 0, [&]
+             {
+               for (int l_i (0); l_i < 256; ++l_i)
+                 {
+                   g_sink += ::IsBitSet (l_vector, l_i);
+                 }
+             });
+
+    Measure (_T ("SetBit/ClrBit/TglBit (CByteArray)"), 0, 0, [&]
+             {
+               for (int l_i (0); l_i < 256; ++l_i)
+                 {
+                   ::SetBit (l_array, l_i);
+                   ::TglBit (l_array, l_i);
+                   ::ClrBit (l_array, l_i);
+                 }
+
+               g_sink += l_array[0];
+             });
+
+    Measure (_T ("IsBitSet (CByteArray)"), 0, 0, [&]
+             {
+               for (int l_i (0); l_i < 256; ++l_i)
+                 {
+                   g_sink += ::IsBitSet (l_array, l_i);
+                 }
+             });
+
+    Measure (_T ("SetBits/ClrBits/TglBits (WORD)"), 0, 0, [&]
+             {
+               for (int l_i (0); l_i < 16; ++l_i)
+                 {
+                   auto const l_mask (static_cast <WORD> (0x0001 << l_i));
+
+                   ::SetBits (l_word, l_mask);
+                   ::TglBits (l_word, l_mask);
+                   ::ClrBits (l_word, l_mask);
+                 }
+
+               g_sink += l_word;
+             });
+  }
+}
+
+int
+_tmain (int /* argc */, TCHAR * /* argv */[])
+{
+  if (!::AfxWinInit (::GetModuleHandle (nullptr), nullptr, ::GetCommandLine (), 0))
+    {
+      _ftprintf (stderr, _T ("unable to initialize MFC\n"));
+
+      return 1;
+    }
+
+  try
+    {
+      _ftprintf (stdout, _T ("benchmark,axes,programs,iterations,min_ns_per_call,median_ns_per_call\n"));
+
+      MeasureTimer ();
+      MeasureBit ();
+      MeasureTwinCATIO ();
+
+      for (int l_count (1); l_count <= MAX_COUNT; l_count *= 2)
+        {
+          MeasureTwinCATADS (l_count);
+        }
+    }
+  catch (CString const & errorMessage)
+    {
+      _ftprintf (stderr, _T ("%s\n"), (LPCTSTR) errorMessage);
+
+      return 1;
+    }
+
+  return 0;
+}
+
+// ============================================================================
+//  R E V I S I O N    N O T E S
+// ============================================================================
+//
+//  For each change to this file, record the following:
+//
+//   1. who made the change and when the change was made
+//   2. why the change was made and the intended result
+//
+// ============================================================================
+//
+//  Date        Author  Description
+// ----------------------------------------------------------------------------
+//  10/17/2026  AGT     initial revision
+//  10/17/2026  AGT     report the timer resolution and measure the motion round trip
+//  10/17/2026  AGT     name the program variable benchmark after the call it measures
+//  10/17/2026  AGT     notify the handshakes at the on change rate, no longer the default
+//
+// ============================================================================
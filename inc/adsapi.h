@@ -54,61 +54,103 @@ using PAdsNotificationFuncTC2                = void (*) (AmsAddr
 													                               AdsNotificationHeader   * pNotification,
 													                               unsigned long             hUser);
 
-using ProcAdsGetDllVersionTC2                = long (*) (void);
-using ProcAdsPortOpenTC2                     = long (*) (void);
-using ProcAdsPortCloseTC2                    = long (*) (void);
-using ProcAdsGetLocalAddressTC2              = long (*) (AmsAddr                 * pAddr);
-using ProcAdsSyncWriteReqTC2                 = long (*) (AmsAddr                 * pServerAddr,
-                                                         unsigned long             indexGroup,
-                                                         unsigned long             indexOffset,
-                                                         unsigned long             length,
-                                                         void                    * pData);
-using ProcAdsSyncReadWriteReqTC2             = long (*) (AmsAddr                 * pAddr,
-                                                         unsigned long             indexGroup,
-                                                         unsigned long             indexOffset,
-                                                         unsigned long             cbReadLength,
-                                                         void                    * pReadData,
-                                                         unsigned long             cbWriteLength,
-                                                         void                    * pWriteData);
-using ProcAdsSyncAddDeviceNotificationReqTC2 = long (*) (AmsAddr                 * pAddr,
-                                                         unsigned long             indexGroup,
-                                                         unsigned long             indexOffset,
-                                                         AdsNotificationAttrib   * pNoteAttrib,
-                                                         PAdsNotificationFuncTC2   pNoteFunc,
-                                                         unsigned long             hUser,
-                                                         unsigned long           * pNotification);
-using ProcAdsSyncDelDeviceNotificationReqTC2 = long (*) (AmsAddr                 * pAddr,
-                                                         unsigned long             hNotification);
+using ProcAdsGetDllVersionTC2                  = long (*) (void);
+
+// the process wide interface, a router DLL older than the port specific (Ex) interface has only this...
+
+using ProcAdsPortOpenTC2                       = long (*) (void);
+using ProcAdsPortCloseTC2                      = long (*) (void);
+using ProcAdsGetLocalAddressTC2                = long (*) (AmsAddr                 * pAddr);
+using ProcAdsSyncWriteReqTC2                   = long (*) (AmsAddr                 * pServerAddr,
+                                                           unsigned long             indexGroup,
+                                                           unsigned long             indexOffset,
+                                                           unsigned long             length,
+                                                           void                    * pData);
+using ProcAdsSyncReadWriteReqTC2               = long (*) (AmsAddr                 * pAddr,
+                                                           unsigned long             indexGroup,
+                                                           unsigned long             indexOffset,
+                                                           unsigned long             cbReadLength,
+                                                           void                    * pReadData,
+                                                           unsigned long             cbWriteLength,
+                                                           void                    * pWriteData);
+using ProcAdsSyncAddDeviceNotificationReqTC2   = long (*) (AmsAddr                 * pAddr,
+                                                           unsigned long             indexGroup,
+                                                           unsigned long             indexOffset,
+                                                           AdsNotificationAttrib   * pNoteAttrib,
+                                                           PAdsNotificationFuncTC2   pNoteFunc,
+                                                           unsigned long             hUser,
+                                                           unsigned long           * pNotification);
+using ProcAdsSyncDelDeviceNotificationReqTC2   = long (*) (AmsAddr                 * pAddr,
+                                                           unsigned long             hNotification);
+
+// the port specific interface...
+
+using ProcAdsPortOpenExTC2                     = long (*) (void);
+using ProcAdsPortCloseExTC2                    = long (*) (long                      port);
+using ProcAdsGetLocalAddressExTC2              = long (*) (long                      port,
+                                                           AmsAddr                 * pAddr);
+using ProcAdsSyncWriteReqExTC2                 = long (*) (long                      port,
+                                                           AmsAddr                 * pServerAddr,
+                                                           unsigned long             indexGroup,
+                                                           unsigned long             indexOffset,
+                                                           unsigned long             length,
+                                                           void                    * pData);
+using ProcAdsSyncReadWriteReqEx2TC2            = long (*) (long                      port,
+                                                           AmsAddr                 * pAddr,
+                                                           unsigned long             indexGroup,
+                                                           unsigned long             indexOffset,
+                                                           unsigned long             cbReadLength,
+                                                           void                    * pReadData,
+                                                           unsigned long             cbWriteLength,
+                                                           void                    * pWriteData,
+                                                           unsigned long           * pcbReturn);
+using ProcAdsSyncAddDeviceNotificationReqExTC2 = long (*) (long                      port,
+                                                           AmsAddr                 * pAddr,
+                                                           unsigned long             indexGroup,
+                                                           unsigned long             indexOffset,
+                                                           AdsNotificationAttrib   * pNoteAttrib,
+                                                           PAdsNotificationFuncTC2   pNoteFunc,
+                                                           unsigned long             hUser,
+                                                           unsigned long           * pNotification);
+using ProcAdsSyncDelDeviceNotificationReqExTC2 = long (*) (long                      port,
+                                                           AmsAddr                 * pAddr,
+                                                           unsigned long             hNotification);
 
 // TwinCAT 3 ADS Interface
 
 using PAdsNotificationFuncTC3                = PAdsNotificationFuncEx;
 
-using ProcAdsGetDllVersionTC3                = long (__stdcall *) (void);
-using ProcAdsPortOpenTC3                     = long (__stdcall *) (void);
-using ProcAdsPortCloseTC3                    = long (__stdcall *) (void);
-using ProcAdsGetLocalAddressTC3              = long (__stdcall *) (AmsAddr                 * pAddr);
-using ProcAdsSyncWriteReqTC3                 = long (__stdcall *) (AmsAddr                 * pServerAddr,
-                                                                   unsigned long             indexGroup,
-                                                                   unsigned long             indexOffset,
-                                                                   unsigned long             length,
-                                                                   void                    * pData);
-using ProcAdsSyncReadWriteReqTC3             = long (__stdcall *) (AmsAddr                 * pAddr,
-                                                                   unsigned long             indexGroup,
-                                                                   unsigned long             indexOffset,
-                                                                   unsigned long             cbReadLength,
-                                                                   void                    * pReadData,
-                                                                   unsigned long             cbWriteLength,
-                                                                   void                    * pWriteData);
-using ProcAdsSyncAddDeviceNotificationReqTC3 = long (__stdcall *) (AmsAddr                 * pAddr,
-                                                                   unsigned long             indexGroup,
-                                                                   unsigned long             indexOffset,
-                                                                   AdsNotificationAttrib   * pNoteAttrib,
-                                                                   PAdsNotificationFuncTC3   pNoteFunc,
-                                                                   unsigned long             hUser,
-                                                                   unsigned long           * pNotification);
-using ProcAdsSyncDelDeviceNotificationReqTC3 = long (__stdcall *) (AmsAddr                 * pAddr,
-                                                                   unsigned long             hNotification);
+using ProcAdsGetDllVersionTC3                  = long (__stdcall *) (void);
+using ProcAdsPortOpenExTC3                     = long (__stdcall *) (void);
+using ProcAdsPortCloseExTC3                    = long (__stdcall *) (long                      port);
+using ProcAdsGetLocalAddressExTC3              = long (__stdcall *) (long                      port,
+                                                                     AmsAddr                 * pAddr);
+using ProcAdsSyncWriteReqExTC3                 = long (__stdcall *) (long                      port,
+                                                                     AmsAddr                 * pServerAddr,
+                                                                     unsigned long             indexGroup,
+                                                                     unsigned long             indexOffset,
+                                                                     unsigned long             length,
+                                                                     void                    * pData);
+using ProcAdsSyncReadWriteReqEx2TC3            = long (__stdcall *) (long                      port,
+                                                                     AmsAddr                 * pAddr,
+                                                                     unsigned long             indexGroup,
+                                                                     unsigned long             indexOffset,
+                                                                     unsigned long             cbReadLength,
+                                                                     void                    * pReadData,
+                                                                     unsigned long             cbWriteLength,
+                                                                     void                    * pWriteData,
+                                                                     unsigned long           * pcbReturn);
+using ProcAdsSyncAddDeviceNotificationReqExTC3 = long (__stdcall *) (long                      port,
+                                                                     AmsAddr                 * pAddr,
+                                                                     unsigned long             indexGroup,
+                                                                     unsigned long             indexOffset,
+                                                                     AdsNotificationAttrib   * pNoteAttrib,
+                                                                     PAdsNotificationFuncTC3   pNoteFunc,
+                                                                     unsigned long             hUser,
+                                                                     unsigned long           * pNotification);
+using ProcAdsSyncDelDeviceNotificationReqExTC3 = long (__stdcall *) (long                      port,
+                                                                     AmsAddr                 * pAddr,
+                                                                     unsigned long             hNotification);
 
 // ============================================================================
 //  R E V I S I O N    N O T E S
@@ -126,6 +168,8 @@ using ProcAdsSyncDelDeviceNotificationReqTC3 = long (__stdcall *) (AmsAddr
 //  10/31/2005  MCC     initial revision
 //  01/09/2015  MCC     templatized number of elements macro
 //  06/06/2018  MCC     implemented support for TwinCAT 3 ADS interface
+//  10/17/2026  AGT     switched to the TwinCAT ADS port specific (Ex) interface
+//  10/17/2026  AGT     restored the TwinCAT 2 process wide interface for older router DLLs
 //
 // ============================================================================
 
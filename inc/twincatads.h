@@ -70,12 +70,94 @@ public:
 
   // Object Creation and Update Interface
 
+  enum class EWriteMode { Immediate, Combined, Asynchronous };
+
+  using CWriteFuture = std::shared_future <bool>;
+
+  struct SVirtualPLC
+  {
+    DWORD  latency;   // per request latency (microseconds)
+    DWORD  jitter;    // random additional per request latency, up to (microseconds)
+    double errorRate; // fraction of requests that fail, 0 to 1
+    long   errorCode; // ADS error returned by a failed request
+  };
+
   bool Create (void);
   bool Create (WORD analogPortNumber, WORD discretePortNumber);
+  bool Create (CString const & hostName, CString const & amsNetId); // AMS/TCP to a remote target (host or host:port) instead of the TwinCAT router, reconnected when lost
+  bool Create (CString const & hostName, CString const & amsNetId, WORD analogPortNumber, WORD discretePortNumber);
+  bool Create (SVirtualPLC const & virtualPLC); // in-process virtual PLC instead of the TwinCAT router, answers the handshakes
+  bool Create (SVirtualPLC const & virtualPLC, WORD analogPortNumber, WORD discretePortNumber);
+
+  // the asynchronous versions create the interface on a worker thread, the controller must not be
+  // used until the future is ready; independent controllers and ports are brought up concurrently
+
+  enum class ECreateStage { Connecting, ResolvingSymbols, RegisteringNotifications, ConnectingIO, WritingOutputs };
+
+  using CCreateFuture   = std::shared_future <bool>;
+  using CCreateProgress = std::function <void (ECreateStage)>;
+
+  void SetCreateProgress (CCreateProgress const & createProgress); // called from the creating thread as each stage begins
+
+  CCreateFuture CreateAsync (void);
+  CCreateFuture CreateAsync (WORD analogPortNumber, WORD discretePortNumber);
+  CCreateFuture CreateAsync (CString const & hostName, CString const & amsNetId);
+  CCreateFuture CreateAsync (CString const & hostName, CString const & amsNetId, WORD analogPortNumber, WORD discretePortNumber);
+  CCreateFuture CreateAsync (SVirtualPLC const & virtualPLC);
+  CCreateFuture CreateAsync (SVirtualPLC const & virtualPLC, WORD analogPortNumber, WORD discretePortNumber);
 
   void UpdateInputs (void);
   bool UpdateOutputs (void);
 
+  using CChangeMask = std::vector <BYTE>; // one bit per axis or program, see IsBitSet
+
+  CChangeMask const & GetChangedAxes (void) const;     // axes whose status changed in the last UpdateInputs
+  CChangeMask const & GetChangedPrograms (void) const; // programs whose status changed in the last UpdateInputs
+
+  bool SetWriteMode (EWriteMode writeMode); // combined writes are flushed by UpdateOutputs
+  CWriteFuture GetWriteFuture (void);       // completes when all prior asynchronous writes are written
+
+  // controllers on the same target port share one connection with its symbol handles and
+  // notifications; the combined writes of several controllers are sent as one sum request per
+  // connection, the other write modes are updated one controller at a time
+
+  static bool UpdateOutputs (std::vector <CTwinCATADS *> const & twinCATADS); // false if any failed, see GetErrorMessage
+
+  bool Rebind (void); // re-resolves symbol handles and notifications after a PLC online change, false if any were lost
+
+  struct SNotificationRate
+  {
+    ADSTRANSMODE transMode; // ADSTRANS_SERVERCYCLE or ADSTRANS_SERVERONCHA
+    DWORD        cycleTime; // how often the PLC samples the variable (milliseconds)
+    DWORD        maxDelay;  // longest the PLC may hold a sample back to batch it (milliseconds)
+  };
+
+  static SNotificationRate const RATE_FAST_CYCLIC; // every 10 ms (suited to actual position and velocity)
+  static SNotificationRate const RATE_ON_CHANGE;   // on change, checked every 10 ms (suited to motion and program handshakes)
+  static SNotificationRate const RATE_STATUS;      // on change, checked every 50 ms, sent within 100 ms (the default for every variable)
+
+  // the cycle time must be at least 1 ms, the cycle time and maximum delay at most ULONG_MAX / 10000 ms
+
+  bool SetNotificationRate (CString const & identifier, SNotificationRate const & notificationRate); // before Create, e.g. _T ("ActualPosition")
+
+  // the aggregated status mode registers one notification for a PLC structure in place of the
+  // eight status variables, so every sample is from the same PLC cycle; the structure is:
+  //
+  //   ControllerStatus : STRUCT
+  //     ActualPosition  : ARRAY [0..numAxes - 1] OF LREAL;
+  //     ActualVelocity  : ARRAY [0..numAxes - 1] OF LREAL;
+  //     FaultCode       : ARRAY [0..numAxes - 1] OF UDINT;
+  //     ProgramStatus   : ARRAY [0..numPrograms - 1] OF UDINT;
+  //     MotionComplete  : ARRAY [0..numAxes - 1] OF BOOL;
+  //     MotionStopped   : ARRAY [0..numAxes - 1] OF BOOL;
+  //     MotionFaulted   : ARRAY [0..numAxes - 1] OF BOOL;
+  //     ProgramComplete : ARRAY [0..numPrograms - 1] OF BOOL;
+  //   END_STRUCT
+
+  enum class EStatusMode { Separate, Aggregated };
+
+  bool SetStatusMode (EStatusMode statusMode); // before Create
+
   // Motion Control Interface
 
   using MC_Direction = ADS_INT16;
@@ -94,6 +176,21 @@ public:
   void BeginMotion (int axis);
   void StopMotion (int axis);
 
+  // synchronized start, the setpoints and BeginMotion bits of every axis are written with one sum
+  // request so they reach the PLC in the same cycle (queued for UpdateOutputs in the other write modes);
+  // each axis moves to its position, its direction is reset to MC_None
+
+  struct SAxisMove
+  {
+    int    axis;
+    double position;
+    double velocity;
+    double acceleration;
+    double deceleration;
+  };
+
+  bool BeginMotion (std::vector <SAxisMove> const & axisMoves);
+
   // General Axis Status Information
 
   bool IsMotionComplete (int axis) const;
@@ -101,6 +198,8 @@ public:
   DWORD GetFaultCode (int axis) const;
   double GetPosition (int axis) const;
   double GetVelocity (int axis) const;
+  void GetPositions (double * positions, int numAxes) const;   // the first numAxes positions with one call
+  void GetVelocities (double * velocities, int numAxes) const; // the first numAxes velocities with one call
 
   static DWORD const DRIVE_STATUS_OK;
 
@@ -120,6 +219,70 @@ public:
   static DWORD const PROGRAM_NO_FAULT;
   static DWORD const PROGRAM_STOPPED_FAULT;
 
+  // Completion Wait Interface, these run UpdateInputs and UpdateOutputs until the condition is met,
+  // sleeping until the next notification in between; call them from the thread that runs the update
+  // loop, a faulted axis or program completes so check IsMotionFaulted or GetProgramStatus afterwards
+
+  bool WaitForMotionComplete (int axis, DWORD timeout = INFINITE);
+  bool WaitForProgramComplete (int identifier, DWORD timeout = INFINITE);
+  bool WaitForAny (std::vector <int> const & axes, std::vector <int> const & programs, DWORD timeout = INFINITE);
+  bool WaitForAll (std::vector <int> const & axes, std::vector <int> const & programs, DWORD timeout = INFINITE);
+
+  // Event Interface, handlers are called on the notification thread (the update thread in
+  // simulation) as soon as a sample shows the event, so they must be brief and thread safe;
+  // subscribe before Create, the first sample of each variable only sets the baseline
+
+  enum class EAxisEvent { MotionComplete, MotionStopped, MotionFaulted, PositionCrossed };
+  enum class EProgramEvent { ProgramComplete, StatusChanged };
+
+  using CAxisEventHandler    = std::function <void (int axis, EAxisEvent axisEvent)>;
+  using CProgramEventHandler = std::function <void (int identifier, EProgramEvent programEvent, DWORD programStatus)>;
+
+  bool Subscribe (CAxisEventHandler const & axisEventHandler);
+  bool Subscribe (CProgramEventHandler const & programEventHandler);
+  void SetPositionThreshold (int axis, double position); // PositionCrossed when the actual position reaches it from either side
+  void ClrPositionThreshold (int axis);
+
+  // Notification Latency Interface, PLC time stamps are mapped onto the host steady clock; for a
+  // remote target the offset between its clock and ours is part of the latency
+
+  enum { NUM_LATENCY_BUCKETS = 24 }; // bucket 0 is under 1 us, bucket i is 2^(i-1) up to 2^i us, the last is open ended
+
+  using CLatencyHistogram = std::array <ULONG, NUM_LATENCY_BUCKETS>;
+
+  bool GetLatencyHistogram (CString const & identifier, CLatencyHistogram & latencyHistogram) const; // e.g. _T ("ActualPosition")
+  void ClrLatencyHistograms (void);
+  bool GetSampleTime (CString const & identifier, std::chrono::steady_clock::time_point & sampleTime) const; // PLC time of the sample UpdateInputs took
+
+  // Motion Segment Queue Interface, segments are streamed into a ring buffer per axis that the PLC
+  // program runs back to back; UpdateOutputs tops the ring up as the PLC reports segments consumed
+  // and StopMotion drops the segments the host still holds; enable before Create, the PLC declares:
+  //
+  //   MotionSegment : STRUCT
+  //     Position     : LREAL;
+  //     Velocity     : LREAL;
+  //     Acceleration : LREAL;
+  //     Deceleration : LREAL;
+  //   END_STRUCT
+  //
+  //   SegmentBuffer  : ARRAY [0..numAxes - 1, 0..SEGMENT_QUEUE_DEPTH - 1] OF MotionSegment;
+  //   SegmentWritten : ARRAY [0..numAxes - 1] OF UDINT; (segments written by the host, wrapping)
+  //   SegmentRead    : ARRAY [0..numAxes - 1] OF UDINT; (segments consumed by the PLC, wrapping)
+
+  enum { SEGMENT_QUEUE_DEPTH = 16 };
+
+  struct SMotionSegment
+  {
+    double position;
+    double velocity;
+    double acceleration;
+    double deceleration;
+  };
+
+  bool SetSegmentQueue (bool isEnabled); // before Create
+  bool QueueSegments (int axis, std::vector <SMotionSegment> const & segments);
+  size_t GetQueuedSegments (int axis) const; // held by the host or the PLC and not yet consumed, 0 for an invalid axis
+
   // Diagnostic Interface
 
   CString GetErrorMessage (void) const;
@@ -137,6 +300,7 @@ public:
 private:
   class CSimAxis;
   class CSimProg;
+  class CAsyncWriter;
 
   using MC_Bool  = ADS_UINT8;
   using MC_Byte  = ADS_UINT8;
@@ -148,7 +312,138 @@ private:
   using CSimAxisPtr = std::shared_ptr <CSimAxis>;
   using CSimProgPtr = std::shared_ptr <CSimProg>;
 
+  // handshake requests, [0] is requested and [1] is what the PLC was last sent...
+
+  using CRequest = std::array <std::vector <MC_Bool>, 2>;
+
+  // notified variables are triple buffered, the notification thread publishes complete samples
+  // and the control thread takes the newest one in UpdateInputs, neither side waits on the other
+  // for longer than a copy;
+  // a fourth slot keeps the sample the control thread replaced so changes are found without a copy;
+  // [0] is the control thread copy and [1] is the staging copy written by the simulation...
+
+  template <typename T> class CTripleBuffer final
+  {
+  public:
+    CTripleBuffer (void) : m_timeStamp {}, m_front (0), m_previous (1), m_middle (2), m_back (3), m_publishCount (0), m_dispatchCount (0) { m_publishGate.clear (); }
+
+    void Alloc (typename std::vector <T>::size_type size, T const & initValue)
+      {
+        for (auto&& l_buffer : m_buffer)
+          {
+            l_buffer.assign (size, initValue);
+          }
+
+        m_staging.assign (size, initValue);
+      }
+
+    size_t size (void) const { return m_staging.size (); }
+
+    std::vector <T> & operator [] (size_t index) { return (index == 0) ? m_buffer[m_front] : m_staging; }
+    std::vector <T> const & operator [] (size_t index) const { return (index == 0) ? m_buffer[m_front] : m_staging; }
+    std::vector <T> const & previous (void) const { return m_buffer[m_previous]; } // valid after Acquire returns true
+    LONGLONG timeStamp (void) const { return m_timeStamp[m_front]; }                 // PLC time of [0], 0 before the first sample
+
+    template <typename F> void Publish (T const * pData, LONGLONG timeStamp, F && onPublish)
+      {
+        // publishers seldom overlap (a replayed sample racing a live one), the spin only orders them
+        // and is never taken by the control thread...
+
+        while (m_publishGate.test_and_set (std::memory_order_acquire))
+          {
+            std::this_thread::yield ();
+          }
+
+        std::copy (pData, pData + m_staging.size (), m_buffer[m_back].begin ());
+
+        m_timeStamp[m_back] = timeStamp;
+
+        m_back = m_middle.exchange (m_back | FRESH, std::memory_order_acq_rel) & INDEX;
+
+        auto const l_publishCount (m_publishCount++);
+
+        m_publishGate.clear (std::memory_order_release);
+
+        // the handlers run outside the gate, so they never hold up the control thread, and are taken
+        // in turn so their events stay in publishing order...
+
+        {
+          std::unique_lock <std::mutex> l_dispatchGate { m_dispatchGate };
+
+          m_dispatchCondition.wait (l_dispatchGate, [this, l_publishCount] { return m_dispatchCount == l_publishCount; });
+
+          onPublish ();
+
+          ++m_dispatchCount;
+        }
+
+        m_dispatchCondition.notify_all ();
+      }
+
+    template <typename F> void Modify (F && modify)
+      {
+        // every slot is changed, a sample published before the change and acquired after it would
+        // otherwise undo it; the gate keeps the publisher out of the back buffer meanwhile...
+
+        while (m_publishGate.test_and_set (std::memory_order_acquire))
+          {
+            std::this_thread::yield ();
+          }
+
+        for (auto&& l_buffer : m_buffer)
+          {
+            modify (l_buffer);
+          }
+
+        modify (m_staging);
+
+        m_publishGate.clear (std::memory_order_release);
+      }
+
+    bool Acquire (void)
+      {
+        if ((m_middle.load (std::memory_order_acquire) & FRESH) == 0)
+          {
+            return false;
+          }
+
+        auto const l_front (m_middle.exchange (m_previous, std::memory_order_acq_rel) & INDEX);
+
+        m_previous = m_front;
+        m_front    = l_front;
+
+        return true;
+      }
+
+  private:
+    enum : unsigned { INDEX = 0x3, FRESH = 0x4 };
+
+    std::array <std::vector <T>, 4> m_buffer;
+    std::array <LONGLONG, 4> m_timeStamp;
+    std::vector <T> m_staging;
+    unsigned m_front;
+    unsigned m_previous;
+    std::atomic <unsigned> m_middle;
+    unsigned m_back;
+    std::atomic_flag m_publishGate;
+    ULONGLONG m_publishCount;
+    ULONGLONG m_dispatchCount;
+    std::mutex m_dispatchGate;
+    std::condition_variable m_dispatchCondition;
+
+  public:
+    // copy construction and assignment not allowed for this class
+
+    CTripleBuffer (CTripleBuffer const &) = delete;
+    CTripleBuffer & operator = (CTripleBuffer const &) = delete;
+  };
+
   CString const m_controllerId;
+  CString m_hostName;
+  CString m_amsNetId;
+  std::unique_ptr <SVirtualPLC> m_virtualPLC;
+  CCreateProgress m_createProgress;
+  CCreateFuture m_createFuture;
 
   std::vector <MC_LReal> m_acceleration;
   std::vector <MC_LReal> m_deceleration;
@@ -159,48 +454,78 @@ private:
   std::vector <MC_Bool> m_stopProgram;
   std::vector <CSimAxisPtr> m_simAxis;
   std::vector <CSimProgPtr> m_simProg;
-  std::vector <std::vector <MC_Bool> > m_beginMotion;
-  std::vector <std::vector <MC_Bool> > m_stopMotion;
-  std::vector <std::vector <MC_Bool> > m_motionComplete;
-  std::vector <std::vector <MC_Bool> > m_motionStopped;
-  std::vector <std::vector <MC_Bool> > m_motionFaulted;
-  std::vector <std::vector <MC_Bool> > m_runProgram;
-  std::vector <std::vector <MC_Bool> > m_programComplete;
-  std::vector <std::vector <MC_UDInt> > m_faultCode;
-  std::vector <std::vector <MC_UDInt> > m_programStatus;
-  std::vector <std::vector <MC_LReal> > m_actualPosition;
-  std::vector <std::vector <MC_LReal> > m_actualVelocity;
-  std::vector <MC_Byte> m_analogInputs;
-  std::vector <MC_Byte> m_discreteInputs;
+  CRequest m_beginMotion;
+  CRequest m_stopMotion;
+  CTripleBuffer <MC_Bool> m_motionComplete;
+  CTripleBuffer <MC_Bool> m_motionStopped;
+  CTripleBuffer <MC_Bool> m_motionFaulted;
+  CRequest m_runProgram;
+  CTripleBuffer <MC_Bool> m_programComplete;
+  CTripleBuffer <MC_UDInt> m_faultCode;
+  CTripleBuffer <MC_UDInt> m_programStatus;
+  CTripleBuffer <MC_LReal> m_actualPosition;
+  CTripleBuffer <MC_LReal> m_actualVelocity;
+  CTripleBuffer <MC_Byte> m_controllerStatus;
+  CTripleBuffer <MC_Byte> m_analogInputs;
+  CTripleBuffer <MC_Byte> m_discreteInputs;
+  CTripleBuffer <MC_UDInt> m_segmentRead;
+  std::vector <MC_LReal> m_segmentBuffer;
+  std::vector <MC_UDInt> m_segmentWritten;
+  std::vector <std::deque <SMotionSegment>> m_segmentQueue;
+  CChangeMask m_changedAxes;
+  CChangeMask m_changedPrograms;
   std::vector <MC_Byte> m_analogOutputs;
   std::vector <MC_Byte> m_discreteOutputs;
 
   std::vector <std::shared_ptr <ITwinCATADS>> m_twinCATADS;
-  std::mutex m_notificationGate;
   mutable CString m_errorMessage;
 
-  static CString const VAR_ACCELERATION;
-  static CString const VAR_DECELERATION;
-  static CString const VAR_JERK;
-  static CString const VAR_POSITION;
-  static CString const VAR_VELOCITY;
-  static CString const VAR_DIRECTION;
-  static CString const VAR_BEGINMOTION;
-  static CString const VAR_STOPMOTION;
-  static CString const VAR_MOTIONCOMPLETE;
-  static CString const VAR_MOTIONSTOPPED;
-  static CString const VAR_MOTIONFAULTED;
-  static CString const VAR_RUNPROGRAM;
-  static CString const VAR_STOPPROGRAM;
-  static CString const VAR_PROGRAMCOMPLETE;
-  static CString const VAR_FAULTCODE;
-  static CString const VAR_PROGRAMSTATUS;
-  static CString const VAR_ACTUALPOSITION;
-  static CString const VAR_ACTUALVELOCITY;
-  static CString const VAR_ANALOGINPUTS;
-  static CString const VAR_ANALOGOUTPUTS;
-  static CString const VAR_DISCRETEINPUTS;
-  static CString const VAR_DISCRETEOUTPUTS;
+  using CPendingVariable = std::vector <std::tuple <int, std::vector <MC_Byte>>>;
+
+  EWriteMode m_writeMode;
+  EStatusMode m_statusMode;
+  bool m_isSegmentQueue;
+  CPendingVariable m_pendingVariable;
+  std::unique_ptr <CAsyncWriter> m_asyncWriter;
+  ULONGLONG m_symbolVersionTick;
+  std::atomic <ULONG> m_notificationCount;
+  std::atomic <int> m_waiterCount;
+  std::mutex m_waitGate;
+  std::condition_variable m_waitCondition;
+  std::vector <CAxisEventHandler> m_axisEventHandler;
+  std::vector <CProgramEventHandler> m_programEventHandler;
+  std::vector <std::atomic <double> > m_positionThreshold;
+
+  enum ESymbol
+  {
+    VAR_ACCELERATION,
+    VAR_DECELERATION,
+    VAR_JERK,
+    VAR_POSITION,
+    VAR_VELOCITY,
+    VAR_DIRECTION,
+    VAR_BEGINMOTION,
+    VAR_STOPMOTION,
+    VAR_MOTIONCOMPLETE,
+    VAR_MOTIONSTOPPED,
+    VAR_MOTIONFAULTED,
+    VAR_RUNPROGRAM,
+    VAR_STOPPROGRAM,
+    VAR_PROGRAMCOMPLETE,
+    VAR_FAULTCODE,
+    VAR_PROGRAMSTATUS,
+    VAR_ACTUALPOSITION,
+    VAR_ACTUALVELOCITY,
+    VAR_CONTROLLERSTATUS,
+    VAR_SEGMENTBUFFER,
+    VAR_SEGMENTWRITTEN,
+    VAR_SEGMENTREAD,
+    VAR_ANALOGINPUTS,
+    VAR_ANALOGOUTPUTS,
+    VAR_DISCRETEINPUTS,
+    VAR_DISCRETEOUTPUTS,
+    NUM_SYMBOLS
+  };
 
   static MC_Bool const MC_False;
   static MC_Bool const MC_True;
@@ -211,52 +536,107 @@ private:
   static MC_UDInt const AXIS_NO_FAULT;
   static MC_UDInt const AXIS_STOPPED_FAULT;
 
+  static ULONGLONG const SYMBOL_VERSION_INTERVAL;
+  static ULONGLONG const WAIT_POLL_INTERVAL;
+  static size_t const HANDSHAKE_LANES; // handshake elements evaluated per SSE2 register
+  static size_t const SEGMENT_FIELDS;  // LREAL fields per motion segment
+
   static std::array <CString, 268> const m_programStatusMessage;
   static std::map <DWORD, CString> const m_adsErrorMessage;
 
   enum class EADSInstance { PLC, AIO, DIO };
 
+  static SNotificationRate const RATE_NONE;
+  static DWORD const TICKS_PER_MILLISECOND;
+
+  static std::array <std::tuple <EADSInstance, CString, SNotificationRate>, NUM_SYMBOLS> const m_symbolIdentifier;
+
+  std::array <CString, NUM_SYMBOLS> m_symbolName;
+  std::array <int, NUM_SYMBOLS> m_symbol;
+  std::array <SNotificationRate, NUM_SYMBOLS> m_notificationRate;
+  std::array <std::vector <MC_Byte>, NUM_SYMBOLS> m_eventSample;
+  std::array <std::vector <MC_Byte>, NUM_SYMBOLS> m_writtenValue; // last setpoints the PLC accepted
+  std::vector <ULONG> m_rebindCount;                              // of each connection when the written values were last checked
+  std::array <std::array <std::atomic <ULONG>, NUM_LATENCY_BUCKETS>, NUM_SYMBOLS> m_latencyHistogram;
+
   bool Create_ (WORD analogPortNumber = 0, WORD discretePortNumber = 0);
 
-  template <typename T> bool Create (WORD portNumber);
-
-  bool UpdateOutputs (CString                              const & identifier,
-                      std::vector <std::vector <MC_Bool> >       & reqVariable);
-  bool UpdateOutputs (CString                              const & identifier,
-                      std::vector <std::vector <MC_Bool> >       & reqVariable,
-                      std::vector <std::vector <MC_Bool> > const & ackVariable);
-  bool UpdateOutputs_ (CString                              const & identifier,
-                       std::vector <std::vector <MC_Bool> >       & reqVariable,
-                       std::vector <std::vector <MC_Bool> > const & ackVariable);
-
-  template <typename T> void AllocInputs (         std::vector <std::vector <T> >       & buffer,
-                                          typename std::vector <T>::size_type             size,
-                                                   T                              const & initValue = T ());
-  template <typename T> void AllocInputs (         std::vector <std::vector <T> >       & buffer,
-                                          typename std::vector <T>::size_type             size,
-                                                   T                              const & initValue1,
-                                                   T                              const & initValue2);
-  template <typename T> void UpdateInputs (std::vector <std::vector <T> > & buffer);
-  template <typename T, typename U> void UpdateInputs (std::vector <T> const & src, U * dst)
-    { XShim <U, T>::copy (src, dst); }
-
-  template <typename T, typename U> bool RegisterNotification (EADSInstance            adsInstance,
-                                                               CString         const & identifier,
-                                                               std::vector <T> const & variable,
-                                                               U                       pNoteFunc);
-  template <typename T, typename U> bool RegisterNotification (EADSInstance                           adsInstance,
-                                                               CString                        const & identifier,
-                                                               std::vector <std::vector <T> > const & variable,
-                                                               U                                      pNoteFunc)
-    { return RegisterNotification (adsInstance, identifier, variable[0], pNoteFunc); }
-
-  template <typename T> bool SetVariable_ (EADSInstance adsInstance, CString const & identifier, std::vector <T> & value, int index, T value_);
-  template <typename T> bool SetVariable_ (EADSInstance adsInstance, CString const & identifier, T const & value);
-  template <typename T> bool SetVariable_ (EADSInstance adsInstance, CString const & identifier, std::vector <T> const & value);
-  template <typename T, typename U> bool SetVariable_ (EADSInstance adsInstance, CString const & identifier, std::vector <T> & dst, U const * src)
-    { return !XShim <U, T>::assign (dst, src) || SetVariable_ (adsInstance, identifier, dst); }
-
-  template <typename T> void CopyVariable (AdsNotificationHeader * pNotification, std::vector <T> & variable);
+  template <typename T, typename... Args> bool Create_ (WORD analogPortNumber, WORD discretePortNumber, Args const & ... args);
+
+  template <typename T, typename... Args> bool Create (WORD portNumber, Args const & ... args);
+
+  template <typename T, typename... Args> bool CreateIO (WORD analogPortNumber, WORD discretePortNumber, Args const & ... args);
+
+  template <typename F> CCreateFuture CreateAsync_ (F && create);
+
+  void ReportProgress (ECreateStage createStage) const;
+
+  bool UpdateOutputs (ESymbol                         symbol,
+                      CRequest                      & reqVariable);
+  bool UpdateOutputs (ESymbol                         symbol,
+                      CRequest                      & reqVariable,
+                      CTripleBuffer <MC_Bool> const & ackVariable);
+  bool UpdateOutputs_ (ESymbol                         symbol,
+                       CRequest                      & reqVariable,
+                       CTripleBuffer <MC_Bool> const & ackVariable);
+
+  void AllocInputs (CRequest                            & buffer,
+                    std::vector <MC_Bool>::size_type      size,
+                    MC_Bool                               initValue1,
+                    MC_Bool                               initValue2);
+  template <typename T> void AllocInputs (         CTripleBuffer <T>              & buffer,
+                                          typename std::vector <T>::size_type     size,
+                                                   T                      const & initValue = T ())
+    { buffer.Alloc (size, initValue); }
+  template <typename T, typename U> void UpdateInputs (CTripleBuffer <T> & src, U * dst)
+    { src.Acquire (); XShim <U, T>::copy (src[0], dst); }
+
+  using CNotification = std::tuple <ESymbol, size_t, void *>;
+
+  template <typename T, typename U> static CNotification Notification (ESymbol                   symbol,
+                                                                       CTripleBuffer <T> const & variable,
+                                                                       U                         pNoteFunc)
+    { return CNotification (symbol, variable.size () * sizeof (T), reinterpret_cast <void *> (pNoteFunc)); }
+
+  bool RegisterNotification (EADSInstance adsInstance, std::vector <CNotification> const & notifications);
+  bool RegisterStatusNotification (bool isTC3);
+
+  bool UpdateSegments (void);
+
+  template <typename F> bool WriteCombined (F && write);
+
+  template <typename T> static void AcquireInputs (CTripleBuffer <T> & variable, CChangeMask & changeMask);
+  template <typename T> static void Unpack (CTripleBuffer <T> & variable, MC_Byte const * & pData, CChangeMask & changeMask);
+
+  template <typename T> bool SetVariable_ (ESymbol symbol, std::vector <T> & value, int index, T value_);
+  template <typename T> bool SetVariable_ (ESymbol symbol, std::vector <T> const & value);
+  template <typename T, typename U> bool SetVariable_ (ESymbol symbol, std::vector <T> & dst, U const * src)
+    { return !XShim <U, T>::assign (dst, src) || SetVariable_ (symbol, dst); }
+  template <typename T> bool SetVariable_ (CString const & identifier, T const & value);
+  template <typename T> bool SetVariable_ (CString const & identifier, std::vector <T> const & value);
+  bool SetVariable_ (CString const & identifier, size_t cbLength, void const * pData);
+  bool SetVariable_ (EADSInstance adsInstance, int symbol, size_t cbLength, void const * pData);
+  bool SetElement_ (ESymbol symbol, size_t offset, size_t cbLength, void const * pData, bool & isWritten);
+  void ClrWrittenValues (void);
+  void CheckRebindCount (void);
+  void CommitPendingVariables (void);
+  int FindSymbol (int symbol) const; // the controller symbol written as PLC symbol, -1 for a program variable
+  bool IsWriteQueued (EADSInstance adsInstance) const { return (m_writeMode != EWriteMode::Immediate) && (adsInstance == EADSInstance::PLC); }
+
+  static void QueueVariable (CPendingVariable & pendingVariable, int symbol, size_t cbLength, void const * pData);
+  bool FlushVariables (void);
+
+  template <typename T> void CopyVariable (AdsNotificationHeader * pNotification, ESymbol symbol, CTripleBuffer <T> & variable);
+  template <typename T> void Publish (ESymbol symbol, CTripleBuffer <T> & variable, T const * pData, LONGLONG timeStamp);
+
+  int GetNotificationSymbol (CString const & identifier) const;
+  LONGLONG GetTimeStamp (ESymbol symbol) const;
+  void RecordLatency (ESymbol symbol, LONGLONG timeStamp);
+
+  void DispatchEvents (ESymbol symbol, MC_Byte const * pData, size_t cbData);
+  template <typename T, typename F> static void DispatchEvents (std::vector <MC_Byte> const & previous, MC_Byte const * pData, size_t cbData, F && onElement);
+
+  template <typename F> bool Wait (F && isComplete, DWORD timeout, CString const & description);
 
   template <typename T, typename U = MC_Byte> struct XShim
   {
@@ -284,32 +664,33 @@ private:
     inline static auto end (T const * t) { return begin (t) + size; }
   };
 
+  void AddSymbols (EADSInstance adsInstance);
+  bool IsSymbolUsed (int symbol) const;
+  static bool IsSetpoint (int symbol); // written by address when the target reports one
+  void CheckSymbolVersion (void);
+
   CString GetSymbolName (EADSInstance adsInstance, CString const & identifier) const;
 
-#define ADSNOTIFICATION1(handler, memberData) \
-  friend static void handler##TC2 (AmsAddr *, AdsNotificationHeader * pNotification, unsigned long hUser) \
-    { reinterpret_cast <CTwinCATADS *> (hUser)->CopyVariable (pNotification, reinterpret_cast <CTwinCATADS *> (hUser)->memberData); } \
-  friend static void __stdcall handler##TC3 (AmsAddr *, AdsNotificationHeader * pNotification, unsigned long hUser) \
-    { reinterpret_cast <CTwinCATADS *> (hUser)->CopyVariable (pNotification, reinterpret_cast <CTwinCATADS *> (hUser)->memberData); }
-#define ADSNOTIFICATION2(handler, memberData) \
+#define ADSNOTIFICATION(handler, symbol, memberData) \
   friend static void handler##TC2 (AmsAddr *, AdsNotificationHeader * pNotification, unsigned long hUser) \
-    { reinterpret_cast <CTwinCATADS *> (hUser)->CopyVariable (pNotification, reinterpret_cast <CTwinCATADS *> (hUser)->memberData[1]); } \
+    { reinterpret_cast <CTwinCATADS *> (hUser)->CopyVariable (pNotification, symbol, reinterpret_cast <CTwinCATADS *> (hUser)->memberData); } \
   friend static void __stdcall handler##TC3 (AmsAddr *, AdsNotificationHeader * pNotification, unsigned long hUser) \
-    { reinterpret_cast <CTwinCATADS *> (hUser)->CopyVariable (pNotification, reinterpret_cast <CTwinCATADS *> (hUser)->memberData[1]); }
-
-  ADSNOTIFICATION2 (OnActualPosition, m_actualPosition)
-  ADSNOTIFICATION2 (OnActualVelocity, m_actualVelocity)
-  ADSNOTIFICATION2 (OnMotionComplete, m_motionComplete)
-  ADSNOTIFICATION2 (OnMotionStopped, m_motionStopped)
-  ADSNOTIFICATION2 (OnMotionFaulted, m_motionFaulted)
-  ADSNOTIFICATION2 (OnFaultCode, m_faultCode)
-  ADSNOTIFICATION2 (OnProgramComplete, m_programComplete)
-  ADSNOTIFICATION2 (OnProgramStatus, m_programStatus)
-  ADSNOTIFICATION1 (OnAnalogInputs, m_analogInputs)
-  ADSNOTIFICATION1 (OnDiscreteInputs, m_discreteInputs)
-
-#undef ADSNOTIFICATION1
-#undef ADSNOTIFICATION2
+    { reinterpret_cast <CTwinCATADS *> (hUser)->CopyVariable (pNotification, symbol, reinterpret_cast <CTwinCATADS *> (hUser)->memberData); }
+
+  ADSNOTIFICATION (OnActualPosition, VAR_ACTUALPOSITION, m_actualPosition)
+  ADSNOTIFICATION (OnActualVelocity, VAR_ACTUALVELOCITY, m_actualVelocity)
+  ADSNOTIFICATION (OnMotionComplete, VAR_MOTIONCOMPLETE, m_motionComplete)
+  ADSNOTIFICATION (OnMotionStopped, VAR_MOTIONSTOPPED, m_motionStopped)
+  ADSNOTIFICATION (OnMotionFaulted, VAR_MOTIONFAULTED, m_motionFaulted)
+  ADSNOTIFICATION (OnFaultCode, VAR_FAULTCODE, m_faultCode)
+  ADSNOTIFICATION (OnProgramComplete, VAR_PROGRAMCOMPLETE, m_programComplete)
+  ADSNOTIFICATION (OnProgramStatus, VAR_PROGRAMSTATUS, m_programStatus)
+  ADSNOTIFICATION (OnControllerStatus, VAR_CONTROLLERSTATUS, m_controllerStatus)
+  ADSNOTIFICATION (OnSegmentRead, VAR_SEGMENTREAD, m_segmentRead)
+  ADSNOTIFICATION (OnAnalogInputs, VAR_ANALOGINPUTS, m_analogInputs)
+  ADSNOTIFICATION (OnDiscreteInputs, VAR_DISCRETEINPUTS, m_discreteInputs)
+
+#undef ADSNOTIFICATION
 
 public:
   // copy construction and assignment not allowed for this class
@@ -365,6 +746,35 @@ public:
 //  08/23/2018  MCC     modified to log version of loaded TwinCAT module
 //  08/24/2018  MCC     made TwinCAT ADS controller identifier constant
 //  10/24/2018  MCC     updated TwinCAT ADS program status message table
+//  10/17/2026  AGT     implemented TwinCAT ADS write combining mode
+//  10/17/2026  AGT     acquire TwinCAT ADS symbol handles with one sum request
+//  10/17/2026  AGT     register and delete TwinCAT ADS notifications with sum requests
+//  10/17/2026  AGT     implemented TwinCAT ADS asynchronous write mode
+//  10/17/2026  AGT     intern TwinCAT ADS symbols in an indexed table
+//  10/17/2026  AGT     rebind TwinCAT ADS symbols after a PLC online change
+//  10/17/2026  AGT     added native AMS/TCP TwinCAT ADS backend
+//  10/17/2026  AGT     added in-process virtual PLC TwinCAT ADS backend
+//  10/17/2026  AGT     implemented per-variable TwinCAT ADS notification rates
+//  10/17/2026  AGT     implemented wait-free TwinCAT ADS notification ingestion
+//  10/17/2026  AGT     added aggregated TwinCAT ADS controller status notification
+//  10/17/2026  AGT     report the axes and programs changed by UpdateInputs
+//  10/17/2026  AGT     added notification driven motion and program completion waits
+//  10/17/2026  AGT     added axis and program event subscriptions
+//  10/17/2026  AGT     keep PLC time stamps and record TwinCAT ADS notification latency
+//  10/17/2026  AGT     share TwinCAT ADS connections between controllers on one port
+//  10/17/2026  AGT     added asynchronous TwinCAT ADS creation with progress
+//  10/17/2026  AGT     added compile-time sized TwinCAT ADS controller
+//  10/17/2026  AGT     evaluate TwinCAT ADS handshakes sixteen axes at a time
+//  10/17/2026  AGT     added synchronized multi-axis motion start
+//  10/17/2026  AGT     added host-queued motion segment streaming
+//  10/17/2026  AGT     skip unchanged setpoints and write single elements by address
+//  10/17/2026  AGT     forget written setpoints on any rebind of a shared connection
+//  10/17/2026  AGT     keep the written setpoints current on whole array writes
+//  10/17/2026  AGT     a new request clears the motion fault in every triple buffer slot
+//  10/17/2026  AGT     dispatch events after the triple buffer publisher gate is left
+//  10/17/2026  AGT     a synchronized move resets the direction of its axes
+//  10/17/2026  AGT     write only the setpoint arrays by address
+//  10/17/2026  AGT     removed the compile-time sized controller, it only forwarded to this class
 //
 // ============================================================================
 
@@ -52,6 +52,59 @@
 static char THIS_FILE[] = __FILE__;
 #endif
 
+namespace
+{
+  // the host clock as a FILETIME (100 ns units since 1601) with the resolution of the steady clock,
+  // GetSystemTimeAsFileTime only advances once per clock interrupt and the precise variant needs
+  // Windows 8; the two clocks are matched once, on an edge of the system time...
+
+  using CFileTimeDuration = std::chrono::duration <LONGLONG, std::ratio <1, 10000000> >;
+
+  struct SHostClock
+  {
+    LONGLONG                              fileTime;
+    std::chrono::steady_clock::time_point steadyTime;
+  };
+
+  SHostClock const &
+  GetHostClock (void)
+  {
+    static SHostClock const l_hostClock ([]
+                                         {
+                                           FILETIME l_start;
+                                           FILETIME l_fileTime;
+
+                                           ::GetSystemTimeAsFileTime (&l_start);
+
+                                           do
+                                             {
+                                               ::GetSystemTimeAsFileTime (&l_fileTime);
+                                             }
+                                           while ((l_fileTime.dwLowDateTime == l_start.dwLowDateTime) && (l_fileTime.dwHighDateTime == l_start.dwHighDateTime));
+
+                                           return SHostClock { (static_cast <LONGLONG> (l_fileTime.dwHighDateTime) << 32) | static_cast <LONGLONG> (l_fileTime.dwLowDateTime), std::chrono::steady_clock::now () };
+                                         } ());
+
+    return l_hostClock;
+  }
+
+  LONGLONG
+  GetHostFileTime (void)
+  {
+    auto const & l_hostClock (GetHostClock ());
+
+    return l_hostClock.fileTime + std::chrono::duration_cast <CFileTimeDuration> (std::chrono::steady_clock::now () - l_hostClock.steadyTime).count ();
+  }
+
+  std::chrono::steady_clock::time_point
+  GetSteadyTime (LONGLONG fileTime)
+  {
+    auto const & l_hostClock (GetHostClock ());
+
+    return l_hostClock.steadyTime + std::chrono::duration_cast <std::chrono::steady_clock::duration> (CFileTimeDuration (fileTime - l_hostClock.fileTime));
+  }
+}
+
 class ITwinCATADS
 {
 public:
@@ -59,11 +112,31 @@ public:
 
   virtual void Create (WORD portNumber) = 0;
 
-  void SetVariable (CString const & symbolName, size_t cbLength, void const * pData);
-  void RegisterNotification (CString const & symbolName, size_t cbLength, void * pNoteFunc, void * hUser);
+  using CVariable     = std::tuple <int, size_t, void const *>;
+  using CNotification = std::tuple <int, AdsNotificationAttrib, void *>;
+
+  void SetVariable (int symbol, size_t cbLength, void const * pData);
+  void SetVariable (std::vector <CVariable> const & variables);
+  void RegisterNotification (std::vector <CNotification> const & notifications, void * hUser);
+  void UnRegisterNotification (void * hUser);
+
+  int AddSymbol (CString const & symbolName);
+  ULONG GetHandle (int symbol);
+  void GetHandles (std::vector <int> const & symbols);
+  ULONG GetSymbolSize (int symbol);
+  void ResolveAddresses (std::vector <int> const & symbols);
+  bool SetElement (int symbol, size_t offset, size_t cbLength, void const * pData); // false if the symbol has no address
+
+  void WatchSymbolVersion (void); // an online change is reported by notification, polled if the target cannot notify
+  bool CheckSymbolVersion (void);
+  CString Rebind (void); // the first failure, empty when every handle and notification was restored
+  bool IsRebindPending (void) const { return m_isRebindPending; }
+  ULONG GetRebindCount (void) const { return m_rebindCount; } // the owners of a shared connection compare it with their own copy
 
   static HMODULE GetModuleHandle (void) { return m_hModule; }
 
+  template <typename T, typename... Args> static std::shared_ptr <ITwinCATADS> Connect (WORD portNumber, Args const & ... args);
+
 protected:
   explicit ITwinCATADS (void);
 
@@ -71,11 +144,32 @@ protected:
   using CProcAds       = std::tuple <LPVOID *, CString>;
   using CAdsApi        = std::vector <CProcAds>;
 
+  struct SNotificationReq
+  {
+    int                   symbol;
+    ULONG                 indexGroup;    // ADSIGRP_SYM_VALBYHND unless the notification is not on a symbol
+    ULONG                 hSymbol;
+    AdsNotificationAttrib adsNotificationAttrib;
+    void                * pNoteFunc;
+    unsigned long         hUser;
+    ULONG                 hNotification;
+    long                  result;
+  };
+
   void Create (CString        const & adsDllFilename,
                CAdsDllVersion const & adsDllVersion,
                CAdsApi        const & adsApi,
-               WORD                   portNumber);
+               WORD                   portNumber,
+               CAdsApi        const & optionalAdsApi = CAdsApi ()); // resolved all or none, missing entries are left null
+  void Open (WORD portNumber);
   void Destroy (void);
+  void SetRebindPending (void) { m_isRebindPending = true; } // the owner rebinds on its next update
+
+  // a callback the backend dispatches itself is announced while the gate that guards the callback is
+  // held, so that UnRegisterNotification can wait for it once the callback is removed...
+
+  void BeginDispatch (unsigned long hUser);
+  void EndDispatch (unsigned long hUser);
 
   virtual long SyncWriteReq (AmsAddr       & amsAddr,
                              unsigned long   indexGroup,
@@ -83,11 +177,14 @@ protected:
                              unsigned long   length,
                              void          * pData) = 0;
   virtual long SyncReadWriteReq (AmsAddr       & amsAddr,
+                                 unsigned long   indexGroup,
+                                 unsigned long   indexOffset,
                                  unsigned long   cbReadLength,
                                  void          * pReadData,
                                  unsigned long   cbWriteLength,
                                  void          * pWriteData) = 0;
   virtual long SyncAddDeviceNotificationReq (AmsAddr               & amsAddr,
+                                             unsigned long           indexGroup,
                                              unsigned long           indexOffset,
                                              AdsNotificationAttrib * adsNotificationAttrib,
                                              void                  * pNoteFunc,
@@ -95,22 +192,106 @@ protected:
                                              unsigned long         * pNotification) = 0;
   virtual long SyncDelDeviceNotificationReq (AmsAddr       & amsAddr,
                                              unsigned long   hNotification) = 0;
+  virtual long SumAddDeviceNotificationReq (AmsAddr                        & amsAddr,
+                                            std::vector <SNotificationReq> & notificationReq);
+  virtual long SumDelDeviceNotificationReq (AmsAddr                        & amsAddr,
+                                            std::vector <SNotificationReq> & notificationReq);
   virtual long PortOpen (void) = 0;
   virtual void PortClose (void) = 0;
   virtual long GetLocalAddress (AmsAddr & amsAddr) = 0;
   virtual long GetDllVersion (void) = 0;
+  virtual bool IsConcurrent (void) const { return false; }
+  virtual bool IsStdCallNotification (void) const { return true; } // the TwinCAT 2 router DLL calls back with cdecl
+
+  long GetPort (void) const { return m_port; }
+
+  long AddDeviceNotificationReqs (AmsAddr                        & amsAddr,
+                                  std::vector <SNotificationReq> & notificationReq);
+  long DelDeviceNotificationReqs (AmsAddr                        & amsAddr,
+                                  std::vector <SNotificationReq> & notificationReq);
 
 private:
-  using CMapStringToHandle = std::map <CString, ULONG>;
+  enum class EAddress { Unknown, Resolved, Unavailable };
+
+  struct SSymbol
+  {
+    CString  symbolName;
+    ULONG    hSymbol;
+    bool     isResolved;
+    EAddress address;     // index group and offset, read once with the symbol information
+    ULONG    indexGroup;
+    ULONG    indexOffset;
+    ULONG    size;
+  };
+
+#pragma pack (push, 1)
+  struct SSumWriteReq
+  {
+    ULONG indexGroup;
+    ULONG indexOffset;
+    ULONG length;
+  };
+
+  struct SSumReadWriteReq
+  {
+    ULONG indexGroup;
+    ULONG indexOffset;
+    ULONG readLength;
+    ULONG writeLength;
+  };
+
+  struct SSumReadWriteRes
+  {
+    ULONG result;
+    ULONG readLength;
+  };
+
+  struct SSumAddDeviceNotificationReq
+  {
+    ULONG                 indexGroup;
+    ULONG                 indexOffset;
+    AdsNotificationAttrib adsNotificationAttrib;
+  };
+
+  struct SSumAddDeviceNotificationRes
+  {
+    ULONG result;
+    ULONG hNotification;
+  };
+#pragma pack (pop)
 
   void UnRegisterNotification (void);
+  void ReleaseHandles (void);
+  void WaitForDispatch (unsigned long hUser);
+
+  ULONG GetHandle_ (int symbol);
+  void GetHandles_ (std::vector <int> const & symbols);
+  bool GetAddress_ (int symbol, size_t offset, size_t cbLength, ULONG & indexGroup, ULONG & indexOffset);
+  void ResolveAddresses_ (std::vector <int> const & symbols);
+  void SetAddress_ (int symbol, long error, AdsSymbolEntry const & symbolEntry);
+
+  void AddSymbolVersionNotification_ (void);
+
+  static void OnSymbolVersionTC2 (AmsAddr *, AdsNotificationHeader * pNotification, unsigned long hUser);
+  static void __stdcall OnSymbolVersionTC3 (AmsAddr *, AdsNotificationHeader * pNotification, unsigned long hUser);
+
+  void OnSymbolVersion (AdsNotificationHeader const * pNotification);
 
-  ULONG GetHandle (CString const & symbolName);
+  long WriteVariable (int symbol, size_t cbLength, void const * pData);
+  long WriteVariables (std::vector <CVariable> const & variables, std::vector <ULONG> & result);
+
+  long GetSymbolVersion (BYTE & symbolVersion);
+  long GetSymbolEntry (CString const & symbolName, AdsSymbolEntry & symbolEntry);
+
+  CString GetSymbolName (int symbol);
+
+  static bool IsSymbolVersionInvalid (long error);
 
   static void LoadLibrary (CString const & adsDllFilename, CAdsDllVersion const & version);
   static void FreeLibrary (void);
 
   static void GetProcAddress (CProcAds const & procAds);
+  static bool FindProcAddress (CProcAds const & procAds);
 
   static CString GetADSErrorMessage (long error);
 
@@ -118,15 +299,49 @@ private:
   static HMODULE             m_hModule;
   static std::mutex          m_apiGate;
 
+  static size_t const SYMBOL_INFO_SIZE; // read for the type name and comment that follow a symbol entry
+
+  struct SConnection
+  {
+    std::mutex                  connectionGate;
+    std::weak_ptr <ITwinCATADS> twinCATADS;
+  };
+
+  static std::map <CString, std::shared_ptr <SConnection>> m_connection;
+  static std::mutex                                        m_connectionGate;
+
+  static void EraseExpiredConnections (void);
+
   static std::map <long, CString> const m_adsErrorMessage;
 
   AmsAddr m_amsAddr;
-  CMapStringToHandle m_mapHandle;
-  std::vector <std::tuple <ULONG, ULONG>> m_hNotification;
+  long m_port;
+  std::mutex m_portGate;
+  std::mutex m_handleGate;
+  std::vector <SSymbol> m_symbol;
+  std::map <CString, int> m_mapSymbol;
+  std::mutex m_notificationGate;
+  std::vector <SNotificationReq> m_notificationReq;
+  std::atomic_int m_symbolVersion;
+  std::atomic_bool m_isRebindPending;
+  std::atomic <ULONG> m_rebindCount;
+  SNotificationReq m_symbolVersionReq;  // hNotification is 0 while the symbol version is polled
+  std::atomic_bool m_isSymbolVersionNotified;
+  std::mutex m_dispatchGate;
+  std::condition_variable m_dispatchEvent;
+  std::vector <std::tuple <std::thread::id, unsigned long>> m_dispatch; // callbacks in flight, by thread and owner
+
+  // requests are serialized per client port, independent ports are in flight at the same time, a
+  // backend that matches responses to requests on its own keeps several in flight on one port...
 
   template <typename _Fn> auto CallAPI (_Fn _Fx)
     {
-      std::unique_lock <std::mutex> l_apiGate { m_apiGate };
+      if (IsConcurrent ())
+        {
+          return _Fx (m_amsAddr);
+        }
+
+      std::unique_lock <std::mutex> l_portGate { m_portGate };
 
       return _Fx (m_amsAddr);
     }
@@ -140,6 +355,11 @@ std::atomic_int32_t ITwinCATADS::m_refCount (0);
 HMODULE             ITwinCATADS::m_hModule  (nullptr);
 std::mutex          ITwinCATADS::m_apiGate;
 
+size_t const        ITwinCATADS::SYMBOL_INFO_SIZE (512);
+
+std::map <CString, std::shared_ptr <ITwinCATADS::SConnection>> ITwinCATADS::m_connection;
+std::mutex                                                     ITwinCATADS::m_connectionGate;
+
 std::map <long, CString> const ITwinCATADS::m_adsErrorMessage
 {
   { 0x00000001,                         _T ("internal error")                                                                          },
@@ -263,522 +483,3898 @@ std::map <long, CString> const ITwinCATADS::m_adsErrorMessage
   { 0x0000101A,                         _T ("enabling Intel VT-x failed")                                                              }
 };
 
-ITwinCATADS::ITwinCATADS (void)
+void
+ITwinCATADS::EraseExpiredConnections (void)
 {
-  ::memset (&m_amsAddr, 0, sizeof (m_amsAddr));
+  // a pool entry goes with the last owner of its connection; an entry that someone else holds is
+  // being connected (or reconnected) and stays...
 
-  ++m_refCount;
+  std::unique_lock <std::mutex> l_connectionGate { m_connectionGate };
+
+  for (auto l_connection (m_connection.begin ()); l_connection != m_connection.end (); )
+    {
+      if ((std::get <1> (*l_connection).use_count () == 1) && std::get <1> (*l_connection)->twinCATADS.expired ())
+        {
+          l_connection = m_connection.erase (l_connection);
+        }
+      else
+        {
+          ++l_connection;
+        }
+    }
 }
 
-void
-ITwinCATADS::SetVariable (CString const & symbolName, size_t cbLength, void const * pData)
+template <typename T, typename... Args> std::shared_ptr <ITwinCATADS>
+ITwinCATADS::Connect (WORD portNumber, Args const & ... args)
 {
-  auto const l_hSymbol (GetHandle (symbolName));
+  // controllers on the same target port share one connection, and with it the symbol handles, the
+  // notifications and the sum requests, a backend without a connection key is never shared...
 
-  auto const l_error (CallAPI ([this, l_hSymbol, cbLength, pData] (auto & amsAddr)
-                               {
-                                 return SyncWriteReq (amsAddr, ADSIGRP_SYM_VALBYHND, l_hSymbol, cbLength, const_cast <void *> (pData));
-                               }));
+  auto const l_key (T::GetConnectionKey (portNumber, args...));
 
-  if (l_error == ADSERR_NOERR)
+  if (l_key.IsEmpty ())
     {
-      return;
+      std::shared_ptr <ITwinCATADS> const l_twinCATADS (std::make_shared <T> (args...));
+
+      l_twinCATADS->Create (portNumber);
+
+      return l_twinCATADS;
+    }
+
+  // the pool is only locked to find the connection, a connection is opened under its own gate so
+  // that controllers bringing up different ports do not wait for each other...
+
+  std::shared_ptr <SConnection> l_connection;
+
+  {
+    std::unique_lock <std::mutex> l_connectionGate { m_connectionGate };
+
+    auto & l_connection_ (m_connection[l_key]);
+
+    if (!l_connection_)
+      {
+        l_connection_ = std::make_shared <SConnection> ();
+      }
+
+    l_connection = l_connection_;
+  }
+
+  std::unique_lock <std::mutex> l_connectionGate { l_connection->connectionGate };
+
+  auto l_twinCATADS (l_connection->twinCATADS.lock ());
+
+  if (!l_twinCATADS)
+    {
+      l_twinCATADS = std::make_shared <T> (args...);
+
+      l_twinCATADS->Create (portNumber);
+
+      l_connection->twinCATADS = l_twinCATADS;
     }
 
-  PDCLib::ThrowStringException (_T ("unable to write value to symbol %s; %s"), (LPCTSTR) symbolName, (LPCTSTR) GetADSErrorMessage (l_error));
+  return l_twinCATADS;
 }
 
-void
-ITwinCATADS::RegisterNotification (CString const & symbolName,
-                                   size_t          cbLength,
-                                   void          * pNoteFunc,
-                                   void          * hUser)
+long
+ITwinCATADS::SumAddDeviceNotificationReq (AmsAddr                        & amsAddr,
+                                          std::vector <SNotificationReq> & notificationReq)
 {
-  std::tuple <ULONG, ULONG> l_hSymbol;
+  // sum add notification request: list of {IGrp, IOffs, Attrib}...
 
-  std::get <0> (l_hSymbol) = GetHandle (symbolName);
+  std::vector <SSumAddDeviceNotificationReq> l_sumAddDeviceNotificationReq;
+
+  for (auto&& l_notificationReq : notificationReq)
+    {
+      l_sumAddDeviceNotificationReq.push_back ({ l_notificationReq.indexGroup, l_notificationReq.hSymbol, l_notificationReq.adsNotificationAttrib });
+    }
 
-  AdsNotificationAttrib l_adsNotificationAttrib;
+  // sum add notification response: list of {result, handle}...
 
-  l_adsNotificationAttrib.cbLength   = cbLength;             // total size of variable in bytes
-  l_adsNotificationAttrib.nTransMode = ADSTRANS_SERVERONCHA; // notify on change
-  l_adsNotificationAttrib.nMaxDelay  = 1000000;              // 100 milliseconds
-  l_adsNotificationAttrib.nCycleTime =  500000;              //  50 milliseconds
+  std::vector <SSumAddDeviceNotificationRes> l_sumAddDeviceNotificationRes (notificationReq.size (), { ADSERR_NOERR, 0 });
 
-  auto const l_error (CallAPI ([this, &l_hSymbol, &l_adsNotificationAttrib, pNoteFunc, hUser] (auto & amsAddr)
-                               {
-                                 return SyncAddDeviceNotificationReq (amsAddr,
-                                                                      std::get <0> (l_hSymbol),
-                                                                      &l_adsNotificationAttrib,
-                                                                      pNoteFunc,
-                                                                      reinterpret_cast <unsigned long> (hUser),
-                                                                      &std::get <1> (l_hSymbol));
-                               }));
+  auto const l_error (SyncReadWriteReq (amsAddr,
+                                        ADSIGRP_SUMUP_ADDDEVNOTE,
+                                        static_cast <unsigned long> (notificationReq.size ()),
+                                        static_cast <unsigned long> (l_sumAddDeviceNotificationRes.size () * sizeof (l_sumAddDeviceNotificationRes[0])),
+                                        &l_sumAddDeviceNotificationRes[0],
+                                        static_cast <unsigned long> (l_sumAddDeviceNotificationReq.size () * sizeof (l_sumAddDeviceNotificationReq[0])),
+                                        &l_sumAddDeviceNotificationReq[0]));
 
   if (l_error == ADSERR_NOERR)
     {
-      m_hNotification.push_back (l_hSymbol);
-
-      return;
+      for (size_t l_i (0); l_i < notificationReq.size (); ++l_i)
+        {
+          notificationReq[l_i].result        = l_sumAddDeviceNotificationRes[l_i].result;
+          notificationReq[l_i].hNotification = l_sumAddDeviceNotificationRes[l_i].hNotification;
+        }
     }
 
-  PDCLib::ThrowStringException (_T ("unable to register notification for symbol %s; %s"), (LPCTSTR) symbolName, (LPCTSTR) GetADSErrorMessage (l_error));
+  return l_error;
 }
 
-void
-ITwinCATADS::UnRegisterNotification (void)
+long
+ITwinCATADS::SumDelDeviceNotificationReq (AmsAddr                        & amsAddr,
+                                          std::vector <SNotificationReq> & notificationReq)
 {
-  CallAPI ([this] (auto & amsAddr)
-           {
-             for (auto&& l_hNotification : m_hNotification)
-               {
-                 VERIFY (SyncDelDeviceNotificationReq (amsAddr, std::get <1> (l_hNotification)) == ADSERR_NOERR);
+  // sum delete notification request: list of handles...
 
-                 VERIFY (SyncWriteReq (amsAddr, ADSIGRP_SYM_RELEASEHND, std::get <0> (l_hNotification), 0, nullptr) == ADSERR_NOERR);
-               }
-           });
+  std::vector <ULONG> l_hNotification;
+
+  for (auto&& l_notificationReq : notificationReq)
+    {
+      l_hNotification.push_back (l_notificationReq.hNotification);
+    }
 
-  m_hNotification.clear ();
+  // sum delete notification response: list of results...
+
+  std::vector <ULONG> l_result (notificationReq.size (), ADSERR_NOERR);
+
+  auto const l_error (SyncReadWriteReq (amsAddr,
+                                        ADSIGRP_SUMUP_DELDEVNOTE,
+                                        static_cast <unsigned long> (notificationReq.size ()),
+                                        static_cast <unsigned long> (l_result.size () * sizeof (l_result[0])),
+                                        &l_result[0],
+                                        static_cast <unsigned long> (l_hNotification.size () * sizeof (l_hNotification[0])),
+                                        &l_hNotification[0]));
+
+  if (l_error == ADSERR_NOERR)
+    {
+      for (size_t l_i (0); l_i < notificationReq.size (); ++l_i)
+        {
+          notificationReq[l_i].result = l_result[l_i];
+        }
+    }
+
+  return l_error;
 }
 
-ULONG
-ITwinCATADS::GetHandle (CString const & symbolName)
+long
+ITwinCATADS::AddDeviceNotificationReqs (AmsAddr                        & amsAddr,
+                                        std::vector <SNotificationReq> & notificationReq)
 {
-  auto const l_pos (m_mapHandle.lower_bound (symbolName));
+  for (auto&& l_notificationReq : notificationReq)
+    {
+      l_notificationReq.result = SyncAddDeviceNotificationReq (amsAddr,
+                                                               l_notificationReq.indexGroup,
+                                                               l_notificationReq.hSymbol,
+                                                               &l_notificationReq.adsNotificationAttrib,
+                                                               l_notificationReq.pNoteFunc,
+                                                               l_notificationReq.hUser,
+                                                               &l_notificationReq.hNotification);
+    }
 
-  if ((l_pos == m_mapHandle.end ()) || m_mapHandle.key_comp () (symbolName, std::get <0> (*l_pos)))
+  return ADSERR_NOERR;
+}
+
+long
+ITwinCATADS::DelDeviceNotificationReqs (AmsAddr                        & amsAddr,
+                                        std::vector <SNotificationReq> & notificationReq)
+{
+  for (auto&& l_notificationReq : notificationReq)
     {
-      std::vector <char> l_symbolName;
+      l_notificationReq.result = SyncDelDeviceNotificationReq (amsAddr, l_notificationReq.hNotification);
+    }
 
-      PDCLib::StringToVector (symbolName, l_symbolName);
+  return ADSERR_NOERR;
+}
 
-      ULONG l_hSymbol (0);
+ITwinCATADS::ITwinCATADS (void) :
+  m_port (0),
+  m_symbolVersion (-1),
+  m_isRebindPending (false),
+  m_rebindCount (0),
+  m_symbolVersionReq {},
+  m_isSymbolVersionNotified (false)
+{
+  ::memset (&m_amsAddr, 0, sizeof (m_amsAddr));
 
-      auto const l_error (CallAPI ([this, &l_hSymbol, &l_symbolName] (auto & amsAddr)
-                          {
-                            return SyncReadWriteReq (amsAddr,
-                                                     sizeof (l_hSymbol),
-                                                     &l_hSymbol,
-                                                     static_cast <unsigned long> (l_symbolName.size () * sizeof (l_symbolName[0])),
-                                                     &l_symbolName[0]);
-                          }));
+  m_symbolVersionReq.symbol                           = -1;
+  m_symbolVersionReq.indexGroup                       = ADSIGRP_SYM_VERSION;
+  m_symbolVersionReq.adsNotificationAttrib.cbLength   = sizeof (BYTE);
+  m_symbolVersionReq.adsNotificationAttrib.nTransMode = ADSTRANS_SERVERONCHA;
+  m_symbolVersionReq.hUser                            = reinterpret_cast <unsigned long> (this);
 
+  ++m_refCount;
+}
 
-      if (l_error == ADSERR_NOERR)
-        {
-          m_mapHandle.insert (l_pos, CMapStringToHandle::value_type (symbolName, l_hSymbol));
+void
+ITwinCATADS::SetVariable (int symbol, size_t cbLength, void const * pData)
+{
+  auto l_error (WriteVariable (symbol, cbLength, pData));
 
-          return l_hSymbol;
-        }
+  if (IsSymbolVersionInvalid (l_error))
+    {
+      // the symbols moved (online change or restart), rebind and try once more...
+
+      Rebind ();
 
-      PDCLib::ThrowStringException (_T ("unable to acquire handle for symbol %s; %s"), (LPCTSTR) symbolName, (LPCTSTR) GetADSErrorMessage (l_error));
+      l_error = WriteVariable (symbol, cbLength, pData);
     }
 
-  return std::get <1> (*l_pos);
+  if (l_error == ADSERR_NOERR)
+    {
+      return;
+    }
+
+  PDCLib::ThrowStringException (_T ("unable to write value to symbol %s; %s"), (LPCTSTR) GetSymbolName (symbol), (LPCTSTR) GetADSErrorMessage (l_error));
 }
 
 void
-ITwinCATADS::Create (CString        const & adsDllFilename,
-                     CAdsDllVersion const & adsDllVersion,
-                     CAdsApi        const & adsApi,
-                     WORD                   portNumber)
+ITwinCATADS::SetVariable (std::vector <CVariable> const & variables)
 {
-  if (m_hModule)
+  if (variables.size () < 2)
     {
-      CallAPI ([this, portNumber] (auto & amsAddr)
-               {
-                 auto const l_error (GetLocalAddress (amsAddr));
-
-                 if (l_error == ADSERR_NOERR)
-                   {
-                     amsAddr.port = portNumber;
-                      
-                     return;
-                   }
-
-                 PDCLib::ThrowStringException (_T ("unable to get TwinCAT ADS local address; %s"), (LPCTSTR) GetADSErrorMessage (l_error));
-               });
-                      
+      for (auto&& l_variable : variables)
+        {
+          SetVariable (std::get <0> (l_variable), std::get <1> (l_variable), std::get <2> (l_variable));
+        }
+
       return;
     }
 
-  try
+  std::vector <ULONG> l_result;
+
+  auto l_error (WriteVariables (variables, l_result));
+
+  if (IsSymbolVersionInvalid (l_error) || std::any_of (l_result.begin (), l_result.end (), IsSymbolVersionInvalid))
     {
-      LoadLibrary (adsDllFilename, adsDllVersion);
+      // the symbols moved (online change or restart), rebind and try once more...
 
-      for (auto&& l_adsApi : adsApi)
-        {
-          GetProcAddress (l_adsApi);
-        }
+      Rebind ();
+
+      l_error = WriteVariables (variables, l_result);
     }
-  catch (CString const & errorMessage)
+
+  if (l_error != ADSERR_NOERR)
     {
-      FreeLibrary ();
+      PDCLib::ThrowStringException (_T ("unable to write values to %ld symbols; %s"), static_cast <int> (variables.size ()), (LPCTSTR) GetADSErrorMessage (l_error));
+    }
 
-      PDCLib::ThrowStringException (_T ("unable to load library: %s; %s"), (LPCTSTR) adsDllFilename, (LPCTSTR) errorMessage);
+  for (size_t l_i (0); l_i < l_result.size (); ++l_i)
+    {
+      if (l_result[l_i] != ADSERR_NOERR)
+        {
+          PDCLib::ThrowStringException (_T ("unable to write value to symbol %s; %s"), (LPCTSTR) GetSymbolName (std::get <0> (variables[l_i])), (LPCTSTR) GetADSErrorMessage (l_result[l_i]));
+        }
     }
+}
 
-  CallAPI ([this, portNumber] (auto & amsAddr)
-           {
-             auto const l_dllVersion (GetDllVersion ());
+long
+ITwinCATADS::WriteVariable (int symbol, size_t cbLength, void const * pData)
+{
+  ULONG l_indexGroup (0);
+  ULONG l_indexOffset (0);
+
+  {
+    std::unique_lock <std::mutex> l_handleGate { m_handleGate };
+
+    if (!GetAddress_ (symbol, 0, cbLength, l_indexGroup, l_indexOffset))
+      {
+        l_indexGroup  = ADSIGRP_SYM_VALBYHND;
+        l_indexOffset = GetHandle_ (symbol);
+      }
+  }
+
+  return CallAPI ([this, l_indexGroup, l_indexOffset, cbLength, pData] (auto & amsAddr)
+                  {
+                    return SyncWriteReq (amsAddr, l_indexGroup, l_indexOffset, static_cast <unsigned long> (cbLength), const_cast <void *> (pData));
+                  });
+}
 
-             auto const l_adsVersion (reinterpret_cast <AdsVersion const *> (&l_dllVersion));
+long
+ITwinCATADS::WriteVariables (std::vector <CVariable> const & variables, std::vector <ULONG> & result)
+{
+  // sum write request: list of {IGrp, IOffs, Length} followed by list of data...
 
-             PDCLib::Trace (_T ("TwinCAT ADS Version  : %ld"), static_cast <int> (l_adsVersion->version));
-             PDCLib::Trace (_T ("TwinCAT ADS Revision : %ld"), static_cast <int> (l_adsVersion->revision));
-             PDCLib::Trace (_T ("TwinCAT ADS Build    : %ld"), static_cast <int> (l_adsVersion->build));
+  std::vector <SSumWriteReq> l_sumWriteReq;
+  std::vector <size_t>       l_request;     // the request that writes each variable
+  std::vector <BYTE>         l_data;
 
-             auto const l_port (PortOpen ());
+  l_sumWriteReq.reserve (variables.size ());
+  l_request.reserve (variables.size ());
 
-             PDCLib::Trace (_T ("TwinCAT ADS Port     : %ld"), l_port);
+  {
+    std::unique_lock <std::mutex> l_handleGate { m_handleGate };
 
-             auto const l_error (GetLocalAddress (amsAddr));
+    for (auto&& l_variable : variables)
+      {
+        auto const l_symbol   (std::get <0> (l_variable));
+        auto const l_cbLength (static_cast <ULONG> (std::get <1> (l_variable)));
 
-             if (l_error == ADSERR_NOERR)
-               {
-                 amsAddr.port = portNumber;
+        ULONG l_indexGroup (0);
+        ULONG l_indexOffset (0);
 
-                 return;
-               }
+        if (!GetAddress_ (l_symbol, 0, l_cbLength, l_indexGroup, l_indexOffset))
+          {
+            l_sumWriteReq.push_back ({ ADSIGRP_SYM_VALBYHND, GetHandle_ (l_symbol), l_cbLength });
+          }
+        else if (!l_sumWriteReq.empty () &&
+                 (l_sumWriteReq.back ().indexGroup == l_indexGroup) &&
+                 ((l_sumWriteReq.back ().indexOffset + l_sumWriteReq.back ().length) == l_indexOffset))
+          {
+            // the variable starts where the previous one ends, both are one transfer; only neighbours
+            // in request order are merged so that handshakes are still written after their setpoints...
 
-              PortClose ();
+            l_sumWriteReq.back ().length += l_cbLength;
+          }
+        else
+          {
+            l_sumWriteReq.push_back ({ l_indexGroup, l_indexOffset, l_cbLength });
+          }
 
-              FreeLibrary ();
+        l_request.push_back (l_sumWriteReq.size () - 1);
 
-              PDCLib::ThrowStringException (_T ("unable to get TwinCAT ADS local address; %s"), (LPCTSTR) GetADSErrorMessage (l_error));
-           });
-}
+        auto const l_pData (static_cast <BYTE const *> (std::get <2> (l_variable)));
 
-void
-ITwinCATADS::Destroy (void)
-{
-  UnRegisterNotification ();
+        l_data.insert (l_data.end (), l_pData, l_pData + l_cbLength);
+      }
+  }
 
-  if (--m_refCount == 0)
+  result.assign (variables.size (), ADSERR_NOERR);
+
+  if (l_sumWriteReq.size () == 1)
     {
-      if (m_hModule)
-        {
-          CallAPI ([this] (auto &) { PortClose (); });
-        }
+      // everything merged into one range, a plain write will do...
 
-      FreeLibrary ();
+      return CallAPI ([this, &l_sumWriteReq, &l_data] (auto & amsAddr)
+                      {
+                        return SyncWriteReq (amsAddr, l_sumWriteReq[0].indexGroup, l_sumWriteReq[0].indexOffset, l_sumWriteReq[0].length, &l_data[0]);
+                      });
+    }
+
+  std::vector <BYTE> l_writeData (reinterpret_cast <BYTE const *> (&l_sumWriteReq[0]),
+                                  reinterpret_cast <BYTE const *> (&l_sumWriteReq[0] + l_sumWriteReq.size ()));
+
+  l_writeData.insert (l_writeData.end (), l_data.begin (), l_data.end ());
+
+  // sum write response: list of results, one per request, handed to every variable of the request...
+
+  std::vector <ULONG> l_result (l_sumWriteReq.size (), ADSERR_NOERR);
+
+  auto const l_error (CallAPI ([this, &l_result, &l_writeData] (auto & amsAddr)
+                               {
+                                 return SyncReadWriteReq (amsAddr,
+                                                          ADSIGRP_SUMUP_WRITE,
+                                                          static_cast <unsigned long> (l_result.size ()),
+                                                          static_cast <unsigned long> (l_result.size () * sizeof (l_result[0])),
+                                                          &l_result[0],
+                                                          static_cast <unsigned long> (l_writeData.size ()),
+                                                          &l_writeData[0]);
+                               }));
+
+  for (size_t l_i (0); l_i < l_request.size (); ++l_i)
+    {
+      result[l_i] = l_result[l_request[l_i]];
     }
+
+  return l_error;
 }
 
 void
-ITwinCATADS::LoadLibrary (CString const & adsDllFilename, CAdsDllVersion const & adsDllVersion)
+ITwinCATADS::RegisterNotification (std::vector <CNotification> const & notifications, void * hUser)
 {
-  if ((m_hModule = ::AfxLoadLibrary (adsDllFilename)) == nullptr)
+  if (notifications.empty ())
     {
-      PDCLib::ThrowStringException (_T ("%s"), (LPCTSTR) PDCLib::GetErrorMessage (::GetLastError ()));
+      return;
     }
 
-  std::vector <DWORD> l_adsDllVersion;
+  std::vector <int> l_symbols;
 
-  if (PDCLib::CVersionInfo l_versionInfo; l_versionInfo.Create (m_hModule) && l_versionInfo.GetFileVersion (l_adsDllVersion))
+  for (auto&& l_notification : notifications)
     {
-      if (l_adsDllVersion.size () == adsDllVersion.size ())
-        {
-          if (std::lexicographical_compare (begin (l_adsDllVersion), end (l_adsDllVersion), begin (adsDllVersion), end (adsDllVersion)))
-            {
-              PDCLib::ThrowStringException (_T ("minimum version requirement not satisfied"));
-            }
+      l_symbols.push_back (std::get <0> (l_notification));
+    }
 
-          return;
-        }
+  GetHandles (l_symbols);
 
-      PDCLib::ThrowStringException (_T ("invalid version information"));
+  std::vector <SNotificationReq> l_notificationReq;
+
+  for (auto&& l_notification : notifications)
+    {
+      SNotificationReq l_notificationReq_ {};
+
+      l_notificationReq_.symbol                = std::get <0> (l_notification);
+      l_notificationReq_.indexGroup            = ADSIGRP_SYM_VALBYHND;
+      l_notificationReq_.hSymbol               = GetHandle (std::get <0> (l_notification));
+      l_notificationReq_.adsNotificationAttrib = std::get <1> (l_notification);
+      l_notificationReq_.pNoteFunc             = std::get <2> (l_notification);
+      l_notificationReq_.hUser                 = reinterpret_cast <unsigned long> (hUser);
+      l_notificationReq_.result                = ADSERR_NOERR;
+
+      l_notificationReq.push_back (l_notificationReq_);
     }
 
-  PDCLib::ThrowStringException (_T ("unable to load version information"));
+  auto const l_error (CallAPI ([this, &l_notificationReq] (auto & amsAddr) { return SumAddDeviceNotificationReq (amsAddr, l_notificationReq); }));
+
+  if (l_error != ADSERR_NOERR)
+    {
+      PDCLib::ThrowStringException (_T ("unable to register notifications for %ld symbols; %s"), static_cast <int> (notifications.size ()), (LPCTSTR) GetADSErrorMessage (l_error));
+    }
+
+  // keep the notifications that were added so they are deleted on teardown and added again on rebind...
+
+  {
+    std::unique_lock <std::mutex> l_notificationGate { m_notificationGate };
+
+    for (auto&& l_notificationReq_ : l_notificationReq)
+      {
+        if (l_notificationReq_.result == ADSERR_NOERR)
+          {
+            m_notificationReq.push_back (l_notificationReq_);
+          }
+      }
+  }
+
+  for (size_t l_i (0); l_i < l_notificationReq.size (); ++l_i)
+    {
+      if (l_notificationReq[l_i].result != ADSERR_NOERR)
+        {
+          PDCLib::ThrowStringException (_T ("unable to register notification for symbol %s; %s"), (LPCTSTR) GetSymbolName (std::get <0> (notifications[l_i])), (LPCTSTR) GetADSErrorMessage (l_notificationReq[l_i].result));
+        }
+    }
 }
 
 void
-ITwinCATADS::FreeLibrary (void)
+ITwinCATADS::UnRegisterNotification (void * hUser)
 {
-  if (m_hModule)
-    {
-      VERIFY (::AfxFreeLibrary (m_hModule));
+  // the notifications of one owner are deleted, the handles stay with the shared connection...
 
-      m_hModule = nullptr;
-    }
+  {
+    std::unique_lock <std::mutex> l_notificationGate { m_notificationGate };
+
+    auto const l_pos (std::stable_partition (m_notificationReq.begin (),
+                                             m_notificationReq.end (),
+                                             [hUser] (auto const & notificationReq) { return notificationReq.hUser != reinterpret_cast <unsigned long> (hUser); }));
+
+    if (l_pos != m_notificationReq.end ())
+      {
+        std::vector <SNotificationReq> l_notificationReq (l_pos, m_notificationReq.end ());
+
+        m_notificationReq.erase (l_pos, m_notificationReq.end ());
+
+        VERIFY (CallAPI ([this, &l_notificationReq] (auto & amsAddr) { return SumDelDeviceNotificationReq (amsAddr, l_notificationReq); }) == ADSERR_NOERR);
+      }
+  }
+
+  // no new callback reaches the owner now, one already on its way is waited for before the owner goes...
+
+  WaitForDispatch (reinterpret_cast <unsigned long> (hUser));
 }
 
 void
-ITwinCATADS::GetProcAddress (CProcAds const & procAds)
+ITwinCATADS::BeginDispatch (unsigned long hUser)
 {
-  std::vector <char> l_procName;
+  std::unique_lock <std::mutex> l_dispatchGate { m_dispatchGate };
 
-  PDCLib::StringToVector (std::get <1> (procAds), l_procName);
+  m_dispatch.emplace_back (std::this_thread::get_id (), hUser);
+}
+
+void
+ITwinCATADS::EndDispatch (unsigned long hUser)
+{
+  std::unique_lock <std::mutex> l_dispatchGate { m_dispatchGate };
 
-  if ((*std::get <0> (procAds) = ::GetProcAddress (m_hModule, &l_procName[0])) == nullptr)
+  if (auto const l_pos (std::find (m_dispatch.begin (), m_dispatch.end (), std::make_tuple (std::this_thread::get_id (), hUser))); l_pos != m_dispatch.end ())
     {
-      PDCLib::ThrowStringException (_T ("unable to get procedure address for %s: %s"), (LPCTSTR) CString (std::get <1> (procAds)), (LPCTSTR) PDCLib::GetErrorMessage (::GetLastError ()));
+      m_dispatch.erase (l_pos);
     }
+
+  m_dispatchEvent.notify_all ();
 }
 
-CString
-ITwinCATADS::GetADSErrorMessage (long error)
+void
+ITwinCATADS::WaitForDispatch (unsigned long hUser)
 {
-  if (auto const l_adsErrorMessage (m_adsErrorMessage.find (error)); l_adsErrorMessage == m_adsErrorMessage.end ())
+  // an owner that unregisters from within its own callback does not wait for itself...
+
+  auto const l_threadId (std::this_thread::get_id ());
+
+  std::unique_lock <std::mutex> l_dispatchGate { m_dispatchGate };
+
+  m_dispatchEvent.wait (l_dispatchGate,
+                        [this, hUser, l_threadId]
+                        {
+                          return std::none_of (m_dispatch.begin (),
+                                               m_dispatch.end (),
+                                               [hUser, l_threadId] (auto const & dispatch) { return (std::get <1> (dispatch) == hUser) && (std::get <0> (dispatch) != l_threadId); });
+                        });
+}
+
+void
+ITwinCATADS::UnRegisterNotification (void)
+{
+  std::unique_lock <std::mutex> l_notificationGate { m_notificationGate };
+
+  if (!m_notificationReq.empty ())
     {
-      if (error < WSABASEERR)
-        {
-          return PDCLib::StringWithFormat (_T ("unrecognized TwinCAT ADS error code (%ld)"), error);
-        }
+      VERIFY (CallAPI ([this] (auto & amsAddr) { return SumDelDeviceNotificationReq (amsAddr, m_notificationReq); }) == ADSERR_NOERR);
 
-      return PDCLib::StringWithFormat (_T ("%s (%ld)"), (LPCTSTR) PDCLib::GetErrorMessage (error), error);
+      m_notificationReq.clear ();
     }
-  else
+
+  if (m_isSymbolVersionNotified.exchange (false))
     {
-      return PDCLib::StringWithFormat (_T ("%s (%ld)"), (LPCTSTR) std::get <1> (*l_adsErrorMessage), error);
+      std::vector <SNotificationReq> l_notificationReq (1, m_symbolVersionReq);
+
+      CallAPI ([this, &l_notificationReq] (auto & amsAddr) { return SumDelDeviceNotificationReq (amsAddr, l_notificationReq); });
+
+      WaitForDispatch (m_symbolVersionReq.hUser);
     }
+
+  ReleaseHandles ();
 }
 
-class CTwinCATADS2 final : public ITwinCATADS
+void
+ITwinCATADS::ReleaseHandles (void)
 {
-public:
-  explicit CTwinCATADS2 (void) = default;
-  virtual ~CTwinCATADS2 () { Destroy (); }
+  std::unique_lock <std::mutex> l_handleGate { m_handleGate };
 
-  virtual void Create (WORD portNumber) override final
+  // sum write request: list of {IGrp, IOffs, Length}, there is no data to follow...
+
+  std::vector <SSumWriteReq> l_sumWriteReq;
+
+  for (auto&& l_symbol : m_symbol)
     {
-      ITwinCATADS::Create (ADSDLL_LIBRARY, ADSDLL_VERSION, m_adsApi, portNumber);
+      if (l_symbol.isResolved)
+        {
+          l_sumWriteReq.push_back ({ ADSIGRP_SYM_RELEASEHND, l_symbol.hSymbol, 0 });
+        }
     }
 
-private:
-  virtual long SyncWriteReq (AmsAddr       & amsAddr,
-                             unsigned long   indexGroup,
-                             unsigned long   indexOffset,
-                             unsigned long   length,
-                             void          * pData) override final
+  if (l_sumWriteReq.empty ())
     {
-      return AdsSyncWriteReq (&amsAddr, indexGroup, indexOffset, length, pData);
+      return;
     }
-  virtual long SyncReadWriteReq (AmsAddr       & amsAddr,
-                                 unsigned long   cbReadLength,
-                                 void          * pReadData,
-                                 unsigned long   cbWriteLength,
-                                 void          * pWriteData) override final
+
+  std::vector <ULONG> l_result (l_sumWriteReq.size (), ADSERR_NOERR);
+
+  auto const l_error (CallAPI ([this, &l_sumWriteReq, &l_result] (auto & amsAddr)
+                               {
+                                 return SyncReadWriteReq (amsAddr,
+                                                          ADSIGRP_SUMUP_WRITE,
+                                                          static_cast <unsigned long> (l_sumWriteReq.size ()),
+                                                          static_cast <unsigned long> (l_result.size () * sizeof (l_result[0])),
+                                                          &l_result[0],
+                                                          static_cast <unsigned long> (l_sumWriteReq.size () * sizeof (l_sumWriteReq[0])),
+                                                          &l_sumWriteReq[0]);
+                               }));
+
+  if (l_error == ADSERR_DEVICE_SRVNOTSUPP)
     {
-      return AdsSyncReadWriteReq (&amsAddr, ADSIGRP_SYM_HNDBYNAME, 0, cbReadLength, pReadData, cbWriteLength, pWriteData);
+      // sum commands not supported by the target, release the handles one at a time...
+
+      for (auto&& l_sumWriteReq_ : l_sumWriteReq)
+        {
+          VERIFY (CallAPI ([this, &l_sumWriteReq_] (auto & amsAddr) { return SyncWriteReq (amsAddr, ADSIGRP_SYM_RELEASEHND, l_sumWriteReq_.indexOffset, 0, nullptr); }) == ADSERR_NOERR);
+        }
     }
-  virtual long SyncAddDeviceNotificationReq (AmsAddr               & amsAddr,
-                                             unsigned long           indexOffset,
-                                             AdsNotificationAttrib * adsNotificationAttrib,
-                                             void                  * pNoteFunc,
-                                             unsigned long           hUser,
-                                             unsigned long         * pNotification) override final
+  else
     {
-      return AdsSyncAddDeviceNotificationReq (&amsAddr,
-                                              ADSIGRP_SYM_VALBYHND,
-                                              indexOffset,
-                                              adsNotificationAttrib,
-                                              reinterpret_cast <PAdsNotificationFuncTC2> (pNoteFunc),
-                                              hUser,
-                                              pNotification);
+      VERIFY (l_error == ADSERR_NOERR);
     }
-  virtual long SyncDelDeviceNotificationReq (AmsAddr       & amsAddr,
-                                             unsigned long   hNotification) override final
+
+  // the symbols stay interned so their indices remain valid...
+
+  for (auto&& l_symbol : m_symbol)
     {
-      return AdsSyncDelDeviceNotificationReq (&amsAddr, hNotification);
+      l_symbol.isResolved = false;
     }
+}
 
-  virtual long PortOpen (void) override final { return AdsPortOpen (); }
-  virtual void PortClose (void) override final { AdsPortClose (); }
-  virtual long GetLocalAddress (AmsAddr & amsAddr) override final { return AdsGetLocalAddress (&amsAddr); }
-  virtual long GetDllVersion (void) override final { return AdsGetDllVersion (); }
+int
+ITwinCATADS::AddSymbol (CString const & symbolName)
+{
+  std::unique_lock <std::mutex> l_handleGate { m_handleGate };
 
-  static CString                                const ADSDLL_LIBRARY;
-  static CAdsDllVersion                         const ADSDLL_VERSION;
+  auto const l_pos (m_mapSymbol.lower_bound (symbolName));
 
-  static ProcAdsGetDllVersionTC2                      AdsGetDllVersion;
-  static ProcAdsPortOpenTC2                           AdsPortOpen;
-  static ProcAdsPortCloseTC2                          AdsPortClose;
-  static ProcAdsGetLocalAddressTC2                    AdsGetLocalAddress;
-  static ProcAdsSyncWriteReqTC2                       AdsSyncWriteReq;
-  static ProcAdsSyncReadWriteReqTC2                   AdsSyncReadWriteReq;
-  static ProcAdsSyncAddDeviceNotificationReqTC2       AdsSyncAddDeviceNotificationReq;
-  static ProcAdsSyncDelDeviceNotificationReqTC2       AdsSyncDelDeviceNotificationReq;
+  if ((l_pos == m_mapSymbol.end ()) || m_mapSymbol.key_comp () (symbolName, std::get <0> (*l_pos)))
+    {
+      auto const l_symbol (static_cast <int> (m_symbol.size ()));
 
-  static CAdsApi                                const m_adsApi;
+      m_symbol.push_back ({ symbolName, 0, false, EAddress::Unknown, 0, 0, 0 });
 
-public:
-  CTwinCATADS2 (CTwinCATADS2 const &) = delete;
-  CTwinCATADS2 & operator = (CTwinCATADS2 const &) = delete;
-};
+      m_mapSymbol.insert (l_pos, std::map <CString, int>::value_type (symbolName, l_symbol));
+
+      return l_symbol;
+    }
+
+  return std::get <1> (*l_pos);
+}
 
-CString                                const CTwinCATADS2::ADSDLL_LIBRARY                  (_T ("AdsDll.dll"));
-CTwinCATADS2::CAdsDllVersion           const CTwinCATADS2::ADSDLL_VERSION                  { 2, 11, 0, 3 };
+ULONG
+ITwinCATADS::GetHandle (int symbol)
+{
+  std::unique_lock <std::mutex> l_handleGate { m_handleGate };
 
-ProcAdsGetDllVersionTC2                      CTwinCATADS2::AdsGetDllVersion                (nullptr);
-ProcAdsPortOpenTC2                           CTwinCATADS2::AdsPortOpen                     (nullptr);
-ProcAdsPortCloseTC2                          CTwinCATADS2::AdsPortClose                    (nullptr);
-ProcAdsGetLocalAddressTC2                    CTwinCATADS2::AdsGetLocalAddress              (nullptr);
-ProcAdsSyncWriteReqTC2                       CTwinCATADS2::AdsSyncWriteReq                 (nullptr);
-ProcAdsSyncReadWriteReqTC2                   CTwinCATADS2::AdsSyncReadWriteReq             (nullptr);
-ProcAdsSyncAddDeviceNotificationReqTC2       CTwinCATADS2::AdsSyncAddDeviceNotificationReq (nullptr);
-ProcAdsSyncDelDeviceNotificationReqTC2       CTwinCATADS2::AdsSyncDelDeviceNotificationReq (nullptr);
+  return GetHandle_ (symbol);
+}
 
-CTwinCATADS2::CAdsApi                  const CTwinCATADS2::m_adsApi
+void
+ITwinCATADS::GetHandles (std::vector <int> const & symbols)
 {
-  CProcAds { reinterpret_cast <LPVOID *> (&AdsGetDllVersion),                _T ("AdsGetDllVersion")                },
-  CProcAds { reinterpret_cast <LPVOID *> (&AdsPortOpen),                     _T ("AdsPortOpen")                     },
-  CProcAds { reinterpret_cast <LPVOID *> (&AdsPortClose),                    _T ("AdsPortClose")                    },
-  CProcAds { reinterpret_cast <LPVOID *> (&AdsGetLocalAddress),              _T ("AdsGetLocalAddress")              },
-  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncWriteReq),                 _T ("AdsSyncWriteReq")                 },
-  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncReadWriteReq),             _T ("AdsSyncReadWriteReq")             },
-  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncAddDeviceNotificationReq), _T ("AdsSyncAddDeviceNotificationReq") },
-  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncDelDeviceNotificationReq), _T ("AdsSyncDelDeviceNotificationReq") }
-};
+  std::unique_lock <std::mutex> l_handleGate { m_handleGate };
 
-class CTwinCATADS3 final : public ITwinCATADS
+  GetHandles_ (symbols);
+}
+
+ULONG
+ITwinCATADS::GetHandle_ (int symbol)
 {
-public:
-  explicit CTwinCATADS3 (void) = default;
-  virtual ~CTwinCATADS3 () { Destroy (); }
+  auto & l_symbol (m_symbol[symbol]);
 
-  virtual void Create (WORD portNumber) override final
+  if (!l_symbol.isResolved)
     {
-      ITwinCATADS::Create (ADSDLL_LIBRARY, ADSDLL_VERSION, m_adsApi, portNumber);
+      std::vector <char> l_symbolName;
+
+      PDCLib::StringToVector (l_symbol.symbolName, l_symbolName);
+
+      ULONG l_hSymbol (0);
+
+      auto const l_error (CallAPI ([this, &l_hSymbol, &l_symbolName] (auto & amsAddr)
+                          {
+                            return SyncReadWriteReq (amsAddr,
+                                                     ADSIGRP_SYM_HNDBYNAME,
+                                                     0,
+                                                     sizeof (l_hSymbol),
+                                                     &l_hSymbol,
+                                                     static_cast <unsigned long> (l_symbolName.size () * sizeof (l_symbolName[0])),
+                                                     &l_symbolName[0]);
+                          }));
+
+
+      if (l_error != ADSERR_NOERR)
+        {
+          PDCLib::ThrowStringException (_T ("unable to acquire handle for symbol %s; %s"), (LPCTSTR) l_symbol.symbolName, (LPCTSTR) GetADSErrorMessage (l_error));
+        }
+
+      l_symbol.hSymbol    = l_hSymbol;
+      l_symbol.isResolved = true;
     }
 
-private:
-  virtual long SyncWriteReq (AmsAddr       & amsAddr,
-                             unsigned long   indexGroup,
-                             unsigned long   indexOffset,
-                             unsigned long   length,
-                             void          * pData) override final
+  return l_symbol.hSymbol;
+}
+
+void
+ITwinCATADS::GetHandles_ (std::vector <int> const & symbols)
+{
+  std::vector <int> l_symbols;
+
+  for (auto&& l_symbol : symbols)
     {
-      return AdsSyncWriteReq (&amsAddr, indexGroup, indexOffset, length, pData);
+      if (!m_symbol[l_symbol].isResolved)
+        {
+          l_symbols.push_back (l_symbol);
+        }
     }
-  virtual long SyncReadWriteReq (AmsAddr       & amsAddr,
-                                 unsigned long   cbReadLength,
-                                 void          * pReadData,
-                                 unsigned long   cbWriteLength,
-                                 void          * pWriteData) override final
+
+  if (l_symbols.size () < 2)
     {
-      return AdsSyncReadWriteReq (&amsAddr, ADSIGRP_SYM_HNDBYNAME, 0, cbReadLength, pReadData, cbWriteLength, pWriteData);
+      return;
     }
-  virtual long SyncAddDeviceNotificationReq (AmsAddr               & amsAddr,
-                                             unsigned long           indexOffset,
-                                             AdsNotificationAttrib * adsNotificationAttrib,
-                                             void                  * pNoteFunc,
-                                             unsigned long           hUser,
-                                             unsigned long         * pNotification) override final
+
+  // sum read/write request: list of {IGrp, IOffs, RLength, WLength} followed by list of data...
+
+  std::vector <SSumReadWriteReq> l_sumReadWriteReq;
+  std::vector <char> l_symbolData;
+
+  for (auto&& l_symbol : l_symbols)
     {
-      return AdsSyncAddDeviceNotificationReq (&amsAddr,
-                                              ADSIGRP_SYM_VALBYHND,
-                                              indexOffset,
-                                              adsNotificationAttrib,
-                                              reinterpret_cast <PAdsNotificationFuncTC3> (pNoteFunc),
-                                              hUser,
-                                              pNotification);
+      std::vector <char> l_symbolName;
+
+      PDCLib::StringToVector (m_symbol[l_symbol].symbolName, l_symbolName);
+
+      l_sumReadWriteReq.push_back ({ ADSIGRP_SYM_HNDBYNAME, 0, sizeof (ULONG), static_cast <ULONG> (l_symbolName.size () * sizeof (l_symbolName[0])) });
+
+      l_symbolData.insert (l_symbolData.end (), l_symbolName.begin (), l_symbolName.end ());
     }
-  virtual long SyncDelDeviceNotificationReq (AmsAddr       & amsAddr,
-                                             unsigned long   hNotification) override final
+
+  std::vector <BYTE> l_writeData (reinterpret_cast <BYTE const *> (&l_sumReadWriteReq[0]),
+                                  reinterpret_cast <BYTE const *> (&l_sumReadWriteReq[0] + l_sumReadWriteReq.size ()));
+
+  l_writeData.insert (l_writeData.end (), l_symbolData.begin (), l_symbolData.end ());
+
+  // sum read/write response: list of {result, RLength} followed by list of data...
+
+  std::vector <BYTE> l_readData (l_symbols.size () * (sizeof (SSumReadWriteRes) + sizeof (ULONG)));
+
+  auto const l_error (CallAPI ([this, &l_symbols, &l_readData, &l_writeData] (auto & amsAddr)
+                               {
+                                 return SyncReadWriteReq (amsAddr,
+                                                          ADSIGRP_SUMUP_READWRITE,
+                                                          static_cast <unsigned long> (l_symbols.size ()),
+                                                          static_cast <unsigned long> (l_readData.size ()),
+                                                          &l_readData[0],
+                                                          static_cast <unsigned long> (l_writeData.size ()),
+                                                          &l_writeData[0]);
+                               }));
+
+  if (l_error != ADSERR_NOERR)
     {
-      return AdsSyncDelDeviceNotificationReq (&amsAddr, hNotification);
+      // not fatal, the handles are acquired one at a time on first use...
+
+      PDCLib::Trace (_T ("unable to acquire handles for %ld symbols; %s"), static_cast <int> (l_symbols.size ()), (LPCTSTR) GetADSErrorMessage (l_error));
+
+      return;
     }
 
-  virtual long PortOpen (void) override final { return AdsPortOpen (); }
-  virtual void PortClose (void) override final { AdsPortClose (); }
-  virtual long GetLocalAddress (AmsAddr & amsAddr) override final { return AdsGetLocalAddress (&amsAddr); }
-  virtual long GetDllVersion (void) override final { return AdsGetDllVersion (); }
+  auto const l_sumReadWriteRes (reinterpret_cast <SSumReadWriteRes const *> (&l_readData[0]));
 
-  static CString                                const ADSDLL_LIBRARY;
-  static CAdsDllVersion                         const ADSDLL_VERSION;
+  auto l_pData (&l_readData[0] + l_symbols.size () * sizeof (SSumReadWriteRes));
 
-  static ProcAdsGetDllVersionTC3                      AdsGetDllVersion;
-  static ProcAdsPortOpenTC3                           AdsPortOpen;
-  static ProcAdsPortCloseTC3                          AdsPortClose;
-  static ProcAdsGetLocalAddressTC3                    AdsGetLocalAddress;
-  static ProcAdsSyncWriteReqTC3                       AdsSyncWriteReq;
-  static ProcAdsSyncReadWriteReqTC3                   AdsSyncReadWriteReq;
-  static ProcAdsSyncAddDeviceNotificationReqTC3       AdsSyncAddDeviceNotificationReq;
-  static ProcAdsSyncDelDeviceNotificationReqTC3       AdsSyncDelDeviceNotificationReq;
+  for (size_t l_i (0); l_i < l_symbols.size (); ++l_i)
+    {
+      auto const l_readLength (l_sumReadWriteRes[l_i].readLength);
 
-  static CAdsApi                                const m_adsApi;
+      if (l_pData + l_readLength > &l_readData[0] + l_readData.size ())
+        {
+          break;
+        }
 
-public:
-  CTwinCATADS3 (CTwinCATADS3 const &) = delete;
-  CTwinCATADS3 & operator = (CTwinCATADS3 const &) = delete;
-};
+      auto & l_symbol (m_symbol[l_symbols[l_i]]);
 
-CString                                const CTwinCATADS3::ADSDLL_LIBRARY                  (_T ("TcAdsDll.dll"));
-CTwinCATADS3::CAdsDllVersion           const CTwinCATADS3::ADSDLL_VERSION                  { 2, 11, 0, 41 };
+      if ((l_sumReadWriteRes[l_i].result == ADSERR_NOERR) && (l_readLength == sizeof (ULONG)))
+        {
+          l_symbol.hSymbol    = *reinterpret_cast <ULONG const *> (l_pData);
+          l_symbol.isResolved = true;
+        }
+      else
+        {
+          PDCLib::Trace (_T ("unable to acquire handle for symbol %s; %s"), (LPCTSTR) l_symbol.symbolName, (LPCTSTR) GetADSErrorMessage (l_sumReadWriteRes[l_i].result));
+        }
 
-ProcAdsGetDllVersionTC3                      CTwinCATADS3::AdsGetDllVersion                (nullptr);
-ProcAdsPortOpenTC3                           CTwinCATADS3::AdsPortOpen                     (nullptr);
-ProcAdsPortCloseTC3                          CTwinCATADS3::AdsPortClose                    (nullptr);
-ProcAdsGetLocalAddressTC3                    CTwinCATADS3::AdsGetLocalAddress              (nullptr);
-ProcAdsSyncWriteReqTC3                       CTwinCATADS3::AdsSyncWriteReq                 (nullptr);
-ProcAdsSyncReadWriteReqTC3                   CTwinCATADS3::AdsSyncReadWriteReq             (nullptr);
-ProcAdsSyncAddDeviceNotificationReqTC3       CTwinCATADS3::AdsSyncAddDeviceNotificationReq (nullptr);
-ProcAdsSyncDelDeviceNotificationReqTC3       CTwinCATADS3::AdsSyncDelDeviceNotificationReq (nullptr);
+      l_pData += l_readLength;
+    }
+}
 
-CTwinCATADS3::CAdsApi                  const CTwinCATADS3::m_adsApi
+ULONG
+ITwinCATADS::GetSymbolSize (int symbol)
 {
-  CProcAds { reinterpret_cast <LPVOID *> (&AdsGetDllVersion),                _T ("_AdsGetDllVersion@0")                 },
-  CProcAds { reinterpret_cast <LPVOID *> (&AdsPortOpen),                     _T ("_AdsPortOpen@0")                      },
-  CProcAds { reinterpret_cast <LPVOID *> (&AdsPortClose),                    _T ("_AdsPortClose@0")                     },
-  CProcAds { reinterpret_cast <LPVOID *> (&AdsGetLocalAddress),              _T ("_AdsGetLocalAddress@4")               },
-  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncWriteReq),                 _T ("_AdsSyncWriteReq@20")                 },
-  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncReadWriteReq),             _T ("_AdsSyncReadWriteReq@28")             },
-  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncAddDeviceNotificationReq), _T ("_AdsSyncAddDeviceNotificationReq@28") },
-  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncDelDeviceNotificationReq), _T ("_AdsSyncDelDeviceNotificationReq@8")  }
-};
+  AdsSymbolEntry l_symbolEntry {};
 
-CString                   const CTwinCATADS::VAR_ACCELERATION      (_T ("Acceleration"));
-CString                   const CTwinCATADS::VAR_DECELERATION      (_T ("Deceleration"));
-CString                   const CTwinCATADS::VAR_JERK              (_T ("Jerk"));
-CString                   const CTwinCATADS::VAR_POSITION          (_T ("Position"));
-CString                   const CTwinCATADS::VAR_VELOCITY          (_T ("Velocity"));
-CString                   const CTwinCATADS::VAR_DIRECTION         (_T ("Direction"));
-CString                   const CTwinCATADS::VAR_BEGINMOTION       (_T ("BeginMotion"));
-CString                   const CTwinCATADS::VAR_STOPMOTION        (_T ("StopMotion"));
-CString                   const CTwinCATADS::VAR_MOTIONCOMPLETE    (_T ("MotionComplete"));
-CString                   const CTwinCATADS::VAR_MOTIONSTOPPED     (_T ("MotionStopped"));
-CString                   const CTwinCATADS::VAR_MOTIONFAULTED     (_T ("MotionFaulted"));
-CString                   const CTwinCATADS::VAR_RUNPROGRAM        (_T ("RunProgram"));
-CString                   const CTwinCATADS::VAR_STOPPROGRAM       (_T ("StopProgram"));
-CString                   const CTwinCATADS::VAR_PROGRAMCOMPLETE   (_T ("ProgramComplete"));
-CString                   const CTwinCATADS::VAR_FAULTCODE         (_T ("FaultCode"));
-CString                   const CTwinCATADS::VAR_PROGRAMSTATUS     (_T ("ProgramStatus"));
-CString                   const CTwinCATADS::VAR_ACTUALPOSITION    (_T ("ActualPosition"));
-CString                   const CTwinCATADS::VAR_ACTUALVELOCITY    (_T ("ActualVelocity"));
-CString                   const CTwinCATADS::VAR_ANALOGINPUTS      (_T ("IOAnalogTask.Inputs.AnalogInputs"));
-CString                   const CTwinCATADS::VAR_ANALOGOUTPUTS     (_T ("IOAnalogTask.Outputs.AnalogOutputs"));
-CString                   const CTwinCATADS::VAR_DISCRETEINPUTS    (_T ("IODiscreteTask.Inputs.DiscreteInputs"));
-CString                   const CTwinCATADS::VAR_DISCRETEOUTPUTS   (_T ("IODiscreteTask.Outputs.DiscreteOutputs"));
+  if (auto const l_error (GetSymbolEntry (GetSymbolName (symbol), l_symbolEntry)); l_error != ADSERR_NOERR)
+    {
+      PDCLib::ThrowStringException (_T ("unable to read information for symbol %s; %s"), (LPCTSTR) GetSymbolName (symbol), (LPCTSTR) GetADSErrorMessage (l_error));
+    }
 
-CTwinCATADS::MC_Bool      const CTwinCATADS::MC_False              (0x00);
-CTwinCATADS::MC_Bool      const CTwinCATADS::MC_True               (0x01);
+  return l_symbolEntry.size;
+}
 
-CTwinCATADS::MC_Direction const CTwinCATADS::MC_None               (0);
-CTwinCATADS::MC_Direction const CTwinCATADS::MC_Positive           (1);
-CTwinCATADS::MC_Direction const CTwinCATADS::MC_Shortest           (2);
-CTwinCATADS::MC_Direction const CTwinCATADS::MC_Negative           (3);
-CTwinCATADS::MC_Direction const CTwinCATADS::MC_Current            (4);
+void
+ITwinCATADS::ResolveAddresses (std::vector <int> const & symbols)
+{
+  // the addresses are read up front, a write never waits for the symbol information...
 
-DWORD                     const CTwinCATADS::DRIVE_STATUS_OK       (::DRIVE_STATUS_OK);
+  std::unique_lock <std::mutex> l_handleGate { m_handleGate };
 
-DWORD                     const CTwinCATADS::PROGRAM_NO_FAULT      (::DRIVE_STATUS_OK);
-DWORD                     const CTwinCATADS::PROGRAM_STOPPED_FAULT (0x00EC);
+  ResolveAddresses_ (symbols);
+}
 
-CTwinCATADS::MC_UDInt     const CTwinCATADS::AXIS_NO_FAULT         (0x00000000);
-CTwinCATADS::MC_UDInt     const CTwinCATADS::AXIS_STOPPED_FAULT    (0x00004B00);
+void
+ITwinCATADS::ResolveAddresses_ (std::vector <int> const & symbols)
+{
+  std::vector <int> l_symbols;
 
-std::array <CString, 268> const CTwinCATADS::m_programStatusMessage
+  for (auto&& l_symbol : symbols)
+    {
+      if (m_symbol[l_symbol].address == EAddress::Unknown)
+        {
+          l_symbols.push_back (l_symbol);
+        }
+    }
+
+  if (l_symbols.size () > 1)
+    {
+      // sum read/write request: list of {IGrp, IOffs, RLength, WLength} followed by list of data; each
+      // entry is followed by the name, type and comment, the read is sized for a short type and comment...
+
+      std::vector <SSumReadWriteReq> l_sumReadWriteReq;
+      std::vector <char> l_symbolData;
+      size_t l_cbReadData (0);
+
+      for (auto&& l_symbol : l_symbols)
+        {
+          std::vector <char> l_symbolName;
+
+          PDCLib::StringToVector (m_symbol[l_symbol].symbolName, l_symbolName);
+
+          auto const l_cbSymbolName (l_symbolName.size () * sizeof (l_symbolName[0]));
+          auto const l_readLength (sizeof (AdsSymbolEntry) + l_cbSymbolName + SYMBOL_INFO_SIZE);
+
+          l_sumReadWriteReq.push_back ({ ADSIGRP_SYM_INFOBYNAMEEX, 0, static_cast <ULONG> (l_readLength), static_cast <ULONG> (l_cbSymbolName) });
+
+          l_symbolData.insert (l_symbolData.end (), l_symbolName.begin (), l_symbolName.end ());
+
+          l_cbReadData += sizeof (SSumReadWriteRes) + l_readLength;
+        }
+
+      std::vector <BYTE> l_writeData (reinterpret_cast <BYTE const *> (&l_sumReadWriteReq[0]),
+                                      reinterpret_cast <BYTE const *> (&l_sumReadWriteReq[0] + l_sumReadWriteReq.size ()));
+
+      l_writeData.insert (l_writeData.end (), l_symbolData.begin (), l_symbolData.end ());
+
+      // sum read/write response: list of {result, RLength} followed by list of data...
+
+      std::vector <BYTE> l_readData (l_cbReadData);
+
+      auto const l_error (CallAPI ([this, &l_symbols, &l_readData, &l_writeData] (auto & amsAddr)
+                                   {
+                                     return SyncReadWriteReq (amsAddr,
+                                                              ADSIGRP_SUMUP_READWRITE,
+                                                              static_cast <unsigned long> (l_symbols.size ()),
+                                                              static_cast <unsigned long> (l_readData.size ()),
+                                                              &l_readData[0],
+                                                              static_cast <unsigned long> (l_writeData.size ()),
+                                                              &l_writeData[0]);
+                                   }));
+
+      if (l_error == ADSERR_NOERR)
+        {
+          auto const l_sumReadWriteRes (reinterpret_cast <SSumReadWriteRes const *> (&l_readData[0]));
+
+          auto l_pData (&l_readData[0] + l_symbols.size () * sizeof (SSumReadWriteRes));
+
+          for (size_t l_i (0); l_i < l_symbols.size (); ++l_i)
+            {
+              auto const l_readLength (l_sumReadWriteRes[l_i].readLength);
+
+              if (l_pData + l_readLength > &l_readData[0] + l_readData.size ())
+                {
+                  break;
+                }
+
+              // an entry too long for its read is left for a read of its own...
+
+              if ((l_sumReadWriteRes[l_i].result == ADSERR_NOERR) && (l_readLength >= sizeof (AdsSymbolEntry)))
+                {
+                  SetAddress_ (l_symbols[l_i], ADSERR_NOERR, *reinterpret_cast <AdsSymbolEntry const *> (l_pData));
+                }
+              else if (l_sumReadWriteRes[l_i].result != ADSERR_DEVICE_INVALIDSIZE)
+                {
+                  SetAddress_ (l_symbols[l_i], (l_sumReadWriteRes[l_i].result != ADSERR_NOERR) ? static_cast <long> (l_sumReadWriteRes[l_i].result) : ADSERR_CLIENT_SYNCRESINVALID, AdsSymbolEntry {});
+                }
+
+              l_pData += l_readLength;
+            }
+        }
+      else if ((l_error != ADSERR_DEVICE_SRVNOTSUPP) && (l_error != ADSERR_DEVICE_INVALIDGRP))
+        {
+          // not fatal, the symbols are read one at a time...
+
+          PDCLib::Trace (_T ("unable to read information for %ld symbols; %s"), static_cast <int> (l_symbols.size ()), (LPCTSTR) GetADSErrorMessage (l_error));
+        }
+    }
+
+  // a symbol the sum request did not resolve is read on its own, a target without the symbol
+  // information service is not asked again for the rest...
+
+  for (auto&& l_symbol : l_symbols)
+    {
+      if (m_symbol[l_symbol].address == EAddress::Unknown)
+        {
+          AdsSymbolEntry l_symbolEntry {};
+
+          auto const l_error (GetSymbolEntry (m_symbol[l_symbol].symbolName, l_symbolEntry));
+
+          SetAddress_ (l_symbol, l_error, l_symbolEntry);
+
+          if ((l_error == ADSERR_DEVICE_SRVNOTSUPP) || (l_error == ADSERR_DEVICE_INVALIDGRP))
+            {
+              for (auto&& l_symbol_ : l_symbols)
+                {
+                  if (m_symbol[l_symbol_].address == EAddress::Unknown)
+                    {
+                      m_symbol[l_symbol_].address = EAddress::Unavailable;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void
+ITwinCATADS::SetAddress_ (int symbol, long error, AdsSymbolEntry const & symbolEntry)
 {
-  /* 0x0000 */ _T ("Drive initialization is incomplete"),
-  /* 0x0001 */ _T ("Drive initialization is running"),
-  /* 0x0002 */ _T ("Drive initialization is complete, drives OK"),
-  /* 0x0003 */ _T ("Axis 1 has faulted"),
-  /* 0x0004 */ _T ("Axis 2 has faulted"),
-  /* 0x0005 */ _T ("Axis 3 has faulted"),
-  /* 0x0006 */ _T ("Axis 4 has faulted"),
-  /* 0x0007 */ _T ("Axis 5 has faulted"),
+  auto & l_symbol (m_symbol[symbol]);
+
+  if (error == ADSERR_NOERR)
+    {
+      l_symbol.address     = EAddress::Resolved;
+      l_symbol.indexGroup  = symbolEntry.iGroup;
+      l_symbol.indexOffset = symbolEntry.iOffs;
+      l_symbol.size        = symbolEntry.size;
+    }
+  else
+    {
+      if ((error != ADSERR_DEVICE_SRVNOTSUPP) && (error != ADSERR_DEVICE_INVALIDGRP))
+        {
+          PDCLib::Trace (_T ("unable to read information for symbol %s; %s"), (LPCTSTR) l_symbol.symbolName, (LPCTSTR) GetADSErrorMessage (error));
+        }
+
+      l_symbol.address = EAddress::Unavailable;
+    }
+}
+
+bool
+ITwinCATADS::GetAddress_ (int symbol, size_t offset, size_t cbLength, ULONG & indexGroup, ULONG & indexOffset)
+{
+  // once an online change is reported the addresses may point anywhere, the symbols are accessed by
+  // handle (which the PLC invalidates) until the rebind has read them again...
+
+  if (m_isRebindPending)
+    {
+      return false;
+    }
+
+  // the addresses are only read by ResolveAddresses and the rebind, a symbol without one is accessed by handle...
+
+  auto const & l_symbol (m_symbol[symbol]);
+
+  if ((l_symbol.address != EAddress::Resolved) || ((offset + cbLength) > l_symbol.size))
+    {
+      return false;
+    }
+
+  indexGroup  = l_symbol.indexGroup;
+  indexOffset = l_symbol.indexOffset + static_cast <ULONG> (offset);
+
+  return true;
+}
+
+bool
+ITwinCATADS::SetElement (int symbol, size_t offset, size_t cbLength, void const * pData)
+{
+  ULONG l_indexGroup (0);
+  ULONG l_indexOffset (0);
+
+  if (std::unique_lock <std::mutex> l_handleGate { m_handleGate }; !GetAddress_ (symbol, offset, cbLength, l_indexGroup, l_indexOffset))
+    {
+      return false;
+    }
+
+  auto const l_error (CallAPI ([this, l_indexGroup, l_indexOffset, cbLength, pData] (auto & amsAddr)
+                               {
+                                 return SyncWriteReq (amsAddr, l_indexGroup, l_indexOffset, static_cast <unsigned long> (cbLength), const_cast <void *> (pData));
+                               }));
+
+  if (l_error != ADSERR_NOERR)
+    {
+      PDCLib::ThrowStringException (_T ("unable to write symbol %s at offset %lu; %s"), (LPCTSTR) GetSymbolName (symbol), static_cast <ULONG> (offset), (LPCTSTR) GetADSErrorMessage (l_error));
+    }
+
+  return true;
+}
+
+long
+ITwinCATADS::GetSymbolEntry (CString const & symbolName, AdsSymbolEntry & symbolEntry)
+{
+  // symbol information: the entry is followed by the name, type and comment, only the entry is of interest;
+  // the read is sized for a short type and comment, a longer one is read again with room for the longest...
+
+  std::vector <char> l_symbolName;
+
+  PDCLib::StringToVector (symbolName, l_symbolName);
+
+  std::vector <BYTE> l_readData (sizeof (AdsSymbolEntry) + l_symbolName.size () * sizeof (l_symbolName[0]) + SYMBOL_INFO_SIZE);
+
+  auto const l_getSymbolEntry ([this, &l_readData, &l_symbolName] (auto & amsAddr)
+                               {
+                                 return SyncReadWriteReq (amsAddr,
+                                                          ADSIGRP_SYM_INFOBYNAMEEX,
+                                                          0,
+                                                          static_cast <unsigned long> (l_readData.size ()),
+                                                          &l_readData[0],
+                                                          static_cast <unsigned long> (l_symbolName.size () * sizeof (l_symbolName[0])),
+                                                          &l_symbolName[0]);
+                               });
+
+  auto l_error (CallAPI (l_getSymbolEntry));
+
+  if (l_error == ADSERR_DEVICE_INVALIDSIZE)
+    {
+      l_readData.resize (sizeof (AdsSymbolEntry) + 3 * (USHRT_MAX + 1));
+
+      l_error = CallAPI (l_getSymbolEntry);
+    }
+
+  if (l_error == ADSERR_NOERR)
+    {
+      symbolEntry = *reinterpret_cast <AdsSymbolEntry const *> (&l_readData[0]);
+    }
+
+  return l_error;
+}
+
+CString
+ITwinCATADS::GetSymbolName (int symbol)
+{
+  std::unique_lock <std::mutex> l_handleGate { m_handleGate };
+
+  return m_symbol[symbol].symbolName;
+}
+
+void
+ITwinCATADS::WatchSymbolVersion (void)
+{
+  // the version the notification is compared against is read first...
+
+  CheckSymbolVersion ();
+
+  std::unique_lock <std::mutex> l_notificationGate { m_notificationGate };
+
+  // a shared connection is watched once for all of its owners...
+
+  if (!m_isSymbolVersionNotified)
+    {
+      AddSymbolVersionNotification_ ();
+    }
+}
+
+void
+ITwinCATADS::AddSymbolVersionNotification_ (void)
+{
+  // m_notificationGate must be held...
+
+  if (IsStdCallNotification ())
+    {
+      m_symbolVersionReq.pNoteFunc = reinterpret_cast <void *> (&OnSymbolVersionTC3);
+    }
+  else
+    {
+      m_symbolVersionReq.pNoteFunc = reinterpret_cast <void *> (&OnSymbolVersionTC2);
+    }
+
+  std::vector <SNotificationReq> l_notificationReq (1, m_symbolVersionReq);
+
+  auto l_error (CallAPI ([this, &l_notificationReq] (auto & amsAddr) { return SumAddDeviceNotificationReq (amsAddr, l_notificationReq); }));
+
+  if (l_error == ADSERR_NOERR)
+    {
+      l_error = l_notificationReq[0].result;
+    }
+
+  if (l_error == ADSERR_NOERR)
+    {
+      m_symbolVersionReq.hNotification = l_notificationReq[0].hNotification;
+
+      m_isSymbolVersionNotified = true;
+    }
+  else if ((l_error != ADSERR_DEVICE_SRVNOTSUPP) && (l_error != ADSERR_DEVICE_INVALIDGRP) && (l_error != ADSERR_DEVICE_SYMBOLNOTFOUND))
+    {
+      PDCLib::Trace (_T ("unable to register notification for TwinCAT ADS symbol version, polling it instead; %s"), (LPCTSTR) GetADSErrorMessage (l_error));
+    }
+}
+
+void
+ITwinCATADS::OnSymbolVersionTC2 (AmsAddr *, AdsNotificationHeader * pNotification, unsigned long hUser)
+{
+  reinterpret_cast <ITwinCATADS *> (hUser)->OnSymbolVersion (pNotification);
+}
+
+void __stdcall
+ITwinCATADS::OnSymbolVersionTC3 (AmsAddr *, AdsNotificationHeader * pNotification, unsigned long hUser)
+{
+  reinterpret_cast <ITwinCATADS *> (hUser)->OnSymbolVersion (pNotification);
+}
+
+void
+ITwinCATADS::OnSymbolVersion (AdsNotificationHeader const * pNotification)
+{
+  // the first sample is the version the notification was added with, an online change or restart
+  // sends a different one; the owner rebinds on its next update and until then no address is used...
+
+  if ((pNotification->cbSampleSize >= sizeof (BYTE)) && (m_symbolVersion != -1) && (m_symbolVersion != pNotification->data[0]))
+    {
+      SetRebindPending ();
+    }
+}
+
+bool
+ITwinCATADS::CheckSymbolVersion (void)
+{
+  // a target that notifies a change is not polled...
+
+  if (m_isSymbolVersionNotified && (m_symbolVersion != -1))
+    {
+      return false;
+    }
+
+  BYTE l_symbolVersion (0);
+
+  if (auto const l_error (GetSymbolVersion (l_symbolVersion)); l_error != ADSERR_NOERR)
+    {
+      PDCLib::Trace (_T ("unable to read TwinCAT ADS symbol version; %s"), (LPCTSTR) GetADSErrorMessage (l_error));
+
+      return false;
+    }
+
+  if (m_symbolVersion == -1)
+    {
+      m_symbolVersion = l_symbolVersion;
+    }
+  else if (m_symbolVersion != l_symbolVersion)
+    {
+      Rebind ();
+
+      return true;
+    }
+
+  return false;
+}
+
+CString
+ITwinCATADS::Rebind (void)
+{
+  CString l_errorMessage;
+
+  std::unique_lock <std::mutex> l_notificationGate { m_notificationGate };
+
+  // a request for another rebind that arrives while this one runs is kept...
+
+  m_isRebindPending = false;
+
+  PDCLib::Trace (_T ("rebinding TwinCAT ADS symbols on port %ld"), m_port);
+
+  // the stale notifications are deleted on a best effort basis, the target may already have dropped them...
+
+  if (!m_notificationReq.empty ())
+    {
+      CallAPI ([this] (auto & amsAddr) { return SumDelDeviceNotificationReq (amsAddr, m_notificationReq); });
+    }
+
+  auto const l_isSymbolVersionNotified (m_isSymbolVersionNotified.exchange (false));
+
+  if (l_isSymbolVersionNotified)
+    {
+      std::vector <SNotificationReq> l_notificationReq (1, m_symbolVersionReq);
+
+      CallAPI ([this, &l_notificationReq] (auto & amsAddr) { return SumDelDeviceNotificationReq (amsAddr, l_notificationReq); });
+    }
+
+  // the stale handles are not released, the symbol indices (and the application state behind them) are kept...
+
+  {
+    std::unique_lock <std::mutex> l_handleGate { m_handleGate };
+
+    std::vector <int> l_symbols;
+    std::vector <int> l_addressed;
+
+    for (int l_symbol (0); static_cast <size_t> (l_symbol) < m_symbol.size (); ++l_symbol)
+      {
+        // a symbol may have moved, the addresses that were read are read again below...
+
+        if (m_symbol[l_symbol].address != EAddress::Unknown)
+          {
+            m_symbol[l_symbol].address = EAddress::Unknown;
+
+            l_addressed.push_back (l_symbol);
+          }
+
+        if (m_symbol[l_symbol].isResolved)
+          {
+            m_symbol[l_symbol].isResolved = false;
+
+            l_symbols.push_back (l_symbol);
+          }
+      }
+
+    GetHandles_ (l_symbols);
+
+    // a symbol the sum request could not resolve is tried on its own to learn why...
+
+    for (auto&& l_symbol : l_symbols)
+      {
+        if (!m_symbol[l_symbol].isResolved)
+          {
+            try
+              {
+                GetHandle_ (l_symbol);
+              }
+            catch (CString const & errorMessage)
+              {
+                PDCLib::Trace (_T ("%s"), (LPCTSTR) errorMessage);
+
+                if (l_errorMessage.IsEmpty ())
+                  {
+                    l_errorMessage = errorMessage;
+                  }
+              }
+          }
+      }
+
+    ResolveAddresses_ (l_addressed);
+
+    for (auto&& l_notificationReq : m_notificationReq)
+      {
+        try
+          {
+            l_notificationReq.hSymbol = GetHandle_ (l_notificationReq.symbol);
+            l_notificationReq.result  = ADSERR_NOERR;
+          }
+        catch (CString const & errorMessage)
+          {
+            PDCLib::Trace (_T ("%s"), (LPCTSTR) errorMessage);
+
+            if (l_errorMessage.IsEmpty ())
+              {
+                l_errorMessage = errorMessage;
+              }
+
+            l_notificationReq.result = ADSERR_DEVICE_SYMBOLNOTFOUND;
+          }
+      }
+  }
+
+  m_notificationReq.erase (std::remove_if (m_notificationReq.begin (),
+                                           m_notificationReq.end (),
+                                           [] (auto const & notificationReq) { return notificationReq.result != ADSERR_NOERR; }),
+                           m_notificationReq.end ());
+
+  if (!m_notificationReq.empty ())
+    {
+      if (auto const l_error (CallAPI ([this] (auto & amsAddr) { return SumAddDeviceNotificationReq (amsAddr, m_notificationReq); })); l_error != ADSERR_NOERR)
+        {
+          auto const l_errorMessage_ (PDCLib::StringWithFormat (_T ("unable to register notifications for %ld symbols; %s"), static_cast <int> (m_notificationReq.size ()), (LPCTSTR) GetADSErrorMessage (l_error)));
+
+          PDCLib::Trace (_T ("%s"), (LPCTSTR) l_errorMessage_);
+
+          if (l_errorMessage.IsEmpty ())
+            {
+              l_errorMessage = l_errorMessage_;
+            }
+
+          m_notificationReq.clear ();
+        }
+      else
+        {
+          for (auto&& l_notificationReq : m_notificationReq)
+            {
+              if (l_notificationReq.result != ADSERR_NOERR)
+                {
+                  auto const l_errorMessage_ (PDCLib::StringWithFormat (_T ("unable to register notification for symbol %s; %s"), (LPCTSTR) GetSymbolName (l_notificationReq.symbol), (LPCTSTR) GetADSErrorMessage (l_notificationReq.result)));
+
+                  PDCLib::Trace (_T ("%s"), (LPCTSTR) l_errorMessage_);
+
+                  if (l_errorMessage.IsEmpty ())
+                    {
+                      l_errorMessage = l_errorMessage_;
+                    }
+                }
+            }
+
+          m_notificationReq.erase (std::remove_if (m_notificationReq.begin (),
+                                                   m_notificationReq.end (),
+                                                   [] (auto const & notificationReq) { return notificationReq.result != ADSERR_NOERR; }),
+                                   m_notificationReq.end ());
+        }
+    }
+
+  if (BYTE l_symbolVersion (0); GetSymbolVersion (l_symbolVersion) == ADSERR_NOERR)
+    {
+      m_symbolVersion = l_symbolVersion;
+    }
+
+  // the symbol version notification is added after the version is read, its first sample matches it...
+
+  if (l_isSymbolVersionNotified)
+    {
+      AddSymbolVersionNotification_ ();
+    }
+
+  // every owner learns of the rebind on its next write or update, whoever started it...
+
+  ++m_rebindCount;
+
+  return l_errorMessage;
+}
+
+long
+ITwinCATADS::GetSymbolVersion (BYTE & symbolVersion)
+{
+  return CallAPI ([this, &symbolVersion] (auto & amsAddr)
+                  {
+                    return SyncReadWriteReq (amsAddr, ADSIGRP_SYM_VERSION, 0, sizeof (symbolVersion), &symbolVersion, 0, nullptr);
+                  });
+}
+
+bool
+ITwinCATADS::IsSymbolVersionInvalid (long error)
+{
+  return (error == ADSERR_DEVICE_SYMBOLVERSIONINVALID) || (error == ADSERR_DEVICE_NOTIFYHNDINVALID);
+}
+
+void
+ITwinCATADS::Create (CString        const & adsDllFilename,
+                     CAdsDllVersion const & adsDllVersion,
+                     CAdsApi        const & adsApi,
+                     WORD                   portNumber,
+                     CAdsApi        const & optionalAdsApi)
+{
+  if (std::unique_lock <std::mutex> l_apiGate { m_apiGate }; m_hModule == nullptr)
+    {
+      try
+        {
+          LoadLibrary (adsDllFilename, adsDllVersion);
+
+          for (auto&& l_adsApi : adsApi)
+            {
+              GetProcAddress (l_adsApi);
+            }
+
+          if (!std::all_of (optionalAdsApi.begin (), optionalAdsApi.end (), FindProcAddress))
+            {
+              for (auto&& l_adsApi : optionalAdsApi)
+                {
+                  *std::get <0> (l_adsApi) = nullptr;
+                }
+            }
+        }
+      catch (CString const & errorMessage)
+        {
+          FreeLibrary ();
+
+          PDCLib::ThrowStringException (_T ("unable to load library: %s; %s"), (LPCTSTR) adsDllFilename, (LPCTSTR) errorMessage);
+        }
+
+      auto const l_dllVersion (GetDllVersion ());
+
+      auto const l_adsVersion (reinterpret_cast <AdsVersion const *> (&l_dllVersion));
+
+      PDCLib::Trace (_T ("TwinCAT ADS Version  : %ld"), static_cast <int> (l_adsVersion->version));
+      PDCLib::Trace (_T ("TwinCAT ADS Revision : %ld"), static_cast <int> (l_adsVersion->revision));
+      PDCLib::Trace (_T ("TwinCAT ADS Build    : %ld"), static_cast <int> (l_adsVersion->build));
+    }
+
+  Open (portNumber);
+}
+
+void
+ITwinCATADS::Open (WORD portNumber)
+{
+  // each instance opens its own client port...
+
+  CallAPI ([this, portNumber] (auto & amsAddr)
+           {
+             if ((m_port = PortOpen ()) == 0)
+               {
+                 PDCLib::ThrowStringException (_T ("unable to open TwinCAT ADS port"));
+               }
+
+             PDCLib::Trace (_T ("TwinCAT ADS Port     : %ld"), m_port);
+
+             auto const l_error (GetLocalAddress (amsAddr));
+
+             if (l_error == ADSERR_NOERR)
+               {
+                 amsAddr.port = portNumber;
+
+                 return;
+               }
+
+             PortClose ();
+
+             m_port = 0;
+
+             PDCLib::ThrowStringException (_T ("unable to get TwinCAT ADS local address; %s"), (LPCTSTR) GetADSErrorMessage (l_error));
+           });
+}
+
+void
+ITwinCATADS::Destroy (void)
+{
+  if (m_port != 0)
+    {
+      UnRegisterNotification ();
+
+      CallAPI ([this] (auto &) { PortClose (); });
+
+      m_port = 0;
+    }
+
+  EraseExpiredConnections ();
+
+  if (std::unique_lock <std::mutex> l_apiGate { m_apiGate }; --m_refCount == 0)
+    {
+      FreeLibrary ();
+    }
+}
+
+void
+ITwinCATADS::LoadLibrary (CString const & adsDllFilename, CAdsDllVersion const & adsDllVersion)
+{
+  if ((m_hModule = ::AfxLoadLibrary (adsDllFilename)) == nullptr)
+    {
+      PDCLib::ThrowStringException (_T ("%s"), (LPCTSTR) PDCLib::GetErrorMessage (::GetLastError ()));
+    }
+
+  std::vector <DWORD> l_adsDllVersion;
+
+  if (PDCLib::CVersionInfo l_versionInfo; l_versionInfo.Create (m_hModule) && l_versionInfo.GetFileVersion (l_adsDllVersion))
+    {
+      if (l_adsDllVersion.size () == adsDllVersion.size ())
+        {
+          if (std::lexicographical_compare (begin (l_adsDllVersion), end (l_adsDllVersion), begin (adsDllVersion), end (adsDllVersion)))
+            {
+              PDCLib::ThrowStringException (_T ("minimum version requirement not satisfied"));
+            }
+
+          return;
+        }
+
+      PDCLib::ThrowStringException (_T ("invalid version information"));
+    }
+
+  PDCLib::ThrowStringException (_T ("unable to load version information"));
+}
+
+void
+ITwinCATADS::FreeLibrary (void)
+{
+  if (m_hModule)
+    {
+      VERIFY (::AfxFreeLibrary (m_hModule));
+
+      m_hModule = nullptr;
+    }
+}
+
+void
+ITwinCATADS::GetProcAddress (CProcAds const & procAds)
+{
+  if (!FindProcAddress (procAds))
+    {
+      PDCLib::ThrowStringException (_T ("unable to get procedure address for %s: %s"), (LPCTSTR) CString (std::get <1> (procAds)), (LPCTSTR) PDCLib::GetErrorMessage (::GetLastError ()));
+    }
+}
+
+bool
+ITwinCATADS::FindProcAddress (CProcAds const & procAds)
+{
+  std::vector <char> l_procName;
+
+  PDCLib::StringToVector (std::get <1> (procAds), l_procName);
+
+  return (*std::get <0> (procAds) = ::GetProcAddress (m_hModule, &l_procName[0])) != nullptr;
+}
+
+CString
+ITwinCATADS::GetADSErrorMessage (long error)
+{
+  if (auto const l_adsErrorMessage (m_adsErrorMessage.find (error)); l_adsErrorMessage == m_adsErrorMessage.end ())
+    {
+      if (error < WSABASEERR)
+        {
+          return PDCLib::StringWithFormat (_T ("unrecognized TwinCAT ADS error code (%ld)"), error);
+        }
+
+      return PDCLib::StringWithFormat (_T ("%s (%ld)"), (LPCTSTR) PDCLib::GetErrorMessage (error), error);
+    }
+  else
+    {
+      return PDCLib::StringWithFormat (_T ("%s (%ld)"), (LPCTSTR) std::get <1> (*l_adsErrorMessage), error);
+    }
+}
+
+class CTwinCATADS2 final : public ITwinCATADS
+{
+public:
+  explicit CTwinCATADS2 (void) = default;
+  virtual ~CTwinCATADS2 () { Destroy (); }
+
+  static CString GetConnectionKey (WORD portNumber) { return PDCLib::StringWithFormat (_T ("TC2:%u"), portNumber); }
+
+  virtual void Create (WORD portNumber) override final
+    {
+      ITwinCATADS::Create (ADSDLL_LIBRARY, ADSDLL_VERSION, m_adsApi, portNumber, m_adsApiEx);
+    }
+
+private:
+  // a router DLL without the port specific (Ex) interface has one client port for the process, it is
+  // shared by every instance and the requests are serialized across the process as they used to be...
+
+  static bool IsProcessWide (void) { return AdsPortOpenEx == nullptr; }
+
+  virtual long SyncWriteReq (AmsAddr       & amsAddr,
+                             unsigned long   indexGroup,
+                             unsigned long   indexOffset,
+                             unsigned long   length,
+                             void          * pData) override final
+    {
+      if (IsProcessWide ())
+        {
+          std::unique_lock <std::mutex> l_processGate { m_processGate };
+
+          return AdsSyncWriteReq (&amsAddr, indexGroup, indexOffset, length, pData);
+        }
+
+      return AdsSyncWriteReqEx (GetPort (), &amsAddr, indexGroup, indexOffset, length, pData);
+    }
+  virtual long SyncReadWriteReq (AmsAddr       & amsAddr,
+                                 unsigned long   indexGroup,
+                                 unsigned long   indexOffset,
+                                 unsigned long   cbReadLength,
+                                 void          * pReadData,
+                                 unsigned long   cbWriteLength,
+                                 void          * pWriteData) override final
+    {
+      if (IsProcessWide ())
+        {
+          std::unique_lock <std::mutex> l_processGate { m_processGate };
+
+          return AdsSyncReadWriteReq (&amsAddr, indexGroup, indexOffset, cbReadLength, pReadData, cbWriteLength, pWriteData);
+        }
+
+      unsigned long l_cbReturn (0);
+
+      return AdsSyncReadWriteReqEx2 (GetPort (), &amsAddr, indexGroup, indexOffset, cbReadLength, pReadData, cbWriteLength, pWriteData, &l_cbReturn);
+    }
+  virtual long SyncAddDeviceNotificationReq (AmsAddr               & amsAddr,
+                                             unsigned long           indexGroup,
+                                             unsigned long           indexOffset,
+                                             AdsNotificationAttrib * adsNotificationAttrib,
+                                             void                  * pNoteFunc,
+                                             unsigned long           hUser,
+                                             unsigned long         * pNotification) override final
+    {
+      if (IsProcessWide ())
+        {
+          std::unique_lock <std::mutex> l_processGate { m_processGate };
+
+          return AdsSyncAddDeviceNotificationReq (&amsAddr,
+                                                  indexGroup,
+                                                  indexOffset,
+                                                  adsNotificationAttrib,
+                                                  reinterpret_cast <PAdsNotificationFuncTC2> (pNoteFunc),
+                                                  hUser,
+                                                  pNotification);
+        }
+
+      return AdsSyncAddDeviceNotificationReqEx (GetPort (),
+                                                &amsAddr,
+                                                indexGroup,
+                                                indexOffset,
+                                                adsNotificationAttrib,
+                                                reinterpret_cast <PAdsNotificationFuncTC2> (pNoteFunc),
+                                                hUser,
+                                                pNotification);
+    }
+  virtual long SyncDelDeviceNotificationReq (AmsAddr       & amsAddr,
+                                             unsigned long   hNotification) override final
+    {
+      if (IsProcessWide ())
+        {
+          std::unique_lock <std::mutex> l_processGate { m_processGate };
+
+          return AdsSyncDelDeviceNotificationReq (&amsAddr, hNotification);
+        }
+
+      return AdsSyncDelDeviceNotificationReqEx (GetPort (), &amsAddr, hNotification);
+    }
+
+  // the ADS router DLL only dispatches callbacks for notifications it added itself...
+
+  virtual long SumAddDeviceNotificationReq (AmsAddr                        & amsAddr,
+                                            std::vector <SNotificationReq> & notificationReq) override final
+    {
+      return AddDeviceNotificationReqs (amsAddr, notificationReq);
+    }
+  virtual long SumDelDeviceNotificationReq (AmsAddr                        & amsAddr,
+                                            std::vector <SNotificationReq> & notificationReq) override final
+    {
+      return DelDeviceNotificationReqs (amsAddr, notificationReq);
+    }
+
+  virtual long PortOpen (void) override final;
+  virtual void PortClose (void) override final;
+  virtual long GetLocalAddress (AmsAddr & amsAddr) override final;
+  virtual long GetDllVersion (void) override final { return AdsGetDllVersion (); }
+  virtual bool IsStdCallNotification (void) const override final { return false; }
+
+  static CString                                const ADSDLL_LIBRARY;
+  static CAdsDllVersion                         const ADSDLL_VERSION;
+
+  static ProcAdsGetDllVersionTC2                      AdsGetDllVersion;
+  static ProcAdsPortOpenTC2                           AdsPortOpen;
+  static ProcAdsPortCloseTC2                          AdsPortClose;
+  static ProcAdsGetLocalAddressTC2                    AdsGetLocalAddress;
+  static ProcAdsSyncWriteReqTC2                       AdsSyncWriteReq;
+  static ProcAdsSyncReadWriteReqTC2                   AdsSyncReadWriteReq;
+  static ProcAdsSyncAddDeviceNotificationReqTC2       AdsSyncAddDeviceNotificationReq;
+  static ProcAdsSyncDelDeviceNotificationReqTC2       AdsSyncDelDeviceNotificationReq;
+  static ProcAdsPortOpenExTC2                         AdsPortOpenEx;
+  static ProcAdsPortCloseExTC2                        AdsPortCloseEx;
+  static ProcAdsGetLocalAddressExTC2                  AdsGetLocalAddressEx;
+  static ProcAdsSyncWriteReqExTC2                     AdsSyncWriteReqEx;
+  static ProcAdsSyncReadWriteReqEx2TC2                AdsSyncReadWriteReqEx2;
+  static ProcAdsSyncAddDeviceNotificationReqExTC2     AdsSyncAddDeviceNotificationReqEx;
+  static ProcAdsSyncDelDeviceNotificationReqExTC2     AdsSyncDelDeviceNotificationReqEx;
+
+  static CAdsApi                                const m_adsApi;
+  static CAdsApi                                const m_adsApiEx;
+
+  static std::mutex                                   m_processGate;
+  static long                                         m_processPort;
+  static int                                          m_processPortCount;
+
+public:
+  CTwinCATADS2 (CTwinCATADS2 const &) = delete;
+  CTwinCATADS2 & operator = (CTwinCATADS2 const &) = delete;
+};
+
+CString                                const CTwinCATADS2::ADSDLL_LIBRARY                    (_T ("AdsDll.dll"));
+CTwinCATADS2::CAdsDllVersion           const CTwinCATADS2::ADSDLL_VERSION                    { 2, 11, 0, 3 };
+
+ProcAdsGetDllVersionTC2                      CTwinCATADS2::AdsGetDllVersion                  (nullptr);
+ProcAdsPortOpenTC2                           CTwinCATADS2::AdsPortOpen                       (nullptr);
+ProcAdsPortCloseTC2                          CTwinCATADS2::AdsPortClose                      (nullptr);
+ProcAdsGetLocalAddressTC2                    CTwinCATADS2::AdsGetLocalAddress                (nullptr);
+ProcAdsSyncWriteReqTC2                       CTwinCATADS2::AdsSyncWriteReq                   (nullptr);
+ProcAdsSyncReadWriteReqTC2                   CTwinCATADS2::AdsSyncReadWriteReq               (nullptr);
+ProcAdsSyncAddDeviceNotificationReqTC2       CTwinCATADS2::AdsSyncAddDeviceNotificationReq   (nullptr);
+ProcAdsSyncDelDeviceNotificationReqTC2       CTwinCATADS2::AdsSyncDelDeviceNotificationReq   (nullptr);
+ProcAdsPortOpenExTC2                         CTwinCATADS2::AdsPortOpenEx                     (nullptr);
+ProcAdsPortCloseExTC2                        CTwinCATADS2::AdsPortCloseEx                    (nullptr);
+ProcAdsGetLocalAddressExTC2                  CTwinCATADS2::AdsGetLocalAddressEx              (nullptr);
+ProcAdsSyncWriteReqExTC2                     CTwinCATADS2::AdsSyncWriteReqEx                 (nullptr);
+ProcAdsSyncReadWriteReqEx2TC2                CTwinCATADS2::AdsSyncReadWriteReqEx2            (nullptr);
+ProcAdsSyncAddDeviceNotificationReqExTC2     CTwinCATADS2::AdsSyncAddDeviceNotificationReqEx (nullptr);
+ProcAdsSyncDelDeviceNotificationReqExTC2     CTwinCATADS2::AdsSyncDelDeviceNotificationReqEx (nullptr);
+
+CTwinCATADS2::CAdsApi                  const CTwinCATADS2::m_adsApi
+{
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsGetDllVersion),                  _T ("AdsGetDllVersion")                  },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsPortOpen),                       _T ("AdsPortOpen")                       },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsPortClose),                      _T ("AdsPortClose")                      },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsGetLocalAddress),                _T ("AdsGetLocalAddress")                },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncWriteReq),                   _T ("AdsSyncWriteReq")                   },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncReadWriteReq),               _T ("AdsSyncReadWriteReq")               },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncAddDeviceNotificationReq),   _T ("AdsSyncAddDeviceNotificationReq")   },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncDelDeviceNotificationReq),   _T ("AdsSyncDelDeviceNotificationReq")   }
+};
+
+CTwinCATADS2::CAdsApi                  const CTwinCATADS2::m_adsApiEx
+{
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsPortOpenEx),                     _T ("AdsPortOpenEx")                     },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsPortCloseEx),                    _T ("AdsPortCloseEx")                    },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsGetLocalAddressEx),              _T ("AdsGetLocalAddressEx")              },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncWriteReqEx),                 _T ("AdsSyncWriteReqEx")                 },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncReadWriteReqEx2),            _T ("AdsSyncReadWriteReqEx2")            },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncAddDeviceNotificationReqEx), _T ("AdsSyncAddDeviceNotificationReqEx") },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncDelDeviceNotificationReqEx), _T ("AdsSyncDelDeviceNotificationReqEx") }
+};
+
+std::mutex                                   CTwinCATADS2::m_processGate;
+long                                         CTwinCATADS2::m_processPort                     (0);
+int                                          CTwinCATADS2::m_processPortCount                (0);
+
+long
+CTwinCATADS2::PortOpen (void)
+{
+  if (!IsProcessWide ())
+    {
+      return AdsPortOpenEx ();
+    }
+
+  // the process wide port is opened by the first instance and closed by the last...
+
+  std::unique_lock <std::mutex> l_processGate { m_processGate };
+
+  if (m_processPortCount == 0)
+    {
+      PDCLib::Trace (_T ("TwinCAT ADS router DLL without the port specific interface, requests are serialized across the process"));
+
+      if ((m_processPort = AdsPortOpen ()) == 0)
+        {
+          return 0;
+        }
+    }
+
+  ++m_processPortCount;
+
+  return m_processPort;
+}
+
+void
+CTwinCATADS2::PortClose (void)
+{
+  if (!IsProcessWide ())
+    {
+      AdsPortCloseEx (GetPort ());
+
+      return;
+    }
+
+  std::unique_lock <std::mutex> l_processGate { m_processGate };
+
+  if ((m_processPortCount > 0) && (--m_processPortCount == 0))
+    {
+      AdsPortClose ();
+
+      m_processPort = 0;
+    }
+}
+
+long
+CTwinCATADS2::GetLocalAddress (AmsAddr & amsAddr)
+{
+  if (IsProcessWide ())
+    {
+      std::unique_lock <std::mutex> l_processGate { m_processGate };
+
+      return AdsGetLocalAddress (&amsAddr);
+    }
+
+  return AdsGetLocalAddressEx (GetPort (), &amsAddr);
+}
+
+class CTwinCATADS3 final : public ITwinCATADS
+{
+public:
+  explicit CTwinCATADS3 (void) = default;
+  virtual ~CTwinCATADS3 () { Destroy (); }
+
+  static CString GetConnectionKey (WORD portNumber) { return PDCLib::StringWithFormat (_T ("TC3:%u"), portNumber); }
+
+  virtual void Create (WORD portNumber) override final
+    {
+      ITwinCATADS::Create (ADSDLL_LIBRARY, ADSDLL_VERSION, m_adsApi, portNumber);
+    }
+
+private:
+  virtual long SyncWriteReq (AmsAddr       & amsAddr,
+                             unsigned long   indexGroup,
+                             unsigned long   indexOffset,
+                             unsigned long   length,
+                             void          * pData) override final
+    {
+      return AdsSyncWriteReqEx (GetPort (), &amsAddr, indexGroup, indexOffset, length, pData);
+    }
+  virtual long SyncReadWriteReq (AmsAddr       & amsAddr,
+                                 unsigned long   indexGroup,
+                                 unsigned long   indexOffset,
+                                 unsigned long   cbReadLength,
+                                 void          * pReadData,
+                                 unsigned long   cbWriteLength,
+                                 void          * pWriteData) override final
+    {
+      unsigned long l_cbReturn (0);
+
+      return AdsSyncReadWriteReqEx2 (GetPort (), &amsAddr, indexGroup, indexOffset, cbReadLength, pReadData, cbWriteLength, pWriteData, &l_cbReturn);
+    }
+  virtual long SyncAddDeviceNotificationReq (AmsAddr               & amsAddr,
+                                             unsigned long           indexGroup,
+                                             unsigned long           indexOffset,
+                                             AdsNotificationAttrib * adsNotificationAttrib,
+                                             void                  * pNoteFunc,
+                                             unsigned long           hUser,
+                                             unsigned long         * pNotification) override final
+    {
+      return AdsSyncAddDeviceNotificationReqEx (GetPort (),
+                                                &amsAddr,
+                                                indexGroup,
+                                                indexOffset,
+                                                adsNotificationAttrib,
+                                                reinterpret_cast <PAdsNotificationFuncTC3> (pNoteFunc),
+                                                hUser,
+                                                pNotification);
+    }
+  virtual long SyncDelDeviceNotificationReq (AmsAddr       & amsAddr,
+                                             unsigned long   hNotification) override final
+    {
+      return AdsSyncDelDeviceNotificationReqEx (GetPort (), &amsAddr, hNotification);
+    }
+
+  // the ADS router DLL only dispatches callbacks for notifications it added itself...
+
+  virtual long SumAddDeviceNotificationReq (AmsAddr                        & amsAddr,
+                                            std::vector <SNotificationReq> & notificationReq) override final
+    {
+      return AddDeviceNotificationReqs (amsAddr, notificationReq);
+    }
+  virtual long SumDelDeviceNotificationReq (AmsAddr                        & amsAddr,
+                                            std::vector <SNotificationReq> & notificationReq) override final
+    {
+      return DelDeviceNotificationReqs (amsAddr, notificationReq);
+    }
+
+  virtual long PortOpen (void) override final { return AdsPortOpenEx (); }
+  virtual void PortClose (void) override final { AdsPortCloseEx (GetPort ()); }
+  virtual long GetLocalAddress (AmsAddr & amsAddr) override final { return AdsGetLocalAddressEx (GetPort (), &amsAddr); }
+  virtual long GetDllVersion (void) override final { return AdsGetDllVersion (); }
+
+  static CString                                const ADSDLL_LIBRARY;
+  static CAdsDllVersion                         const ADSDLL_VERSION;
+
+  static ProcAdsGetDllVersionTC3                      AdsGetDllVersion;
+  static ProcAdsPortOpenExTC3                         AdsPortOpenEx;
+  static ProcAdsPortCloseExTC3                        AdsPortCloseEx;
+  static ProcAdsGetLocalAddressExTC3                  AdsGetLocalAddressEx;
+  static ProcAdsSyncWriteReqExTC3                     AdsSyncWriteReqEx;
+  static ProcAdsSyncReadWriteReqEx2TC3                AdsSyncReadWriteReqEx2;
+  static ProcAdsSyncAddDeviceNotificationReqExTC3     AdsSyncAddDeviceNotificationReqEx;
+  static ProcAdsSyncDelDeviceNotificationReqExTC3     AdsSyncDelDeviceNotificationReqEx;
+
+  static CAdsApi                                const m_adsApi;
+
+public:
+  CTwinCATADS3 (CTwinCATADS3 const &) = delete;
+  CTwinCATADS3 & operator = (CTwinCATADS3 const &) = delete;
+};
+
+CString                                const CTwinCATADS3::ADSDLL_LIBRARY                    (_T ("TcAdsDll.dll"));
+CTwinCATADS3::CAdsDllVersion           const CTwinCATADS3::ADSDLL_VERSION                    { 2, 11, 0, 41 };
+
+ProcAdsGetDllVersionTC3                      CTwinCATADS3::AdsGetDllVersion                  (nullptr);
+ProcAdsPortOpenExTC3                         CTwinCATADS3::AdsPortOpenEx                     (nullptr);
+ProcAdsPortCloseExTC3                        CTwinCATADS3::AdsPortCloseEx                    (nullptr);
+ProcAdsGetLocalAddressExTC3                  CTwinCATADS3::AdsGetLocalAddressEx              (nullptr);
+ProcAdsSyncWriteReqExTC3                     CTwinCATADS3::AdsSyncWriteReqEx                 (nullptr);
+ProcAdsSyncReadWriteReqEx2TC3                CTwinCATADS3::AdsSyncReadWriteReqEx2            (nullptr);
+ProcAdsSyncAddDeviceNotificationReqExTC3     CTwinCATADS3::AdsSyncAddDeviceNotificationReqEx (nullptr);
+ProcAdsSyncDelDeviceNotificationReqExTC3     CTwinCATADS3::AdsSyncDelDeviceNotificationReqEx (nullptr);
+
+CTwinCATADS3::CAdsApi                  const CTwinCATADS3::m_adsApi
+{
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsGetDllVersion),                  _T ("_AdsGetDllVersion@0")                   },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsPortOpenEx),                     _T ("_AdsPortOpenEx@0")                      },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsPortCloseEx),                    _T ("_AdsPortCloseEx@4")                     },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsGetLocalAddressEx),              _T ("_AdsGetLocalAddressEx@8")               },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncWriteReqEx),                 _T ("_AdsSyncWriteReqEx@24")                 },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncReadWriteReqEx2),            _T ("_AdsSyncReadWriteReqEx2@36")            },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncAddDeviceNotificationReqEx), _T ("_AdsSyncAddDeviceNotificationReqEx@32") },
+  CProcAds { reinterpret_cast <LPVOID *> (&AdsSyncDelDeviceNotificationReqEx), _T ("_AdsSyncDelDeviceNotificationReqEx@12") }
+};
+
+class CTwinCATADSTCP;
+
+// the AMS router of a target accepts a single AMS/TCP connection per client AMS Net ID, every port
+// that talks to the same target shares one link and is told apart by its source AMS port...
+
+class CAmsTcpLink final : private PDCLib::IWorkerThread
+{
+public:
+  explicit CAmsTcpLink (CString const & hostName, CString const & amsNetId);
+  virtual ~CAmsTcpLink () { Close (); }
+
+  static std::shared_ptr <CAmsTcpLink> Attach (CString const & hostName, CString const & amsNetId, WORD sourcePort, CTwinCATADSTCP & port);
+  void Detach (WORD sourcePort);
+
+  AmsNetId GetTarget (void);
+
+  long Request (AmsAddr            const & amsAddr,
+                WORD                       sourcePort,
+                WORD                       commandId,
+                void               const * pHeader,
+                size_t                     cbHeader,
+                void               const * pData,
+                size_t                     cbData,
+                std::vector <BYTE>       & response);
+
+  enum : WORD
+  {
+    ADSCMD_READ                  = 0x0002,
+    ADSCMD_WRITE                 = 0x0003,
+    ADSCMD_ADDDEVICENOTIFICATION = 0x0006,
+    ADSCMD_DELDEVICENOTIFICATION = 0x0007,
+    ADSCMD_DEVICENOTIFICATION    = 0x0008,
+    ADSCMD_READWRITE             = 0x0009
+  };
+
+private:
+  virtual bool OnStartup (void) override final { return true; }
+  virtual bool OnRun (void) override final;
+  virtual void OnShutdown (void) override final {}
+
+  enum : WORD
+  {
+    AMS_STATE_RESPONSE   = 0x0001,
+    AMS_STATE_ADSCOMMAND = 0x0004
+  };
+
+  struct SResponse
+  {
+    bool               isComplete;
+    long               error;
+    std::vector <BYTE> data;
+  };
+
+  struct SLink
+  {
+    std::mutex                  linkGate;
+    std::weak_ptr <CAmsTcpLink> link;
+  };
+
+#pragma pack (push, 1)
+  struct SAmsTcpHeader
+  {
+    WORD  reserved;
+    ULONG length;
+  };
+
+  struct SAmsHeader
+  {
+    AmsAddr target;
+    AmsAddr source;
+    WORD    commandId;
+    WORD    stateFlags;
+    ULONG   length;
+    ULONG   errorCode;
+    ULONG   invokeId;
+  };
+#pragma pack (pop)
+
+  void Open (void);
+  void Close (void);
+  void Connect (void);
+  void Disconnect (long error);
+  void Reconnect (void);
+
+  long Send (std::vector <BYTE> const & frame);
+  long Wait (bool isRead, DWORD timeout);
+
+  void Receive (SAmsHeader const & amsHeader, BYTE const * pData);
+
+  static void GetNetId (CString const & amsNetId, AmsNetId & netId);
+  static void GetNetId (sockaddr const * pAddress, AmsNetId & netId);
+
+  static char     const ADS_TCP_PORT[];
+  static DWORD    const CONNECT_TIMEOUT;
+  static DWORD    const REQUEST_TIMEOUT;
+  static DWORD    const RECEIVE_TIMEOUT;
+  static DWORD    const RECONNECT_DELAY_MIN;
+  static DWORD    const RECONNECT_DELAY_MAX;
+  static size_t   const RECEIVE_BUFFER_SIZE;
+
+  static std::map <CString, std::shared_ptr <SLink>> m_link;
+  static std::mutex                                  m_linkGate;
+
+  CString const m_hostName;
+  CString const m_amsNetId;
+  bool m_isStarted;
+  AmsNetId m_source;
+  AmsNetId m_target;
+  SOCKET m_socket;
+  std::atomic <long> m_socketError;
+  std::atomic_uint32_t m_invokeId;
+  ULONGLONG m_reconnectTick;
+  DWORD m_reconnectDelay;
+  std::mutex m_sendGate;
+  std::mutex m_responseGate;
+  std::condition_variable m_responseEvent;
+  std::map <ULONG, SResponse *> m_response;
+  std::mutex m_portGate;
+  std::map <WORD, CTwinCATADSTCP *> m_port;
+  std::vector <BYTE> m_receiveBuffer;
+  std::vector <BYTE> m_receiveData;
+  PDCLib::CWorkerThread m_workerThread;
+
+public:
+  CAmsTcpLink (CAmsTcpLink const &) = delete;
+  CAmsTcpLink & operator = (CAmsTcpLink const &) = delete;
+};
+
+class CTwinCATADSTCP final : public ITwinCATADS, private PDCLib::IWorkerThread
+{
+public:
+  explicit CTwinCATADSTCP (CString const & hostName, CString const & amsNetId);
+  virtual ~CTwinCATADSTCP () { Destroy (); }
+
+  static CString GetConnectionKey (WORD portNumber, CString const & hostName, CString const & amsNetId)
+    {
+      return PDCLib::StringWithFormat (_T ("TCP:%s:%s:%u"), (LPCTSTR) hostName, (LPCTSTR) amsNetId, portNumber);
+    }
+
+  virtual void Create (WORD portNumber) override final
+    {
+      Open (portNumber);
+    }
+
+  // called by the link on its receiver thread, neither may block on a callback...
+
+  void Queue (AmsAddr const & amsAddr, BYTE const * pData, size_t cbData);
+  void OnReconnect (void) { SetRebindPending (); }
+
+private:
+  virtual long SyncWriteReq (AmsAddr       & amsAddr,
+                             unsigned long   indexGroup,
+                             unsigned long   indexOffset,
+                             unsigned long   length,
+                             void          * pData) override final;
+  virtual long SyncReadWriteReq (AmsAddr       & amsAddr,
+                                 unsigned long   indexGroup,
+                                 unsigned long   indexOffset,
+                                 unsigned long   cbReadLength,
+                                 void          * pReadData,
+                                 unsigned long   cbWriteLength,
+                                 void          * pWriteData) override final;
+  virtual long SyncAddDeviceNotificationReq (AmsAddr               & amsAddr,
+                                             unsigned long           indexGroup,
+                                             unsigned long           indexOffset,
+                                             AdsNotificationAttrib * adsNotificationAttrib,
+                                             void                  * pNoteFunc,
+                                             unsigned long           hUser,
+                                             unsigned long         * pNotification) override final;
+  virtual long SyncDelDeviceNotificationReq (AmsAddr       & amsAddr,
+                                             unsigned long   hNotification) override final;
+  virtual long SumAddDeviceNotificationReq (AmsAddr                        & amsAddr,
+                                            std::vector <SNotificationReq> & notificationReq) override final;
+  virtual long SumDelDeviceNotificationReq (AmsAddr                        & amsAddr,
+                                            std::vector <SNotificationReq> & notificationReq) override final;
+  virtual long PortOpen (void) override final;
+  virtual void PortClose (void) override final;
+  virtual long GetLocalAddress (AmsAddr & amsAddr) override final;
+  virtual long GetDllVersion (void) override final { return 0; }
+  virtual bool IsConcurrent (void) const override final { return true; }
+
+  virtual bool OnStartup (void) override final { return true; }
+  virtual bool OnRun (void) override final;
+  virtual void OnShutdown (void) override final {}
+
+#pragma pack (push, 1)
+  struct SAdsReadReq
+  {
+    ULONG indexGroup;
+    ULONG indexOffset;
+    ULONG length;
+  };
+
+  struct SAdsReadRes
+  {
+    ULONG result;
+    ULONG length;
+  };
+
+  struct SAdsReadWriteReq
+  {
+    ULONG indexGroup;
+    ULONG indexOffset;
+    ULONG readLength;
+    ULONG writeLength;
+  };
+
+  struct SAdsAddDeviceNotificationReq
+  {
+    ULONG indexGroup;
+    ULONG indexOffset;
+    ULONG length;
+    ULONG transMode;
+    ULONG maxDelay;
+    ULONG cycleTime;
+    BYTE  reserved[16];
+  };
+
+  struct SAdsAddDeviceNotificationRes
+  {
+    ULONG result;
+    ULONG hNotification;
+  };
+
+  struct SAdsNotificationStream
+  {
+    ULONG length;
+    ULONG stamps;
+  };
+
+  struct SAdsStampHeader
+  {
+    LONGLONG timeStamp;
+    ULONG    samples;
+  };
+
+  struct SAdsNotificationSample
+  {
+    ULONG hNotification;
+    ULONG size;
+  };
+#pragma pack (pop)
+
+  using SAdsWriteReq = SAdsReadReq;
+  using CNotifyFrame = std::tuple <AmsAddr, std::vector <BYTE>>;
+
+  long Request (AmsAddr            const & amsAddr,
+                WORD                       commandId,
+                void               const * pHeader,
+                size_t                     cbHeader,
+                void               const * pData,
+                size_t                     cbData,
+                std::vector <BYTE>       & response)
+    {
+      return m_link->Request (amsAddr, m_sourcePort, commandId, pHeader, cbHeader, pData, cbData, response);
+    }
+
+  void Notify (AmsAddr const & amsAddr, BYTE const * pData, size_t cbData);
+  void Notify (AmsAddr const & amsAddr, std::vector <BYTE> & notification, void * pNoteFunc, unsigned long hUser);
+
+  static long GetResult (std::vector <BYTE> const & response);
+
+  static WORD     const SOURCE_PORT_BASE;
+  static DWORD    const QUEUE_TIMEOUT;
+  static size_t   const MAX_ORPHAN_SAMPLES;
+
+  static std::atomic_int32_t m_portCount;
+
+  CString const m_hostName;
+  CString const m_amsNetId;
+  WORD m_sourcePort;
+  std::shared_ptr <CAmsTcpLink> m_link;
+  std::mutex m_queueGate;
+  std::condition_variable m_queueEvent;
+  std::vector <CNotifyFrame> m_queue;
+  std::mutex m_callbackGate;
+  std::map <ULONG, std::tuple <void *, unsigned long>> m_callback;
+  std::map <ULONG, std::tuple <AmsAddr, std::vector <BYTE>>> m_orphanSample;
+  PDCLib::CWorkerThread m_workerThread;
+
+public:
+  CTwinCATADSTCP (CTwinCATADSTCP const &) = delete;
+  CTwinCATADSTCP & operator = (CTwinCATADSTCP const &) = delete;
+};
+
+char                                   const CAmsTcpLink::ADS_TCP_PORT[]                     ("48898");
+DWORD                                  const CAmsTcpLink::CONNECT_TIMEOUT                    (5000);
+DWORD                                  const CAmsTcpLink::REQUEST_TIMEOUT                    (5000);
+DWORD                                  const CAmsTcpLink::RECEIVE_TIMEOUT                    (10);
+DWORD                                  const CAmsTcpLink::RECONNECT_DELAY_MIN                (100);
+DWORD                                  const CAmsTcpLink::RECONNECT_DELAY_MAX                (5000);
+size_t                                 const CAmsTcpLink::RECEIVE_BUFFER_SIZE                (65536);
+
+std::map <CString, std::shared_ptr <CAmsTcpLink::SLink>> CAmsTcpLink::m_link;
+std::mutex                                               CAmsTcpLink::m_linkGate;
+
+WORD                                   const CTwinCATADSTCP::SOURCE_PORT_BASE                (32768);
+DWORD                                  const CTwinCATADSTCP::QUEUE_TIMEOUT                   (10);
+size_t                                 const CTwinCATADSTCP::MAX_ORPHAN_SAMPLES              (64);
+
+std::atomic_int32_t                          CTwinCATADSTCP::m_portCount                     (0);
+
+CAmsTcpLink::CAmsTcpLink (CString const & hostName, CString const & amsNetId) :
+  m_hostName (hostName),
+  m_amsNetId (amsNetId),
+  m_isStarted (false),
+  m_socket (INVALID_SOCKET),
+  m_socketError (WSAENOTCONN),
+  m_invokeId (0),
+  m_reconnectTick (0),
+  m_reconnectDelay (RECONNECT_DELAY_MIN),
+  m_receiveBuffer (RECEIVE_BUFFER_SIZE),
+  m_workerThread (*this)
+{
+  ::memset (&m_source, 0, sizeof (m_source));
+  ::memset (&m_target, 0, sizeof (m_target));
+}
+
+std::shared_ptr <CAmsTcpLink>
+CAmsTcpLink::Attach (CString const & hostName, CString const & amsNetId, WORD sourcePort, CTwinCATADSTCP & port)
+{
+  std::shared_ptr <SLink> l_entry;
+
+  {
+    // a pool entry goes with the last port on its link...
+
+    std::unique_lock <std::mutex> l_linkGate { m_linkGate };
+
+    for (auto l_link (m_link.begin ()); l_link != m_link.end (); )
+      {
+        if ((std::get <1> (*l_link).use_count () == 1) && std::get <1> (*l_link)->link.expired ())
+          {
+            l_link = m_link.erase (l_link);
+          }
+        else
+          {
+            ++l_link;
+          }
+      }
+
+    auto & l_link_ (m_link[PDCLib::StringWithFormat (_T ("%s:%s"), (LPCTSTR) hostName, (LPCTSTR) amsNetId)]);
+
+    if (!l_link_)
+      {
+        l_link_ = std::make_shared <SLink> ();
+      }
+
+    l_entry = l_link_;
+  }
+
+  // the first port to a target connects, the ports that follow (the other I/O port of CreateIO) wait for it...
+
+  std::unique_lock <std::mutex> l_linkGate { l_entry->linkGate };
+
+  auto l_link (l_entry->link.lock ());
+
+  if (!l_link)
+    {
+      l_link = std::make_shared <CAmsTcpLink> (hostName, amsNetId);
+
+      l_link->Open ();
+
+      l_entry->link = l_link;
+    }
+
+  {
+    std::unique_lock <std::mutex> l_portGate { l_link->m_portGate };
+
+    l_link->m_port[sourcePort] = &port;
+  }
+
+  return l_link;
+}
+
+void
+CAmsTcpLink::Detach (WORD sourcePort)
+{
+  // the receiver holds the gate while it hands a frame over, the port is not referenced once this returns...
+
+  std::unique_lock <std::mutex> l_portGate { m_portGate };
+
+  m_port.erase (sourcePort);
+}
+
+AmsNetId
+CAmsTcpLink::GetTarget (void)
+{
+  std::unique_lock <std::mutex> l_responseGate { m_responseGate };
+
+  return m_target;
+}
+
+void
+CAmsTcpLink::Open (void)
+{
+  WSADATA l_wsaData;
+
+  if (auto const l_error (::WSAStartup (MAKEWORD (2, 2), &l_wsaData)); l_error != 0)
+    {
+      PDCLib::ThrowStringException (_T ("unable to initialize Windows Sockets; %s"), (LPCTSTR) PDCLib::GetErrorMessage (l_error));
+    }
+
+  m_isStarted = true;
+
+  Connect ();
+
+  m_socketError = ADSERR_NOERR;
+
+  if (!m_workerThread.Create ())
+    {
+      PDCLib::ThrowStringException (_T ("unable to create TwinCAT ADS receiver"));
+    }
+}
+
+void
+CAmsTcpLink::Close (void)
+{
+  if (m_workerThread.IsCreated ())
+    {
+      m_workerThread.Terminate ();
+    }
+
+  Disconnect (WSAENOTCONN);
+
+  if (m_socket != INVALID_SOCKET)
+    {
+      ::closesocket (m_socket);
+
+      m_socket = INVALID_SOCKET;
+    }
+
+  m_receiveData.clear ();
+
+  if (m_isStarted)
+    {
+      ::WSACleanup ();
+
+      m_isStarted = false;
+    }
+}
+
+bool
+CAmsTcpLink::OnRun (void)
+{
+  if (m_socketError != ADSERR_NOERR)
+    {
+      // the connection was lost, try again with a growing delay so an absent target is not flooded...
+
+      if (PDCLib::GetTickCount () >= m_reconnectTick)
+        {
+          Reconnect ();
+        }
+      else
+        {
+          PDCLib::Sleep (RECEIVE_TIMEOUT);
+        }
+
+      return true;
+    }
+
+  // wake up periodically so that a terminate request is not missed...
+
+  if (auto const l_error (Wait (true, RECEIVE_TIMEOUT)); l_error != ADSERR_NOERR)
+    {
+      if (l_error != ADSERR_CLIENT_SYNCTIMEOUT)
+        {
+          Disconnect (l_error);
+        }
+
+      return true;
+    }
+
+  auto const l_cbReceived (::recv (m_socket, reinterpret_cast <char *> (&m_receiveBuffer[0]), static_cast <int> (m_receiveBuffer.size ()), 0));
+
+  if (l_cbReceived == 0)
+    {
+      Disconnect (WSAECONNRESET);
+
+      return true;
+    }
+  else if (l_cbReceived == SOCKET_ERROR)
+    {
+      if (auto const l_error (::WSAGetLastError ()); l_error != WSAEWOULDBLOCK)
+        {
+          Disconnect (l_error);
+        }
+
+      return true;
+    }
+
+  m_receiveData.insert (m_receiveData.end (), m_receiveBuffer.begin (), m_receiveBuffer.begin () + l_cbReceived);
+
+  // dispatch every complete frame, a partial frame waits for the rest of its data...
+
+  size_t l_offset (0);
+
+  while (m_receiveData.size () - l_offset >= sizeof (SAmsTcpHeader))
+    {
+      auto const l_amsTcpHeader (reinterpret_cast <SAmsTcpHeader const *> (&m_receiveData[l_offset]));
+
+      auto const l_cbFrame (sizeof (SAmsTcpHeader) + l_amsTcpHeader->length);
+
+      if (m_receiveData.size () - l_offset < l_cbFrame)
+        {
+          break;
+        }
+
+      if (l_amsTcpHeader->length >= sizeof (SAmsHeader))
+        {
+          auto const l_amsHeader (reinterpret_cast <SAmsHeader const *> (l_amsTcpHeader + 1));
+
+          if (sizeof (SAmsHeader) + l_amsHeader->length <= l_amsTcpHeader->length)
+            {
+              Receive (*l_amsHeader, reinterpret_cast <BYTE const *> (l_amsHeader + 1));
+            }
+        }
+
+      l_offset += l_cbFrame;
+    }
+
+  m_receiveData.erase (m_receiveData.begin (), m_receiveData.begin () + l_offset);
+
+  return true;
+}
+
+void
+CAmsTcpLink::Connect (void)
+{
+  // the host name may carry a TCP port (host:port) for a target that does not listen on the ADS port...
+
+  std::vector <char> l_hostName;
+  std::vector <char> l_tcpPort (ADS_TCP_PORT, ADS_TCP_PORT + sizeof (ADS_TCP_PORT));
+
+  if (auto const l_pos (m_hostName.ReverseFind (_T (':'))); l_pos > 0)
+    {
+      PDCLib::StringToVector (m_hostName.Left (l_pos), l_hostName);
+      PDCLib::StringToVector (m_hostName.Mid (l_pos + 1), l_tcpPort);
+    }
+  else
+    {
+      PDCLib::StringToVector (m_hostName, l_hostName);
+    }
+
+  addrinfo l_hints {};
+
+  l_hints.ai_family   = AF_INET;
+  l_hints.ai_socktype = SOCK_STREAM;
+  l_hints.ai_protocol = IPPROTO_TCP;
+
+  addrinfo * l_addrInfo (nullptr);
+
+  if (auto const l_error (::getaddrinfo (&l_hostName[0], &l_tcpPort[0], &l_hints, &l_addrInfo)); l_error != 0)
+    {
+      PDCLib::ThrowStringException (_T ("unable to resolve %s; %s"), (LPCTSTR) m_hostName, (LPCTSTR) PDCLib::GetErrorMessage (l_error));
+    }
+
+  std::unique_ptr <addrinfo, decltype (&::freeaddrinfo)> const l_addrInfo_ (l_addrInfo, &::freeaddrinfo);
+
+  if ((m_socket = ::socket (l_addrInfo->ai_family, l_addrInfo->ai_socktype, l_addrInfo->ai_protocol)) == INVALID_SOCKET)
+    {
+      PDCLib::ThrowStringException (_T ("unable to create socket; %s"), (LPCTSTR) PDCLib::GetErrorMessage (::WSAGetLastError ()));
+    }
+
+  // requests are small and latency bound, disable send coalescing...
+
+  u_long l_nonBlocking (1);
+  int    l_noDelay (1);
+
+  ::ioctlsocket (m_socket, FIONBIO, &l_nonBlocking);
+  ::setsockopt (m_socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast <char const *> (&l_noDelay), sizeof (l_noDelay));
+
+  if (::connect (m_socket, l_addrInfo->ai_addr, static_cast <int> (l_addrInfo->ai_addrlen)) == SOCKET_ERROR)
+    {
+      long l_error (::WSAGetLastError ());
+
+      if (l_error == WSAEWOULDBLOCK)
+        {
+          if ((l_error = Wait (false, CONNECT_TIMEOUT)) == ADSERR_NOERR)
+            {
+              int l_socketError (0);
+              int l_cbSocketError (sizeof (l_socketError));
+
+              ::getsockopt (m_socket, SOL_SOCKET, SO_ERROR, reinterpret_cast <char *> (&l_socketError), &l_cbSocketError);
+
+              l_error = l_socketError;
+            }
+        }
+
+      if (l_error == ADSERR_CLIENT_SYNCTIMEOUT)
+        {
+          PDCLib::ThrowStringException (_T ("unable to connect to %s; connection timed out"), (LPCTSTR) m_hostName);
+        }
+      else if (l_error != ADSERR_NOERR)
+        {
+          PDCLib::ThrowStringException (_T ("unable to connect to %s; %s"), (LPCTSTR) m_hostName, (LPCTSTR) PDCLib::GetErrorMessage (l_error));
+        }
+    }
+
+  // the source address is derived from the local IP address, the target must have a route to it...
+
+  sockaddr_in l_localAddress {};
+  int         l_cbLocalAddress (sizeof (l_localAddress));
+
+  ::getsockname (m_socket, reinterpret_cast <sockaddr *> (&l_localAddress), &l_cbLocalAddress);
+
+  // the source ports are kept across a reconnect, the target knows each port by its AMS address...
+
+  AmsNetId l_source;
+  AmsNetId l_target;
+
+  GetNetId (reinterpret_cast <sockaddr const *> (&l_localAddress), l_source);
+
+  if (m_amsNetId.IsEmpty ())
+    {
+      GetNetId (l_addrInfo->ai_addr, l_target);
+    }
+  else
+    {
+      GetNetId (m_amsNetId, l_target);
+    }
+
+  {
+    std::unique_lock <std::mutex> l_responseGate { m_responseGate };
+
+    m_source = l_source;
+    m_target = l_target;
+  }
+
+  PDCLib::Trace (_T ("TwinCAT ADS Target   : %s (%ld.%ld.%ld.%ld.%ld.%ld)"),
+                 (LPCTSTR) m_hostName,
+                 static_cast <int> (l_target.b[0]),
+                 static_cast <int> (l_target.b[1]),
+                 static_cast <int> (l_target.b[2]),
+                 static_cast <int> (l_target.b[3]),
+                 static_cast <int> (l_target.b[4]),
+                 static_cast <int> (l_target.b[5]));
+}
+
+void
+CAmsTcpLink::Disconnect (long error)
+{
+  // fail every request in flight and any that follow, the socket itself is closed with the link...
+
+  std::unique_lock <std::mutex> l_responseGate { m_responseGate };
+
+  if (m_socketError == ADSERR_NOERR)
+    {
+      PDCLib::Trace (_T ("TwinCAT ADS connection to %s closed; %s"), (LPCTSTR) m_hostName, (LPCTSTR) PDCLib::GetErrorMessage (error));
+    }
+
+  m_socketError = error;
+
+  for (auto&& l_response : m_response)
+    {
+      std::get <1> (l_response)->error      = error;
+      std::get <1> (l_response)->isComplete = true;
+    }
+
+  m_responseEvent.notify_all ();
+}
+
+void
+CAmsTcpLink::Reconnect (void)
+{
+  {
+    std::unique_lock <std::mutex> l_sendGate { m_sendGate };
+
+    if (m_socket != INVALID_SOCKET)
+      {
+        ::closesocket (m_socket);
+
+        m_socket = INVALID_SOCKET;
+      }
+
+    m_receiveData.clear ();
+
+    try
+      {
+        Connect ();
+      }
+    catch (CString const & errorMessage)
+      {
+        PDCLib::Trace (_T ("%s, retrying in %lu ms"), (LPCTSTR) errorMessage, m_reconnectDelay);
+
+        m_reconnectTick  = PDCLib::GetTickCount () + m_reconnectDelay;
+        m_reconnectDelay = std::min (m_reconnectDelay * 2, RECONNECT_DELAY_MAX);
+
+        return;
+      }
+  }
+
+  m_reconnectDelay = RECONNECT_DELAY_MIN;
+
+  {
+    std::unique_lock <std::mutex> l_responseGate { m_responseGate };
+
+    m_socketError = ADSERR_NOERR;
+  }
+
+  PDCLib::Trace (_T ("TwinCAT ADS connection to %s restored"), (LPCTSTR) m_hostName);
+
+  // the target dropped the notifications of the old connection, the owners add them again...
+
+  std::unique_lock <std::mutex> l_portGate { m_portGate };
+
+  for (auto&& l_port : m_port)
+    {
+      std::get <1> (l_port)->OnReconnect ();
+    }
+}
+
+long
+CAmsTcpLink::Request (AmsAddr            const & amsAddr,
+                      WORD                       sourcePort,
+                      WORD                       commandId,
+                      void               const * pHeader,
+                      size_t                     cbHeader,
+                      void               const * pData,
+                      size_t                     cbData,
+                      std::vector <BYTE>       & response)
+{
+  // AMS/TCP frame: {reserved, length} followed by AMS header {target, source, command, state, length, error, invoke ID} followed by ADS data...
+
+  std::vector <BYTE> l_frame (sizeof (SAmsTcpHeader) + sizeof (SAmsHeader) + cbHeader + cbData);
+
+  auto const l_amsTcpHeader (reinterpret_cast <SAmsTcpHeader *> (&l_frame[0]));
+  auto const l_amsHeader (reinterpret_cast <SAmsHeader *> (l_amsTcpHeader + 1));
+
+  l_amsTcpHeader->reserved = 0;
+  l_amsTcpHeader->length   = static_cast <ULONG> (l_frame.size () - sizeof (SAmsTcpHeader));
+  l_amsHeader->target      = amsAddr;
+  l_amsHeader->commandId   = commandId;
+  l_amsHeader->stateFlags  = AMS_STATE_ADSCOMMAND;
+  l_amsHeader->length      = static_cast <ULONG> (cbHeader + cbData);
+  l_amsHeader->errorCode   = ADSERR_NOERR;
+  l_amsHeader->invokeId    = ++m_invokeId;
+
+  if (cbHeader > 0)
+    {
+      ::memcpy_s (l_amsHeader + 1, cbHeader + cbData, pHeader, cbHeader);
+    }
+
+  if (cbData > 0)
+    {
+      ::memcpy_s (reinterpret_cast <BYTE *> (l_amsHeader + 1) + cbHeader, cbData, pData, cbData);
+    }
+
+  // the response is matched by invoke ID, other requests are sent while this one is in flight...
+
+  SResponse l_response { false, ADSERR_NOERR, {} };
+
+  std::unique_lock <std::mutex> l_responseGate { m_responseGate };
+
+  if (m_socketError != ADSERR_NOERR)
+    {
+      return m_socketError;
+    }
+
+  l_amsHeader->source.netId = m_source;
+  l_amsHeader->source.port  = sourcePort;
+
+  m_response[l_amsHeader->invokeId] = &l_response;
+
+  l_responseGate.unlock ();
+
+  auto l_error (Send (l_frame));
+
+  if (l_error != ADSERR_NOERR)
+    {
+      Disconnect (l_error);
+    }
+
+  l_responseGate.lock ();
+
+  if (!m_responseEvent.wait_for (l_responseGate, std::chrono::milliseconds (REQUEST_TIMEOUT), [&l_response] { return l_response.isComplete; }))
+    {
+      l_response.error = ADSERR_CLIENT_SYNCTIMEOUT;
+    }
+
+  m_response.erase (l_amsHeader->invokeId);
+
+  if ((l_error = l_response.error) == ADSERR_NOERR)
+    {
+      response.swap (l_response.data);
+    }
+
+  return l_error;
+}
+
+long
+CAmsTcpLink::Send (std::vector <BYTE> const & frame)
+{
+  std::unique_lock <std::mutex> l_sendGate { m_sendGate };
+
+  // the socket is non-blocking, wait for room in the send buffer when it is full...
+
+  for (size_t l_cbSent (0); l_cbSent < frame.size (); )
+    {
+      if (auto const l_cb (::send (m_socket, reinterpret_cast <char const *> (&frame[l_cbSent]), static_cast <int> (frame.size () - l_cbSent), 0)); l_cb != SOCKET_ERROR)
+        {
+          l_cbSent += static_cast <size_t> (l_cb);
+        }
+      else if (auto const l_error (::WSAGetLastError ()); l_error != WSAEWOULDBLOCK)
+        {
+          return l_error;
+        }
+      else if (auto const l_error_ (Wait (false, REQUEST_TIMEOUT)); l_error_ != ADSERR_NOERR)
+        {
+          return l_error_;
+        }
+    }
+
+  return ADSERR_NOERR;
+}
+
+long
+CAmsTcpLink::Wait (bool isRead, DWORD timeout)
+{
+  fd_set l_fdSet;
+
+  FD_ZERO (&l_fdSet);
+  FD_SET (m_socket, &l_fdSet);
+
+  timeval l_timeout { static_cast <long> (timeout / 1000), static_cast <long> ((timeout % 1000) * 1000) };
+
+  auto const l_result (::select (static_cast <int> (m_socket + 1), isRead ? &l_fdSet : nullptr, isRead ? nullptr : &l_fdSet, nullptr, &l_timeout));
+
+  if (l_result == SOCKET_ERROR)
+    {
+      return ::WSAGetLastError ();
+    }
+
+  return (l_result == 0) ? ADSERR_CLIENT_SYNCTIMEOUT : ADSERR_NOERR;
+}
+
+void
+CAmsTcpLink::Receive (SAmsHeader const & amsHeader, BYTE const * pData)
+{
+  if (amsHeader.stateFlags & AMS_STATE_RESPONSE)
+    {
+      std::unique_lock <std::mutex> l_responseGate { m_responseGate };
+
+      // a response to a request that already timed out is dropped...
+
+      if (auto const l_response (m_response.find (amsHeader.invokeId)); l_response != m_response.end ())
+        {
+          std::get <1> (*l_response)->error = amsHeader.errorCode;
+          std::get <1> (*l_response)->data.assign (pData, pData + amsHeader.length);
+          std::get <1> (*l_response)->isComplete = true;
+
+          m_responseEvent.notify_all ();
+        }
+    }
+  else if (amsHeader.commandId == ADSCMD_DEVICENOTIFICATION)
+    {
+      // the notification is addressed to the source port of the port that added it, the port runs
+      // the callbacks on its own thread so that a callback may issue requests on this link...
+
+      std::unique_lock <std::mutex> l_portGate { m_portGate };
+
+      if (auto const l_port (m_port.find (amsHeader.target.port)); l_port != m_port.end ())
+        {
+          std::get <1> (*l_port)->Queue (amsHeader.source, pData, amsHeader.length);
+        }
+    }
+}
+
+void
+CAmsTcpLink::GetNetId (CString const & amsNetId, AmsNetId & netId)
+{
+  int l_b (0);
+  int l_pos (0);
+
+  for (auto l_token (amsNetId.Tokenize (_T ("."), l_pos)); !l_token.IsEmpty (); l_token = amsNetId.Tokenize (_T ("."), l_pos))
+    {
+      auto const l_value (_ttoi (l_token));
+
+      if ((l_b >= static_cast <int> (sizeof (netId.b))) || (l_value < 0) || (l_value > UCHAR_MAX))
+        {
+          break;
+        }
+
+      netId.b[l_b++] = static_cast <unsigned char> (l_value);
+    }
+
+  if (l_b != static_cast <int> (sizeof (netId.b)))
+    {
+      PDCLib::ThrowStringException (_T ("invalid AMS Net ID %s"), (LPCTSTR) amsNetId);
+    }
+}
+
+void
+CAmsTcpLink::GetNetId (sockaddr const * pAddress, AmsNetId & netId)
+{
+  // by convention the AMS Net ID of a system is its IP address followed by .1.1...
+
+  auto const l_pAddress (reinterpret_cast <BYTE const *> (&reinterpret_cast <sockaddr_in const *> (pAddress)->sin_addr));
+
+  std::copy (l_pAddress, l_pAddress + 4, netId.b);
+
+  netId.b[4] = 1;
+  netId.b[5] = 1;
+}
+CTwinCATADSTCP::CTwinCATADSTCP (CString const & hostName, CString const & amsNetId) :
+  m_hostName (hostName),
+  m_amsNetId (amsNetId),
+  m_sourcePort (0),
+  m_workerThread (*this)
+{
+}
+
+long
+CTwinCATADSTCP::SyncWriteReq (AmsAddr       & amsAddr,
+                              unsigned long   indexGroup,
+                              unsigned long   indexOffset,
+                              unsigned long   length,
+                              void          * pData)
+{
+  SAdsWriteReq const l_adsWriteReq { indexGroup, indexOffset, length };
+
+  std::vector <BYTE> l_response;
+
+  if (auto const l_error (Request (amsAddr, CAmsTcpLink::ADSCMD_WRITE, &l_adsWriteReq, sizeof (l_adsWriteReq), pData, length, l_response)); l_error != ADSERR_NOERR)
+    {
+      return l_error;
+    }
+
+  return GetResult (l_response);
+}
+
+long
+CTwinCATADSTCP::SyncReadWriteReq (AmsAddr       & amsAddr,
+                                  unsigned long   indexGroup,
+                                  unsigned long   indexOffset,
+                                  unsigned long   cbReadLength,
+                                  void          * pReadData,
+                                  unsigned long   cbWriteLength,
+                                  void          * pWriteData)
+{
+  std::vector <BYTE> l_response;
+
+  // a request without write data is sent as a plain read...
+
+  if (cbWriteLength == 0)
+    {
+      SAdsReadReq const l_adsReadReq { indexGroup, indexOffset, cbReadLength };
+
+      if (auto const l_error (Request (amsAddr, CAmsTcpLink::ADSCMD_READ, &l_adsReadReq, sizeof (l_adsReadReq), nullptr, 0, l_response)); l_error != ADSERR_NOERR)
+        {
+          return l_error;
+        }
+    }
+  else
+    {
+      SAdsReadWriteReq const l_adsReadWriteReq { indexGroup, indexOffset, cbReadLength, cbWriteLength };
+
+      if (auto const l_error (Request (amsAddr, CAmsTcpLink::ADSCMD_READWRITE, &l_adsReadWriteReq, sizeof (l_adsReadWriteReq), pWriteData, cbWriteLength, l_response)); l_error != ADSERR_NOERR)
+        {
+          return l_error;
+        }
+    }
+
+  if (auto const l_result (GetResult (l_response)); l_result != ADSERR_NOERR)
+    {
+      return l_result;
+    }
+
+  if (l_response.size () < sizeof (SAdsReadRes))
+    {
+      return ADSERR_CLIENT_SYNCRESINVALID;
+    }
+
+  auto const l_adsReadRes (reinterpret_cast <SAdsReadRes const *> (&l_response[0]));
+
+  if (l_response.size () < sizeof (SAdsReadRes) + l_adsReadRes->length)
+    {
+      return ADSERR_CLIENT_SYNCRESINVALID;
+    }
+
+  ::memcpy_s (pReadData, cbReadLength, &l_response[sizeof (SAdsReadRes)], std::min (cbReadLength, l_adsReadRes->length));
+
+  return ADSERR_NOERR;
+}
+
+long
+CTwinCATADSTCP::SyncAddDeviceNotificationReq (AmsAddr               & amsAddr,
+                                              unsigned long           indexGroup,
+                                              unsigned long           indexOffset,
+                                              AdsNotificationAttrib * adsNotificationAttrib,
+                                              void                  * /* pNoteFunc */,
+                                              unsigned long           /* hUser */,
+                                              unsigned long         * pNotification)
+{
+  // the callback is recorded by the caller once the handle is known...
+
+  SAdsAddDeviceNotificationReq const l_adsAddDeviceNotificationReq { indexGroup,
+                                                                     indexOffset,
+                                                                     adsNotificationAttrib->cbLength,
+                                                                     static_cast <ULONG> (adsNotificationAttrib->nTransMode),
+                                                                     adsNotificationAttrib->nMaxDelay,
+                                                                     adsNotificationAttrib->nCycleTime,
+                                                                     {} };
+
+  std::vector <BYTE> l_response;
+
+  if (auto const l_error (Request (amsAddr, CAmsTcpLink::ADSCMD_ADDDEVICENOTIFICATION, &l_adsAddDeviceNotificationReq, sizeof (l_adsAddDeviceNotificationReq), nullptr, 0, l_response)); l_error != ADSERR_NOERR)
+    {
+      return l_error;
+    }
+
+  if (auto const l_result (GetResult (l_response)); l_result != ADSERR_NOERR)
+    {
+      return l_result;
+    }
+
+  if (l_response.size () < sizeof (SAdsAddDeviceNotificationRes))
+    {
+      return ADSERR_CLIENT_SYNCRESINVALID;
+    }
+
+  *pNotification = reinterpret_cast <SAdsAddDeviceNotificationRes const *> (&l_response[0])->hNotification;
+
+  return ADSERR_NOERR;
+}
+
+long
+CTwinCATADSTCP::SyncDelDeviceNotificationReq (AmsAddr       & amsAddr,
+                                              unsigned long   hNotification)
+{
+  ULONG const l_hNotification (hNotification);
+
+  std::vector <BYTE> l_response;
+
+  if (auto const l_error (Request (amsAddr, CAmsTcpLink::ADSCMD_DELDEVICENOTIFICATION, &l_hNotification, sizeof (l_hNotification), nullptr, 0, l_response)); l_error != ADSERR_NOERR)
+    {
+      return l_error;
+    }
+
+  return GetResult (l_response);
+}
+
+long
+CTwinCATADSTCP::SumAddDeviceNotificationReq (AmsAddr                        & amsAddr,
+                                             std::vector <SNotificationReq> & notificationReq)
+{
+  auto l_error (ITwinCATADS::SumAddDeviceNotificationReq (amsAddr, notificationReq));
+
+  if (l_error == ADSERR_DEVICE_SRVNOTSUPP)
+    {
+      // sum commands not supported by the target, add the notifications one at a time...
+
+      l_error = AddDeviceNotificationReqs (amsAddr, notificationReq);
+    }
+
+  if (l_error != ADSERR_NOERR)
+    {
+      return l_error;
+    }
+
+  // the target sends the current value as soon as a notification is added, a sample that arrived
+  // ahead of its callback was held back and is delivered now...
+
+  std::vector <std::tuple <AmsAddr, std::vector <BYTE>, void *, unsigned long>> l_orphanSample;
+
+  {
+    std::unique_lock <std::mutex> l_callbackGate { m_callbackGate };
+
+    for (auto&& l_notificationReq : notificationReq)
+      {
+        if (l_notificationReq.result == ADSERR_NOERR)
+          {
+            m_callback[l_notificationReq.hNotification] = std::make_tuple (l_notificationReq.pNoteFunc, l_notificationReq.hUser);
+
+            if (auto const l_sample (m_orphanSample.find (l_notificationReq.hNotification)); l_sample != m_orphanSample.end ())
+              {
+                l_orphanSample.emplace_back (std::get <0> (std::get <1> (*l_sample)), std::move (std::get <1> (std::get <1> (*l_sample))), l_notificationReq.pNoteFunc, l_notificationReq.hUser);
+
+                BeginDispatch (l_notificationReq.hUser);
+              }
+          }
+      }
+
+    m_orphanSample.clear ();
+  }
+
+  for (auto&& l_sample : l_orphanSample)
+    {
+      Notify (std::get <0> (l_sample), std::get <1> (l_sample), std::get <2> (l_sample), std::get <3> (l_sample));
+
+      EndDispatch (std::get <3> (l_sample));
+    }
+
+  return ADSERR_NOERR;
+}
+
+long
+CTwinCATADSTCP::SumDelDeviceNotificationReq (AmsAddr                        & amsAddr,
+                                             std::vector <SNotificationReq> & notificationReq)
+{
+  {
+    std::unique_lock <std::mutex> l_callbackGate { m_callbackGate };
+
+    for (auto&& l_notificationReq : notificationReq)
+      {
+        m_callback.erase (l_notificationReq.hNotification);
+      }
+  }
+
+  auto const l_error (ITwinCATADS::SumDelDeviceNotificationReq (amsAddr, notificationReq));
+
+  if (l_error == ADSERR_DEVICE_SRVNOTSUPP)
+    {
+      // sum commands not supported by the target, delete the notifications one at a time...
+
+      return DelDeviceNotificationReqs (amsAddr, notificationReq);
+    }
+
+  return l_error;
+}
+
+long
+CTwinCATADSTCP::PortOpen (void)
+{
+  // the source port is kept across a reconnect of the link, the target knows this port by its AMS address...
+
+  m_sourcePort = static_cast <WORD> (SOURCE_PORT_BASE + (++m_portCount % SOURCE_PORT_BASE));
+
+  try
+    {
+      if (!m_workerThread.Create ())
+        {
+          PDCLib::ThrowStringException (_T ("unable to create TwinCAT ADS notification dispatcher"));
+        }
+
+      m_link = CAmsTcpLink::Attach (m_hostName, m_amsNetId, m_sourcePort, *this);
+    }
+  catch (CString const &)
+    {
+      PortClose ();
+
+      throw;
+    }
+
+  return m_sourcePort;
+}
+
+void
+CTwinCATADSTCP::PortClose (void)
+{
+  // once detached the receiver no longer queues to this port, the dispatcher then drains nothing new...
+
+  if (m_link)
+    {
+      m_link->Detach (m_sourcePort);
+
+      m_link = nullptr;
+    }
+
+  if (m_workerThread.IsCreated ())
+    {
+      m_workerThread.Terminate ();
+    }
+
+  m_queue.clear ();
+}
+
+long
+CTwinCATADSTCP::GetLocalAddress (AmsAddr & amsAddr)
+{
+  // there is no local router, requests are addressed to the target system directly...
+
+  amsAddr.netId = m_link->GetTarget ();
+
+  return ADSERR_NOERR;
+}
+
+bool
+CTwinCATADSTCP::OnRun (void)
+{
+  std::unique_lock <std::mutex> l_queueGate { m_queueGate };
+
+  // wake up periodically so that a terminate request is not missed...
+
+  if (m_queueEvent.wait_for (l_queueGate, std::chrono::milliseconds (QUEUE_TIMEOUT), [this] { return !m_queue.empty (); }))
+    {
+      std::vector <CNotifyFrame> l_queue;
+
+      l_queue.swap (m_queue);
+
+      l_queueGate.unlock ();
+
+      for (auto&& l_frame : l_queue)
+        {
+          Notify (std::get <0> (l_frame), std::get <1> (l_frame).data (), std::get <1> (l_frame).size ());
+        }
+    }
+
+  return true;
+}
+
+void
+CTwinCATADSTCP::Queue (AmsAddr const & amsAddr, BYTE const * pData, size_t cbData)
+{
+  {
+    std::unique_lock <std::mutex> l_queueGate { m_queueGate };
+
+    m_queue.emplace_back (amsAddr, std::vector <BYTE> (pData, pData + cbData));
+  }
+
+  m_queueEvent.notify_one ();
+}
+
+void
+CTwinCATADSTCP::Notify (AmsAddr const & amsAddr, BYTE const * pData, size_t cbData)
+{
+  // notification stream: {length, stamps} followed by list of stamps {time stamp, samples} each followed by list of samples {handle, size, data}...
+
+  if (cbData < sizeof (SAdsNotificationStream))
+    {
+      return;
+    }
+
+  auto const l_adsNotificationStream (reinterpret_cast <SAdsNotificationStream const *> (pData));
+
+  auto const l_pEnd (pData + std::min (cbData, sizeof (SAdsNotificationStream) + l_adsNotificationStream->length));
+
+  pData += sizeof (SAdsNotificationStream);
+
+  for (ULONG l_stamp (0); (l_stamp < l_adsNotificationStream->stamps) && (pData + sizeof (SAdsStampHeader) <= l_pEnd); ++l_stamp)
+    {
+      auto const l_adsStampHeader (reinterpret_cast <SAdsStampHeader const *> (pData));
+
+      pData += sizeof (SAdsStampHeader);
+
+      for (ULONG l_sample (0); (l_sample < l_adsStampHeader->samples) && (pData + sizeof (SAdsNotificationSample) <= l_pEnd); ++l_sample)
+        {
+          auto const l_adsNotificationSample (reinterpret_cast <SAdsNotificationSample const *> (pData));
+
+          pData += sizeof (SAdsNotificationSample);
+
+          if (pData + l_adsNotificationSample->size > l_pEnd)
+            {
+              return;
+            }
+
+          // repackage the sample the way the router DLL presents it...
+
+          std::vector <BYTE> l_notification (std::max (sizeof (AdsNotificationHeader), offsetof (AdsNotificationHeader, data) + l_adsNotificationSample->size));
+
+          auto const l_adsNotificationHeader (reinterpret_cast <AdsNotificationHeader *> (&l_notification[0]));
+
+          l_adsNotificationHeader->hNotification = l_adsNotificationSample->hNotification;
+          l_adsNotificationHeader->nTimeStamp    = l_adsStampHeader->timeStamp;
+          l_adsNotificationHeader->cbSampleSize  = l_adsNotificationSample->size;
+
+          ::memcpy_s (l_adsNotificationHeader->data, l_notification.size () - offsetof (AdsNotificationHeader, data), pData, l_adsNotificationSample->size);
+
+          void          * l_pNoteFunc (nullptr);
+          unsigned long   l_hUser (0);
+
+          {
+            std::unique_lock <std::mutex> l_callbackGate { m_callbackGate };
+
+            if (auto const l_callback (m_callback.find (l_adsNotificationSample->hNotification)); l_callback != m_callback.end ())
+              {
+                std::tie (l_pNoteFunc, l_hUser) = std::get <1> (*l_callback);
+
+                BeginDispatch (l_hUser);
+              }
+            else if ((m_orphanSample.size () < MAX_ORPHAN_SAMPLES) || (m_orphanSample.count (l_adsNotificationSample->hNotification) != 0))
+              {
+                // the notification was added but its callback is not recorded yet, keep the latest sample;
+                // a handle nobody adds (left over from an earlier connection) is dropped once the cap is hit...
+
+                m_orphanSample[l_adsNotificationSample->hNotification] = std::make_tuple (amsAddr, std::move (l_notification));
+              }
+          }
+
+          if (l_pNoteFunc != nullptr)
+            {
+              Notify (amsAddr, l_notification, l_pNoteFunc, l_hUser);
+
+              EndDispatch (l_hUser);
+            }
+
+          pData += l_adsNotificationSample->size;
+        }
+    }
+}
+
+void
+CTwinCATADSTCP::Notify (AmsAddr const & amsAddr, std::vector <BYTE> & notification, void * pNoteFunc, unsigned long hUser)
+{
+  AmsAddr l_amsAddr (amsAddr);
+
+  reinterpret_cast <PAdsNotificationFuncEx> (pNoteFunc) (&l_amsAddr, reinterpret_cast <AdsNotificationHeader *> (&notification[0]), hUser);
+}
+
+long
+CTwinCATADSTCP::GetResult (std::vector <BYTE> const & response)
+{
+  if (response.size () < sizeof (ULONG))
+    {
+      return ADSERR_CLIENT_SYNCRESINVALID;
+    }
+
+  return static_cast <long> (*reinterpret_cast <ULONG const *> (&response[0]));
+}
+
+class CTwinCATADSSim final : public ITwinCATADS, private PDCLib::IWorkerThread
+{
+public:
+  explicit CTwinCATADSSim (CTwinCATADS::SVirtualPLC const & virtualPLC);
+  virtual ~CTwinCATADSSim () { Destroy (); }
+
+  // each controller simulates its own PLC, the virtual PLC is never shared...
+
+  static CString GetConnectionKey (WORD, CTwinCATADS::SVirtualPLC const &) { return CString (); }
+
+  virtual void Create (WORD portNumber) override final
+    {
+      Open (portNumber);
+    }
+
+private:
+  virtual long SyncWriteReq (AmsAddr       & amsAddr,
+                             unsigned long   indexGroup,
+                             unsigned long   indexOffset,
+                             unsigned long   length,
+                             void          * pData) override final;
+  virtual long SyncReadWriteReq (AmsAddr       & amsAddr,
+                                 unsigned long   indexGroup,
+                                 unsigned long   indexOffset,
+                                 unsigned long   cbReadLength,
+                                 void          * pReadData,
+                                 unsigned long   cbWriteLength,
+                                 void          * pWriteData) override final;
+  virtual long SyncAddDeviceNotificationReq (AmsAddr               & amsAddr,
+                                             unsigned long           indexGroup,
+                                             unsigned long           indexOffset,
+                                             AdsNotificationAttrib * adsNotificationAttrib,
+                                             void                  * pNoteFunc,
+                                             unsigned long           hUser,
+                                             unsigned long         * pNotification) override final;
+  virtual long SyncDelDeviceNotificationReq (AmsAddr       & amsAddr,
+                                             unsigned long   hNotification) override final;
+  virtual long SumAddDeviceNotificationReq (AmsAddr                        & amsAddr,
+                                            std::vector <SNotificationReq> & notificationReq) override final
+    {
+      // a sum request does not carry the callbacks, add the notifications one at a time...
+
+      return AddDeviceNotificationReqs (amsAddr, notificationReq);
+    }
+  virtual long SumDelDeviceNotificationReq (AmsAddr                        & amsAddr,
+                                            std::vector <SNotificationReq> & notificationReq) override final
+    {
+      return DelDeviceNotificationReqs (amsAddr, notificationReq);
+    }
+  virtual long PortOpen (void) override final;
+  virtual void PortClose (void) override final;
+  virtual long GetLocalAddress (AmsAddr & amsAddr) override final;
+  virtual long GetDllVersion (void) override final { return 0; }
+  virtual bool IsConcurrent (void) const override final { return true; }
+
+  virtual bool OnStartup (void) override final { return true; }
+  virtual bool OnRun (void) override final;
+  virtual void OnShutdown (void) override final {}
+
+  struct SVariable
+  {
+    std::vector <BYTE> data;
+    ULONGLONG          changeCount;
+  };
+
+  struct SNotification
+  {
+    ULONG                 hSymbol;
+    AdsNotificationAttrib adsNotificationAttrib;
+    void                * pNoteFunc;
+    unsigned long         hUser;
+    ULONGLONG                             changeCount;
+    std::chrono::steady_clock::time_point dueTime;
+  };
+
+#pragma pack (push, 1)
+  struct SSumWriteReq
+  {
+    ULONG indexGroup;
+    ULONG indexOffset;
+    ULONG length;
+  };
+
+  struct SSumReadWriteReq
+  {
+    ULONG indexGroup;
+    ULONG indexOffset;
+    ULONG readLength;
+    ULONG writeLength;
+  };
+
+  struct SSumReadWriteRes
+  {
+    ULONG result;
+    ULONG length;
+  };
+#pragma pack (pop)
+
+  long Invoke (void);
+
+  static void WaitUntil (std::chrono::steady_clock::time_point deadline);
+
+  ULONG GetVariable (std::string const & symbolName);
+
+  long Write (ULONG indexGroup, ULONG indexOffset, ULONG length, BYTE const * pData);
+  long ReadWrite (ULONG          indexGroup,
+                  ULONG          indexOffset,
+                  ULONG          cbReadLength,
+                  BYTE         * pReadData,
+                  ULONG          cbWriteLength,
+                  BYTE   const * pWriteData,
+                  ULONG        & cbReturn);
+  long SumWrite (ULONG count, ULONG cbReadLength, BYTE * pReadData, ULONG cbWriteLength, BYTE const * pWriteData);
+  long SumReadWrite (ULONG count, ULONG cbReadLength, BYTE * pReadData, ULONG cbWriteLength, BYTE const * pWriteData);
+
+  static WORD                      const SOURCE_PORT_BASE;
+  static std::chrono::milliseconds const PLC_CYCLE_TIME;
+  static std::chrono::milliseconds const SLEEP_GRANULARITY;
+  static BYTE                      const SYMBOL_VERSION;
+
+  static std::array <std::pair <char const *, char const *>, 3> const m_handshake;
+
+  static std::atomic_int32_t m_portCount;
+
+  CTwinCATADS::SVirtualPLC const m_virtualPLC;
+  AmsAddr m_source;
+  std::mutex m_randomGate;
+  std::mt19937 m_random;
+  std::mutex m_variableGate;
+  std::vector <SVariable> m_variable;
+  std::map <std::string, ULONG> m_mapVariable;
+  std::map <ULONG, SNotification> m_notification;
+  std::vector <std::pair <ULONG, ULONG>> m_acknowledge;
+  ULONG m_hNotification;
+  std::chrono::steady_clock::time_point m_cycleStart;
+  PDCLib::CWorkerThread m_workerThread;
+
+public:
+  CTwinCATADSSim (CTwinCATADSSim const &) = delete;
+  CTwinCATADSSim & operator = (CTwinCATADSSim const &) = delete;
+};
+
+WORD                                   const CTwinCATADSSim::SOURCE_PORT_BASE                (32768);
+std::chrono::milliseconds              const CTwinCATADSSim::PLC_CYCLE_TIME                  (1);
+std::chrono::milliseconds              const CTwinCATADSSim::SLEEP_GRANULARITY               (20);
+BYTE                                   const CTwinCATADSSim::SYMBOL_VERSION                  (1);
+
+std::atomic_int32_t                          CTwinCATADSSim::m_portCount                     (0);
+
+// the virtual PLC raises the acknowledge of a handshake for as long as the host holds the request...
+
+std::array <std::pair <char const *, char const *>, 3> const CTwinCATADSSim::m_handshake
+{{
+  { "BeginMotion", "MotionComplete"  },
+  { "StopMotion",  "MotionStopped"   },
+  { "RunProgram",  "ProgramComplete" },
+}};
+
+CTwinCATADSSim::CTwinCATADSSim (CTwinCATADS::SVirtualPLC const & virtualPLC) :
+  m_virtualPLC (virtualPLC),
+  m_random (std::random_device {} ()),
+  m_hNotification (0),
+  m_cycleStart (std::chrono::steady_clock::now ()),
+  m_workerThread (*this)
+{
+  ::memset (&m_source, 0, sizeof (m_source));
+}
+
+long
+CTwinCATADSSim::SyncWriteReq (AmsAddr       & /* amsAddr */,
+                              unsigned long   indexGroup,
+                              unsigned long   indexOffset,
+                              unsigned long   length,
+                              void          * pData)
+{
+  if (auto const l_error (Invoke ()); l_error != ADSERR_NOERR)
+    {
+      return l_error;
+    }
+
+  std::unique_lock <std::mutex> l_variableGate { m_variableGate };
+
+  return Write (indexGroup, indexOffset, length, static_cast <BYTE const *> (pData));
+}
+
+long
+CTwinCATADSSim::SyncReadWriteReq (AmsAddr       & /* amsAddr */,
+                                  unsigned long   indexGroup,
+                                  unsigned long   indexOffset,
+                                  unsigned long   cbReadLength,
+                                  void          * pReadData,
+                                  unsigned long   cbWriteLength,
+                                  void          * pWriteData)
+{
+  if (auto const l_error (Invoke ()); l_error != ADSERR_NOERR)
+    {
+      return l_error;
+    }
+
+  std::unique_lock <std::mutex> l_variableGate { m_variableGate };
+
+  switch (indexGroup)
+    {
+      case ADSIGRP_SUMUP_WRITE:
+        return SumWrite (indexOffset, cbReadLength, static_cast <BYTE *> (pReadData), cbWriteLength, static_cast <BYTE const *> (pWriteData));
+
+      case ADSIGRP_SUMUP_READWRITE:
+        return SumReadWrite (indexOffset, cbReadLength, static_cast <BYTE *> (pReadData), cbWriteLength, static_cast <BYTE const *> (pWriteData));
+
+      default:
+        {
+          ULONG l_cbReturn (0);
+
+          return ReadWrite (indexGroup, indexOffset, cbReadLength, static_cast <BYTE *> (pReadData), cbWriteLength, static_cast <BYTE const *> (pWriteData), l_cbReturn);
+        }
+    }
+}
+
+long
+CTwinCATADSSim::SyncAddDeviceNotificationReq (AmsAddr               & /* amsAddr */,
+                                              unsigned long           indexGroup,
+                                              unsigned long           indexOffset,
+                                              AdsNotificationAttrib * adsNotificationAttrib,
+                                              void                  * pNoteFunc,
+                                              unsigned long           hUser,
+                                              unsigned long         * pNotification)
+{
+  if (auto const l_error (Invoke ()); l_error != ADSERR_NOERR)
+    {
+      return l_error;
+    }
+
+  std::unique_lock <std::mutex> l_variableGate { m_variableGate };
+
+  // the virtual PLC never changes its symbol version, only symbol values are notified...
+
+  if (indexGroup != ADSIGRP_SYM_VALBYHND)
+    {
+      return ADSERR_DEVICE_SRVNOTSUPP;
+    }
+
+  if ((indexOffset == 0) || (indexOffset > m_variable.size ()))
+    {
+      return ADSERR_DEVICE_SYMBOLNOTFOUND;
+    }
+
+  if ((adsNotificationAttrib->nTransMode != ADSTRANS_SERVERCYCLE) && (adsNotificationAttrib->nTransMode != ADSTRANS_SERVERONCHA))
+    {
+      return ADSERR_DEVICE_SRVNOTSUPP;
+    }
+
+  // the variable takes on the size of its first subscriber if it has not been written yet...
+
+  if (auto & l_variable (m_variable[indexOffset - 1]); l_variable.data.size () < adsNotificationAttrib->cbLength)
+    {
+      l_variable.data.resize (adsNotificationAttrib->cbLength, 0);
+    }
+
+  // the current value is sent on the next cycle, as a PLC does when a notification is added...
+
+  *pNotification = ++m_hNotification;
+
+  m_notification[*pNotification] = { indexOffset, *adsNotificationAttrib, pNoteFunc, hUser, ULLONG_MAX, {} };
+
+  return ADSERR_NOERR;
+}
+
+long
+CTwinCATADSSim::SyncDelDeviceNotificationReq (AmsAddr       & /* amsAddr */,
+                                              unsigned long   hNotification)
+{
+  if (auto const l_error (Invoke ()); l_error != ADSERR_NOERR)
+    {
+      return l_error;
+    }
+
+  std::unique_lock <std::mutex> l_variableGate { m_variableGate };
+
+  return (m_notification.erase (hNotification) != 0) ? ADSERR_NOERR : ADSERR_DEVICE_NOTIFYHNDINVALID;
+}
+
+long
+CTwinCATADSSim::PortOpen (void)
+{
+  if (!m_workerThread.Create ())
+    {
+      PDCLib::ThrowStringException (_T ("unable to create TwinCAT ADS virtual PLC"));
+    }
+
+  m_source.port = static_cast <WORD> (SOURCE_PORT_BASE + (++m_portCount % SOURCE_PORT_BASE));
+
+  return m_source.port;
+}
+
+void
+CTwinCATADSSim::PortClose (void)
+{
+  if (m_workerThread.IsCreated ())
+    {
+      m_workerThread.Terminate ();
+    }
+
+  std::unique_lock <std::mutex> l_variableGate { m_variableGate };
+
+  m_notification.clear ();
+}
+
+long
+CTwinCATADSSim::GetLocalAddress (AmsAddr & amsAddr)
+{
+  // the virtual PLC runs on the local system, 127.0.0.1.1.1...
+
+  AmsNetId const l_netId { { 127, 0, 0, 1, 1, 1 } };
+
+  amsAddr.netId = m_source.netId = l_netId;
+
+  return ADSERR_NOERR;
+}
+
+bool
+CTwinCATADSSim::OnRun (void)
+{
+  // the cycle is paced on the steady clock, a late cycle starts at once and is not made up...
+
+  m_cycleStart = std::max (m_cycleStart + PLC_CYCLE_TIME, std::chrono::steady_clock::now ());
+
+  WaitUntil (m_cycleStart);
+
+  std::vector <std::tuple <std::vector <BYTE>, void *, unsigned long>> l_sample;
+
+  {
+    std::unique_lock <std::mutex> l_variableGate { m_variableGate };
+
+    for (auto&& l_acknowledge : m_acknowledge)
+      {
+        auto const & l_request (m_variable[std::get <0> (l_acknowledge) - 1]);
+        auto       & l_variable (m_variable[std::get <1> (l_acknowledge) - 1]);
+
+        if (l_variable.data != l_request.data)
+          {
+            l_variable.data = l_request.data;
+
+            ++l_variable.changeCount;
+          }
+      }
+
+    auto const l_fileTime (GetHostFileTime ());
+
+    for (auto&& l_notification : m_notification)
+      {
+        auto       & l_note (std::get <1> (l_notification));
+        auto const & l_variable (m_variable[l_note.hSymbol - 1]);
+
+        // the cycle time is in 100 ns units, the virtual PLC checks its notifications once per cycle...
+
+        if ((m_cycleStart < l_note.dueTime) || ((l_note.adsNotificationAttrib.nTransMode == ADSTRANS_SERVERONCHA) && (l_note.changeCount == l_variable.changeCount)))
+          {
+            continue;
+          }
+
+        l_note.changeCount = l_variable.changeCount;
+        l_note.dueTime     = m_cycleStart + std::max <std::chrono::steady_clock::duration> (std::chrono::microseconds (l_note.adsNotificationAttrib.nCycleTime / 10), PLC_CYCLE_TIME);
+
+        auto const l_cbSampleSize (l_note.adsNotificationAttrib.cbLength);
+
+        std::vector <BYTE> l_notificationData (std::max (sizeof (AdsNotificationHeader), offsetof (AdsNotificationHeader, data) + l_cbSampleSize), 0);
+
+        auto const l_adsNotificationHeader (reinterpret_cast <AdsNotificationHeader *> (&l_notificationData[0]));
+
+        l_adsNotificationHeader->hNotification = std::get <0> (l_notification);
+        l_adsNotificationHeader->nTimeStamp    = l_fileTime;
+        l_adsNotificationHeader->cbSampleSize  = l_cbSampleSize;
+
+        if (auto const l_cbData (std::min <size_t> (l_cbSampleSize, l_variable.data.size ())); l_cbData > 0)
+          {
+            ::memcpy_s (l_adsNotificationHeader->data, l_notificationData.size () - offsetof (AdsNotificationHeader, data), &l_variable.data[0], l_cbData);
+          }
+
+        l_sample.emplace_back (std::move (l_notificationData), l_note.pNoteFunc, l_note.hUser);
+
+        BeginDispatch (l_note.hUser);
+      }
+  }
+
+  // the callbacks are made outside the gate so that they may issue requests of their own...
+
+  for (auto&& l_notification : l_sample)
+    {
+      AmsAddr l_amsAddr (m_source);
+
+      reinterpret_cast <PAdsNotificationFuncEx> (std::get <1> (l_notification)) (&l_amsAddr,
+                                                                                 reinterpret_cast <AdsNotificationHeader *> (&std::get <0> (l_notification)[0]),
+                                                                                 std::get <2> (l_notification));
+
+      EndDispatch (std::get <2> (l_notification));
+    }
+
+  return true;
+}
+
+long
+CTwinCATADSSim::Invoke (void)
+{
+  // emulate the round trip to the PLC, then decide whether the request fails...
+
+  DWORD l_latency (m_virtualPLC.latency);
+  bool  l_isFailed (false);
+
+  {
+    std::unique_lock <std::mutex> l_randomGate { m_randomGate };
+
+    if (m_virtualPLC.jitter > 0)
+      {
+        l_latency += std::uniform_int_distribution <DWORD> (0, m_virtualPLC.jitter) (m_random);
+      }
+
+    if (m_virtualPLC.errorRate > 0.0)
+      {
+        l_isFailed = std::bernoulli_distribution (m_virtualPLC.errorRate) (m_random);
+      }
+  }
+
+  if (l_latency > 0)
+    {
+      WaitUntil (std::chrono::steady_clock::now () + std::chrono::microseconds (l_latency));
+    }
+
+  return l_isFailed ? m_virtualPLC.errorCode : ADSERR_NOERR;
+}
+
+void
+CTwinCATADSSim::WaitUntil (std::chrono::steady_clock::time_point deadline)
+{
+  // a sleeping thread only wakes on a scheduler tick, sleep while the deadline is further away than
+  // that and spin out the rest on the steady clock, which is the performance counter...
+
+  for (auto l_now (std::chrono::steady_clock::now ()); l_now < deadline; l_now = std::chrono::steady_clock::now ())
+    {
+      if ((deadline - l_now) > SLEEP_GRANULARITY)
+        {
+          std::this_thread::sleep_for (deadline - l_now - SLEEP_GRANULARITY);
+        }
+      else
+        {
+          std::this_thread::yield ();
+        }
+    }
+}
+
+ULONG
+CTwinCATADSSim::GetVariable (std::string const & symbolName)
+{
+  // every name resolves, a variable is created the first time it is asked for...
+
+  if (auto const l_variable (m_mapVariable.find (symbolName)); l_variable != m_mapVariable.end ())
+    {
+      return std::get <1> (*l_variable);
+    }
+
+  m_variable.push_back ({ {}, 0 });
+
+  auto const l_hSymbol (static_cast <ULONG> (m_variable.size ()));
+
+  m_mapVariable.emplace (symbolName, l_hSymbol);
+
+  // a handshake request is paired with the acknowledge of the same controller...
+
+  for (auto&& l_handshake : m_handshake)
+    {
+      std::string const l_request (std::get <0> (l_handshake));
+
+      if ((symbolName.size () >= l_request.size ()) && (symbolName.compare (symbolName.size () - l_request.size (), l_request.size (), l_request) == 0))
+        {
+          m_acknowledge.emplace_back (l_hSymbol, GetVariable (symbolName.substr (0, symbolName.size () - l_request.size ()) + std::get <1> (l_handshake)));
+        }
+    }
+
+  return l_hSymbol;
+}
+
+long
+CTwinCATADSSim::Write (ULONG indexGroup, ULONG indexOffset, ULONG length, BYTE const * pData)
+{
+  switch (indexGroup)
+    {
+      case ADSIGRP_SYM_VALBYHND:
+        {
+          if ((indexOffset == 0) || (indexOffset > m_variable.size ()))
+            {
+              return ADSERR_DEVICE_SYMBOLNOTFOUND;
+            }
+
+          auto & l_variable (m_variable[indexOffset - 1]);
+
+          if (!std::equal (pData, pData + length, l_variable.data.begin (), l_variable.data.end ()))
+            {
+              l_variable.data.assign (pData, pData + length);
+
+              ++l_variable.changeCount;
+            }
+
+          return ADSERR_NOERR;
+        }
+
+      case ADSIGRP_SYM_RELEASEHND:
+        {
+          // handles are stable for the life of the virtual PLC, there is nothing to release...
+
+          return ((indexOffset == 0) && (length == sizeof (ULONG))) ? ADSERR_NOERR : ADSERR_DEVICE_INVALIDSIZE;
+        }
+
+      default:
+        return ADSERR_DEVICE_INVALIDGRP;
+    }
+}
+
+long
+CTwinCATADSSim::ReadWrite (ULONG          indexGroup,
+                           ULONG          indexOffset,
+                           ULONG          cbReadLength,
+                           BYTE         * pReadData,
+                           ULONG          cbWriteLength,
+                           BYTE   const * pWriteData,
+                           ULONG        & cbReturn)
+{
+  cbReturn = 0;
+
+  switch (indexGroup)
+    {
+      case ADSIGRP_SYM_HNDBYNAME:
+        {
+          if (cbReadLength < sizeof (ULONG))
+            {
+              return ADSERR_DEVICE_INVALIDSIZE;
+            }
+
+          std::string const l_symbolName (pWriteData, std::find (pWriteData, pWriteData + cbWriteLength, '\0'));
+
+          if (l_symbolName.empty ())
+            {
+              return ADSERR_DEVICE_SYMBOLNOTFOUND;
+            }
+
+          *reinterpret_cast <ULONG *> (pReadData) = GetVariable (l_symbolName);
+
+          cbReturn = sizeof (ULONG);
+
+          return ADSERR_NOERR;
+        }
+
+      case ADSIGRP_SYM_VALBYHND:
+        {
+          if ((indexOffset == 0) || (indexOffset > m_variable.size ()))
+            {
+              return ADSERR_DEVICE_SYMBOLNOTFOUND;
+            }
+
+          if (cbWriteLength > 0)
+            {
+              return Write (indexGroup, indexOffset, cbWriteLength, pWriteData);
+            }
+
+          auto const & l_variable (m_variable[indexOffset - 1]);
+
+          cbReturn = static_cast <ULONG> (std::min <size_t> (cbReadLength, l_variable.data.size ()));
+
+          if (cbReturn > 0)
+            {
+              ::memcpy_s (pReadData, cbReadLength, &l_variable.data[0], cbReturn);
+            }
+
+          return ADSERR_NOERR;
+        }
+
+      case ADSIGRP_SYM_VERSION:
+        {
+          if (cbReadLength < sizeof (SYMBOL_VERSION))
+            {
+              return ADSERR_DEVICE_INVALIDSIZE;
+            }
+
+          *pReadData = SYMBOL_VERSION;
+
+          cbReturn = sizeof (SYMBOL_VERSION);
+
+          return ADSERR_NOERR;
+        }
+
+      default:
+        return ADSERR_DEVICE_INVALIDGRP;
+    }
+}
+
+long
+CTwinCATADSSim::SumWrite (ULONG count, ULONG cbReadLength, BYTE * pReadData, ULONG cbWriteLength, BYTE const * pWriteData)
+{
+  // request: list of {index group, index offset, length} followed by the data, response: list of results...
+
+  if ((cbWriteLength < count * sizeof (SSumWriteReq)) || (cbReadLength < count * sizeof (ULONG)))
+    {
+      return ADSERR_DEVICE_INVALIDSIZE;
+    }
+
+  auto const l_sumWriteReq (reinterpret_cast <SSumWriteReq const *> (pWriteData));
+  auto const l_result (reinterpret_cast <ULONG *> (pReadData));
+
+  auto       l_pData (pWriteData + count * sizeof (SSumWriteReq));
+  auto const l_pEnd (pWriteData + cbWriteLength);
+
+  for (ULONG l_req (0); l_req < count; ++l_req)
+    {
+      if (l_pData + l_sumWriteReq[l_req].length > l_pEnd)
+        {
+          return ADSERR_DEVICE_INVALIDSIZE;
+        }
+
+      l_result[l_req] = Write (l_sumWriteReq[l_req].indexGroup, l_sumWriteReq[l_req].indexOffset, l_sumWriteReq[l_req].length, l_pData);
+
+      l_pData += l_sumWriteReq[l_req].length;
+    }
+
+  return ADSERR_NOERR;
+}
+
+long
+CTwinCATADSSim::SumReadWrite (ULONG count, ULONG cbReadLength, BYTE * pReadData, ULONG cbWriteLength, BYTE const * pWriteData)
+{
+  // request: list of {index group, index offset, read length, write length} followed by the write data,
+  // response: list of {result, length} followed by the read data...
+
+  if ((cbWriteLength < count * sizeof (SSumReadWriteReq)) || (cbReadLength < count * sizeof (SSumReadWriteRes)))
+    {
+      return ADSERR_DEVICE_INVALIDSIZE;
+    }
+
+  auto const l_sumReadWriteReq (reinterpret_cast <SSumReadWriteReq const *> (pWriteData));
+  auto const l_sumReadWriteRes (reinterpret_cast <SSumReadWriteRes *> (pReadData));
+
+  auto       l_pWriteData (pWriteData + count * sizeof (SSumReadWriteReq));
+  auto const l_pWriteEnd (pWriteData + cbWriteLength);
+  auto       l_pReadData (pReadData + count * sizeof (SSumReadWriteRes));
+  auto const l_pReadEnd (pReadData + cbReadLength);
+
+  for (ULONG l_req (0); l_req < count; ++l_req)
+    {
+      auto const & l_sumReq (l_sumReadWriteReq[l_req]);
+
+      if ((l_pWriteData + l_sumReq.writeLength > l_pWriteEnd) || (l_pReadData + l_sumReq.readLength > l_pReadEnd))
+        {
+          return ADSERR_DEVICE_INVALIDSIZE;
+        }
+
+      l_sumReadWriteRes[l_req].result = ReadWrite (l_sumReq.indexGroup,
+                                                   l_sumReq.indexOffset,
+                                                   l_sumReq.readLength,
+                                                   l_pReadData,
+                                                   l_sumReq.writeLength,
+                                                   l_pWriteData,
+                                                   l_sumReadWriteRes[l_req].length);
+
+      // the read data is packed, each entry occupies only the length it returned...
+
+      l_pReadData  += l_sumReadWriteRes[l_req].length;
+      l_pWriteData += l_sumReq.writeLength;
+    }
+
+  return ADSERR_NOERR;
+}
+
+CTwinCATADS::SNotificationRate const CTwinCATADS::RATE_NONE        { ADSTRANS_NOTRANS,      0,   0 };
+CTwinCATADS::SNotificationRate const CTwinCATADS::RATE_FAST_CYCLIC { ADSTRANS_SERVERCYCLE, 10,   0 };
+CTwinCATADS::SNotificationRate const CTwinCATADS::RATE_ON_CHANGE   { ADSTRANS_SERVERONCHA, 10,   0 };
+CTwinCATADS::SNotificationRate const CTwinCATADS::RATE_STATUS      { ADSTRANS_SERVERONCHA, 50, 100 };
+
+DWORD const CTwinCATADS::TICKS_PER_MILLISECOND (10000);
+
+// indexed by ESymbol, the notification rate is the preset for the variables the PLC sends to us; all
+// of them are notified at the status rate unless SetNotificationRate says otherwise...
+
+std::array <std::tuple <CTwinCATADS::EADSInstance, CString, CTwinCATADS::SNotificationRate>, CTwinCATADS::NUM_SYMBOLS> const CTwinCATADS::m_symbolIdentifier
+{{
+  { EADSInstance::PLC, _T ("Acceleration"),                           RATE_NONE        },
+  { EADSInstance::PLC, _T ("Deceleration"),                           RATE_NONE        },
+  { EADSInstance::PLC, _T ("Jerk"),                                   RATE_NONE        },
+  { EADSInstance::PLC, _T ("Position"),                               RATE_NONE        },
+  { EADSInstance::PLC, _T ("Velocity"),                               RATE_NONE        },
+  { EADSInstance::PLC, _T ("Direction"),                              RATE_NONE        },
+  { EADSInstance::PLC, _T ("BeginMotion"),                            RATE_NONE        },
+  { EADSInstance::PLC, _T ("StopMotion"),                             RATE_NONE        },
+  { EADSInstance::PLC, _T ("MotionComplete"),                         RATE_STATUS      },
+  { EADSInstance::PLC, _T ("MotionStopped"),                          RATE_STATUS      },
+  { EADSInstance::PLC, _T ("MotionFaulted"),                          RATE_STATUS      },
+  { EADSInstance::PLC, _T ("RunProgram"),                             RATE_NONE        },
+  { EADSInstance::PLC, _T ("StopProgram"),                            RATE_NONE        },
+  { EADSInstance::PLC, _T ("ProgramComplete"),                        RATE_STATUS      },
+  { EADSInstance::PLC, _T ("FaultCode"),                              RATE_STATUS      },
+  { EADSInstance::PLC, _T ("ProgramStatus"),                          RATE_STATUS      },
+  { EADSInstance::PLC, _T ("ActualPosition"),                         RATE_STATUS      },
+  { EADSInstance::PLC, _T ("ActualVelocity"),                         RATE_STATUS      },
+  { EADSInstance::PLC, _T ("ControllerStatus"),                       RATE_STATUS      },
+  { EADSInstance::PLC, _T ("SegmentBuffer"),                          RATE_NONE        },
+  { EADSInstance::PLC, _T ("SegmentWritten"),                         RATE_NONE        },
+  { EADSInstance::PLC, _T ("SegmentRead"),                            RATE_STATUS      },
+  { EADSInstance::AIO, _T ("IOAnalogTask.Inputs.AnalogInputs"),       RATE_STATUS      },
+  { EADSInstance::AIO, _T ("IOAnalogTask.Outputs.AnalogOutputs"),     RATE_NONE        },
+  { EADSInstance::DIO, _T ("IODiscreteTask.Inputs.DiscreteInputs"),   RATE_STATUS      },
+  { EADSInstance::DIO, _T ("IODiscreteTask.Outputs.DiscreteOutputs"), RATE_NONE        }
+}};
+
+CTwinCATADS::MC_Bool      const CTwinCATADS::MC_False              (0x00);
+CTwinCATADS::MC_Bool      const CTwinCATADS::MC_True               (0x01);
+
+CTwinCATADS::MC_Direction const CTwinCATADS::MC_None               (0);
+CTwinCATADS::MC_Direction const CTwinCATADS::MC_Positive           (1);
+CTwinCATADS::MC_Direction const CTwinCATADS::MC_Shortest           (2);
+CTwinCATADS::MC_Direction const CTwinCATADS::MC_Negative           (3);
+CTwinCATADS::MC_Direction const CTwinCATADS::MC_Current            (4);
+
+DWORD                     const CTwinCATADS::DRIVE_STATUS_OK       (::DRIVE_STATUS_OK);
+
+DWORD                     const CTwinCATADS::PROGRAM_NO_FAULT      (::DRIVE_STATUS_OK);
+DWORD                     const CTwinCATADS::PROGRAM_STOPPED_FAULT (0x00EC);
+
+CTwinCATADS::MC_UDInt     const CTwinCATADS::AXIS_NO_FAULT         (0x00000000);
+CTwinCATADS::MC_UDInt     const CTwinCATADS::AXIS_STOPPED_FAULT    (0x00004B00);
+
+ULONGLONG                 const CTwinCATADS::SYMBOL_VERSION_INTERVAL (1000);
+ULONGLONG                 const CTwinCATADS::WAIT_POLL_INTERVAL      (10);
+size_t                    const CTwinCATADS::SEGMENT_FIELDS          (sizeof (SMotionSegment) / sizeof (MC_LReal));
+size_t                    const CTwinCATADS::HANDSHAKE_LANES         (sizeof (__m128i) / sizeof (MC_Bool));
+
+std::array <CString, 268> const CTwinCATADS::m_programStatusMessage
+{
+  /* 0x0000 */ _T ("Drive initialization is incomplete"),
+  /* 0x0001 */ _T ("Drive initialization is running"),
+  /* 0x0002 */ _T ("Drive initialization is complete, drives OK"),
+  /* 0x0003 */ _T ("Axis 1 has faulted"),
+  /* 0x0004 */ _T ("Axis 2 has faulted"),
+  /* 0x0005 */ _T ("Axis 3 has faulted"),
+  /* 0x0006 */ _T ("Axis 4 has faulted"),
+  /* 0x0007 */ _T ("Axis 5 has faulted"),
   /* 0x0008 */ _T ("Axis 6 has faulted"),
   /* 0x0009 */ _T ("Axis 7 has faulted"),
   /* 0x000A */ _T ("Axis 8 has faulted"),
@@ -1041,924 +4637,2789 @@ std::array <CString, 268> const CTwinCATADS::m_programStatusMessage
   /* 0x010B */ _T ("Delidder is not in the up position : check air supply or limit switch")
 };
 
-std::map <DWORD, CString> const CTwinCATADS::m_adsErrorMessage
+std::map <DWORD, CString> const CTwinCATADS::m_adsErrorMessage
+{
+  { 0x4221, _T ("requested set velocity is not allowed") },
+  { 0x422F, _T ("acceleration less than or equal to 0.0 is not allowed") },
+  { 0x4230, _T ("absolute deceleration value less than or equal to 0.0 is not allowed") },
+  { 0x4231, _T ("set velocity less than or equal to 0.0 is not allowed") },
+  { 0x4260, _T ("controller not enabled") },
+  { 0x4263, _T ("motion command issued when current command was not completed") },
+  { 0x4357, _T ("limit switch triggered (negative direction)") },
+  { 0x4358, _T ("limit switch triggered (positive direction)") },
+  { 0x4359, _T ("set velocity not allowed") },
+  { 0x4650, _T ("drive not ready for operation/drive hardware failed") },
+  { 0x4B00, _T ("user abort fault") },
+  { 0x4B09, _T ("TwinCAT axis is not ready or enabled") },
+  { 0x4C00, _T ("TwinCAT issued MC_Stop, limit switch possibilly triggered") }
+};
+
+class CTwinCATADS::CSimAxis final
+{
+public:
+  explicit CSimAxis (CTwinCATADS & twinCATADS, int axis);
+  virtual ~CSimAxis () = default;
+
+  void Run (void);
+
+private:
+  CTwinCATADS & m_twinCATADS;
+  int const m_axis;
+  bool m_beginMotion;
+  double m_p;
+  double m_v;
+  double m_t0;
+  double m_t1;
+  double m_t2;
+  double m_t3;
+
+  inline static double Distance (double a, double t) { return a * t * t / 2.0; }
+
+  static double const MS_PER_SECOND;
+
+public:
+  // copy construction and assignment not allowed for this class
+
+  CSimAxis (const CSimAxis &) = delete;
+  CSimAxis & operator = (const CSimAxis &) = delete;
+};
+
+double const CTwinCATADS::CSimAxis::MS_PER_SECOND (1000.0);
+
+CTwinCATADS::CSimAxis::CSimAxis (CTwinCATADS & twinCATADS, int axis)
+  : m_twinCATADS (twinCATADS)
+  , m_axis (axis)
+  , m_beginMotion (false)
+  , m_p (0.0)
+  , m_v (0.0)
+  , m_t0 (0.0)
+  , m_t1 (0.0)
+  , m_t2 (0.0)
+  , m_t3 (0.0)
+{
+  Run ();
+}
+
+void
+CTwinCATADS::CSimAxis::Run (void)
+{
+  if (m_twinCATADS.m_beginMotion[0][m_axis] || m_twinCATADS.m_stopMotion[0][m_axis])
+    {
+      double const l_acceleration (m_twinCATADS.m_acceleration[m_axis]);
+      double const l_deceleration (m_twinCATADS.m_deceleration[m_axis]);
+      double const l_position (m_twinCATADS.m_position[m_axis]);
+      double const l_velocity (m_twinCATADS.m_velocity[m_axis]);
+      double const l_actualPosition (m_twinCATADS.m_actualPosition[1][m_axis]);
+      DWORD  const l_direction (m_twinCATADS.m_direction[m_axis]);
+
+      if (m_beginMotion)
+        {
+          double const l_t (static_cast <double> (PDCLib::GetTickCount ()) / MS_PER_SECOND);
+
+          double l_p (0.0);
+          double l_v (0.0);
+
+          if (l_t < m_t3)
+            {
+              l_p += Distance (l_acceleration, std::min (l_t, m_t1) - m_t0);
+
+              if (l_t < m_t1)
+                {
+                  // acceleration phase of trajectory...
+
+                  l_v = l_acceleration * (l_t - m_t0);
+
+                  if (m_twinCATADS.m_stopMotion[0][m_axis])
+                    {
+                      m_t1 = l_t;
+
+                      m_t2 = l_t;
+
+                      m_t3 = l_t + l_v / l_deceleration;
+                    }
+                }
+              else
+                {
+                  l_p += m_v * (std::min (l_t, m_t2) - m_t1);
+
+                  if (l_t < m_t2)
+                    {
+                      // target velocity phase of trajectory...
+
+                      l_v  = m_v;
+
+                      if (m_twinCATADS.m_stopMotion[0][m_axis])
+                        {
+                          m_t2 = l_t;
+
+                          m_t3 = l_t + l_v / l_deceleration;
+                        }
+                    }
+                  else
+                    {
+                      // deceleration phase of trajectory...
+
+                      l_p += Distance (l_deceleration, m_t3 - m_t2);
+
+                      l_p -= Distance (l_deceleration, m_t3 - l_t);
+
+                      l_v  = l_deceleration * (m_t3 - l_t);
+                    }
+                }
+            }
+          else
+            {
+              l_p += Distance (l_acceleration, m_t1 - m_t0);
+
+              l_p += m_v * (m_t2 - m_t1);
+
+              l_p += Distance (l_deceleration, m_t3 - m_t2);
+
+              if (m_twinCATADS.m_stopMotion[0][m_axis])
+                {
+                  m_twinCATADS.m_motionStopped[1][m_axis] = CTwinCATADS::MC_True;
+
+                  m_twinCATADS.m_faultCode[1][m_axis] = CTwinCATADS::AXIS_STOPPED_FAULT;
+
+                  PDCLib::Trace (_T ("stopped simulation axis (%ld)"), m_axis);
+                }
+              else
+                {
+                  m_twinCATADS.m_faultCode[1][m_axis] = CTwinCATADS::AXIS_NO_FAULT;
+
+                  PDCLib::Trace (_T ("completed simulation axis (%ld)"), m_axis);
+                }
+
+              m_twinCATADS.m_motionComplete[1][m_axis] = MC_True;
+            }
+
+          if (l_direction)
+            {
+              m_twinCATADS.m_actualPosition[1][m_axis] = (l_direction == CTwinCATADS::MC_Positive) ? (m_p + l_p) : (m_p - l_p);
+            }
+          else
+            {
+              m_twinCATADS.m_actualPosition[1][m_axis] = (l_position > m_p) ? (m_p + l_p) : (m_p - l_p);
+            }
+
+          m_twinCATADS.m_actualVelocity[1][m_axis] = l_v;
+
+          PDCLib::Trace (_T ("simulation (%ld) axis actual position: %.3f"), m_axis, m_twinCATADS.m_actualPosition[1][m_axis]);
+          PDCLib::Trace (_T ("simulation (%ld) axis actual velocity: %.3f"), m_axis, m_twinCATADS.m_actualVelocity[1][m_axis]);
+        }
+      else if ((l_acceleration > 0.0) && (l_deceleration > 0.0) && (l_velocity > 0.0))
+        {
+          if (l_direction)
+            {
+              m_v = l_velocity;
+
+              m_t0 = static_cast <double> (PDCLib::GetTickCount ()) / MS_PER_SECOND;
+
+              m_t1 = m_t0 + (m_v / l_acceleration);
+
+              m_t2 = std::numeric_limits <double>::infinity ();
+
+              m_t3 = m_t2;
+
+              m_p = l_actualPosition;
+
+              m_beginMotion = true;
+
+              PDCLib::Trace (_T ("started simulation axis (%ld)"), m_axis);
+              PDCLib::Trace (_T ("target velocity    : %.3f"), m_v);
+              PDCLib::Trace (_T ("acceleration begin : %.3f"), m_t0);
+              PDCLib::Trace (_T ("acceleration end   : %.3f"), m_t1);
+            }
+          else
+            {
+              double const l_c (((1.0 / l_acceleration) + (1.0 / l_deceleration)) / 2.0);
+
+              double const l_d (std::abs (l_position - l_actualPosition));
+
+              m_v = std::min (std::sqrt (l_d / l_c), l_velocity);
+
+              m_t0 = static_cast <double> (PDCLib::GetTickCount ()) / MS_PER_SECOND;
+
+              m_t1 = m_t0 + (m_v / l_acceleration);
+
+              m_t2 = m_t1 + ((m_v > 0.0) ? ((l_d - m_v * m_v * l_c) / m_v) : 0.0);
+
+              m_t3 = m_t2 + (m_v / l_deceleration);
+
+              m_p = l_actualPosition;
+
+              m_beginMotion = true;
+
+              PDCLib::Trace (_T ("started simulation axis (%ld)"), m_axis);
+              PDCLib::Trace (_T ("actual position    : %.3f"), l_actualPosition);
+              PDCLib::Trace (_T ("target position    : %.3f"), l_position);
+              PDCLib::Trace (_T ("target velocity    : %.3f"), m_v);
+              PDCLib::Trace (_T ("acceleration begin : %.3f"), m_t0);
+              PDCLib::Trace (_T ("acceleration end   : %.3f"), m_t1);
+              PDCLib::Trace (_T ("deceleration begin : %.3f"), m_t2);
+              PDCLib::Trace (_T ("deceleration end   : %.3f"), m_t3);
+            }
+        }
+      else
+        {
+          m_twinCATADS.m_motionComplete[1][m_axis] = CTwinCATADS::MC_True;
+        }
+    }
+  else
+    {
+      m_twinCATADS.m_motionStopped[1][m_axis]  = CTwinCATADS::MC_False;
+      m_twinCATADS.m_motionComplete[1][m_axis] = CTwinCATADS::MC_False;
+
+      m_beginMotion = false;
+    }
+}
+
+class CTwinCATADS::CSimProg final
+{
+public:
+  explicit CSimProg (CTwinCATADS & twinCATADS, int prog);
+  virtual ~CSimProg () = default;
+
+  void Run (void);
+
+private:
+  CTwinCATADS & m_twinCATADS;
+  int const m_prog;
+  bool m_runProgram;
+  ULONGLONG m_t;
+
+  static ULONGLONG const RUN_PROGRAM_DELAY;
+
+public:
+  // copy construction and assignment not allowed for this class
+
+  CSimProg (const CSimProg &) = delete;
+  CSimProg & operator = (const CSimProg &) = delete;
+};
+
+ULONGLONG const CTwinCATADS::CSimProg::RUN_PROGRAM_DELAY (5000);
+
+CTwinCATADS::CSimProg::CSimProg (CTwinCATADS & twinCATADS, int prog)
+  : m_twinCATADS (twinCATADS)
+  , m_prog (prog)
+  , m_runProgram (false)
+  , m_t (0)
+{
+  Run ();
+}
+
+void
+CTwinCATADS::CSimProg::Run (void)
+{
+  if (m_twinCATADS.m_runProgram[0][m_prog])
+    {
+      if (m_runProgram)
+        {
+          if (!m_twinCATADS.m_runProgram[0][m_prog])
+            {
+              m_twinCATADS.m_programStatus[1][m_prog]   = CTwinCATADS::PROGRAM_STOPPED_FAULT;
+
+              m_twinCATADS.m_programComplete[1][m_prog] = CTwinCATADS::MC_True;
+
+              PDCLib::Trace (_T ("stopped simulation program (%ld)"), m_prog);
+            }
+          else if ((PDCLib::GetTickCount () - m_t) > RUN_PROGRAM_DELAY)
+            {
+              m_twinCATADS.m_programStatus[1][m_prog]   = CTwinCATADS::PROGRAM_NO_FAULT;
+
+              m_twinCATADS.m_programComplete[1][m_prog] = CTwinCATADS::MC_True;
+
+              PDCLib::Trace (_T ("completed simulation program (%ld)"), m_prog);
+            }
+        }
+      else
+        {
+          m_t = PDCLib::GetTickCount ();
+
+          m_runProgram = true;
+
+          PDCLib::Trace (_T ("started simulation program (%ld)"), m_prog);
+        }
+    }
+  else
+    {
+      m_twinCATADS.m_programComplete[1][m_prog] = CTwinCATADS::MC_False;
+
+      m_runProgram = false;
+    }
+}
+
+class CTwinCATADS::CAsyncWriter final : public PDCLib::IWorkerThread
+{
+public:
+  explicit CAsyncWriter (std::shared_ptr <ITwinCATADS> const & twinCATADS);
+  virtual ~CAsyncWriter ();
+
+  void Queue (int symbol, size_t cbLength, void const * pData);
+  bool Retry (CString & errorMessage);
+
+  CWriteFuture GetFuture (void);
+
+private:
+  std::shared_ptr <ITwinCATADS> const m_twinCATADS;
+  PDCLib::CWorkerThread m_workerThread;
+  std::mutex m_queueGate;
+  std::condition_variable m_queueEvent;
+  CPendingVariable m_pendingVariable;
+  CPendingVariable m_failedVariable;
+  std::shared_ptr <std::promise <bool>> m_pendingPromise;
+  CWriteFuture m_pendingFuture;
+  CWriteFuture m_activeFuture;
+  CString m_errorMessage;
+
+  virtual bool OnStartup (void) override final { return true; }
+  virtual bool OnRun (void) override final;
+  virtual void OnShutdown (void) override final;
+
+  bool Write (CPendingVariable const & pendingVariable);
+
+  static DWORD const QUEUE_TIMEOUT;
+
+public:
+  // copy construction and assignment not allowed for this class
+
+  CAsyncWriter (const CAsyncWriter &) = delete;
+  CAsyncWriter & operator = (const CAsyncWriter &) = delete;
+};
+
+DWORD const CTwinCATADS::CAsyncWriter::QUEUE_TIMEOUT (10);
+
+CTwinCATADS::CAsyncWriter::CAsyncWriter (std::shared_ptr <ITwinCATADS> const & twinCATADS)
+  : m_twinCATADS (twinCATADS)
+  , m_workerThread (*this)
+{
+  if (!m_workerThread.Create ())
+    {
+      PDCLib::ThrowStringException (_T ("unable to create TwinCAT ADS asynchronous writer"));
+    }
+}
+
+CTwinCATADS::CAsyncWriter::~CAsyncWriter ()
+{
+  m_workerThread.Terminate ();
+}
+
+void
+CTwinCATADS::CAsyncWriter::Queue (int symbol, size_t cbLength, void const * pData)
+{
+  {
+    std::unique_lock <std::mutex> l_queueGate { m_queueGate };
+
+    QueueVariable (m_pendingVariable, symbol, cbLength, pData);
+
+    if (!m_pendingPromise)
+      {
+        m_pendingPromise = std::make_shared <std::promise <bool>> ();
+
+        m_pendingFuture = m_pendingPromise->get_future ().share ();
+      }
+  }
+
+  m_queueEvent.notify_one ();
+}
+
+bool
+CTwinCATADS::CAsyncWriter::Retry (CString & errorMessage)
+{
+  std::unique_lock <std::mutex> l_queueGate { m_queueGate };
+
+  if (!m_failedVariable.empty ())
+    {
+      // failed writes go ahead of the pending writes, unless a newer value for
+      // the same symbol has been queued in the meantime...
+
+      CPendingVariable l_pendingVariable;
+
+      for (auto&& l_failedVariable : m_failedVariable)
+        {
+          if (std::none_of (m_pendingVariable.begin (),
+                            m_pendingVariable.end (),
+                            [&l_failedVariable] (auto const & pendingVariable) { return std::get <0> (pendingVariable) == std::get <0> (l_failedVariable); }))
+            {
+              l_pendingVariable.push_back (l_failedVariable);
+            }
+        }
+
+      l_pendingVariable.insert (l_pendingVariable.end (), m_pendingVariable.begin (), m_pendingVariable.end ());
+
+      m_pendingVariable.swap (l_pendingVariable);
+
+      m_failedVariable.clear ();
+
+      if (!m_pendingVariable.empty () && !m_pendingPromise)
+        {
+          m_pendingPromise = std::make_shared <std::promise <bool>> ();
+
+          m_pendingFuture = m_pendingPromise->get_future ().share ();
+        }
+
+      m_queueEvent.notify_one ();
+    }
+
+  if (m_errorMessage.IsEmpty ())
+    {
+      return true;
+    }
+
+  errorMessage = m_errorMessage;
+
+  m_errorMessage.Empty ();
+
+  return false;
+}
+
+CTwinCATADS::CWriteFuture
+CTwinCATADS::CAsyncWriter::GetFuture (void)
+{
+  std::unique_lock <std::mutex> l_queueGate { m_queueGate };
+
+  if (m_pendingFuture.valid ())
+    {
+      return m_pendingFuture;
+    }
+  else if (m_activeFuture.valid ())
+    {
+      return m_activeFuture;
+    }
+
+  std::promise <bool> l_promise;
+
+  l_promise.set_value (true);
+
+  return l_promise.get_future ().share ();
+}
+
+bool
+CTwinCATADS::CAsyncWriter::OnRun (void)
+{
+  std::unique_lock <std::mutex> l_queueGate { m_queueGate };
+
+  // wake up periodically so that a terminate request is not missed...
+
+  if (m_queueEvent.wait_for (l_queueGate, std::chrono::milliseconds (QUEUE_TIMEOUT), [this] { return !m_pendingVariable.empty (); }))
+    {
+      CPendingVariable l_pendingVariable;
+
+      l_pendingVariable.swap (m_pendingVariable);
+
+      auto const l_pendingPromise (std::move (m_pendingPromise));
+
+      m_pendingPromise = nullptr;
+
+      m_activeFuture = m_pendingFuture;
+
+      m_pendingFuture = CWriteFuture ();
+
+      l_queueGate.unlock ();
+
+      l_pendingPromise->set_value (Write (l_pendingVariable));
+
+      l_queueGate.lock ();
+
+      m_activeFuture = CWriteFuture ();
+    }
+
+  return true;
+}
+
+void
+CTwinCATADS::CAsyncWriter::OnShutdown (void)
+{
+  // drain the queue before the connection is closed...
+
+  std::unique_lock <std::mutex> l_queueGate { m_queueGate };
+
+  if (!m_pendingVariable.empty ())
+    {
+      CPendingVariable l_pendingVariable;
+
+      l_pendingVariable.swap (m_pendingVariable);
+
+      auto const l_pendingPromise (std::move (m_pendingPromise));
+
+      m_pendingPromise = nullptr;
+
+      m_pendingFuture = CWriteFuture ();
+
+      l_queueGate.unlock ();
+
+      l_pendingPromise->set_value (Write (l_pendingVariable));
+    }
+}
+
+bool
+CTwinCATADS::CAsyncWriter::Write (CPendingVariable const & pendingVariable)
+{
+  std::vector <ITwinCATADS::CVariable> l_variables;
+
+  l_variables.reserve (pendingVariable.size ());
+
+  for (auto&& l_pendingVariable : pendingVariable)
+    {
+      l_variables.emplace_back (std::get <0> (l_pendingVariable), std::get <1> (l_pendingVariable).size (), &std::get <1> (l_pendingVariable)[0]);
+    }
+
+  try
+    {
+      m_twinCATADS->SetVariable (l_variables);
+    }
+  catch (CString const & errorMessage)
+    {
+      // failed writes are handed back to the control thread, which reports the
+      // error and queues them again on the next update...
+
+      std::unique_lock <std::mutex> l_queueGate { m_queueGate };
+
+      for (auto&& l_pendingVariable : pendingVariable)
+        {
+          QueueVariable (m_failedVariable, std::get <0> (l_pendingVariable), std::get <1> (l_pendingVariable).size (), &std::get <1> (l_pendingVariable)[0]);
+        }
+
+      m_errorMessage = errorMessage;
+
+      return false;
+    }
+
+  return true;
+}
+
+CTwinCATADS::CTwinCATADS (int  controllerId,
+                          int  numAxes,
+                          int  numPrograms,
+                          bool simulationMode)
+  : m_controllerId (PDCLib::StringWithFormat (_T ("Controller%ld."), controllerId))
+  , m_acceleration (numAxes, 0.0)
+  , m_deceleration (numAxes, 0.0)
+  , m_jerk (numAxes, 0.0)
+  , m_position (numAxes, 0.0)
+  , m_velocity (numAxes, 0.0)
+  , m_direction (numAxes, MC_None)
+  , m_stopProgram (numPrograms, MC_False)
+  , m_writeMode (EWriteMode::Immediate)
+  , m_statusMode (EStatusMode::Separate)
+  , m_isSegmentQueue (false)
+  , m_symbolVersionTick (0)
+  , m_notificationCount (0)
+  , m_waiterCount (0)
+  , m_positionThreshold (numAxes)
+{
+  ASSERT (controllerId >= 0);
+  ASSERT (numAxes >= 0);
+  ASSERT (numPrograms >= 0);
+
+  for (int l_symbol (0); l_symbol < NUM_SYMBOLS; ++l_symbol)
+    {
+      m_symbolName[l_symbol] = GetSymbolName (std::get <0> (m_symbolIdentifier[l_symbol]), std::get <1> (m_symbolIdentifier[l_symbol]));
+      m_notificationRate[l_symbol] = std::get <2> (m_symbolIdentifier[l_symbol]);
+    }
+
+  m_symbol.fill (-1);
+
+  AllocInputs (m_beginMotion, numAxes, MC_False, MC_True);
+  AllocInputs (m_stopMotion, numAxes, MC_False, MC_True);
+  AllocInputs (m_motionComplete, numAxes);
+  AllocInputs (m_motionStopped, numAxes);
+  AllocInputs (m_motionFaulted, numAxes);
+  AllocInputs (m_runProgram, numPrograms, MC_False, MC_True);
+  AllocInputs (m_programComplete, numPrograms);
+  AllocInputs (m_faultCode, numAxes);
+  AllocInputs (m_programStatus, numPrograms);
+  AllocInputs (m_actualPosition, numAxes);
+  AllocInputs (m_actualVelocity, numAxes);
+  AllocInputs (m_controllerStatus, (numAxes * (2 * sizeof (MC_LReal) + sizeof (MC_UDInt) + 3 * sizeof (MC_Bool))) + (numPrograms * (sizeof (MC_UDInt) + sizeof (MC_Bool))));
+  AllocInputs (m_analogInputs, XShim <SAnalogInputs>::size);
+  AllocInputs (m_discreteInputs, XShim <SDiscreteInputs>::size);
+
+  m_changedAxes.resize ((numAxes + 7) / 8, 0);
+  m_changedPrograms.resize ((numPrograms + 7) / 8, 0);
+
+  for (auto&& l_positionThreshold : m_positionThreshold)
+    {
+      l_positionThreshold = std::numeric_limits <double>::quiet_NaN ();
+    }
+
+  ClrLatencyHistograms ();
+
+  if (simulationMode)
+    {
+      for (int l_axis (0); l_axis < numAxes; ++l_axis)
+        {
+          CSimAxisPtr l_simAxis (new CSimAxis (*this, l_axis));
+
+          m_simAxis.push_back (l_simAxis);
+        }
+
+      for (int l_prog (0); l_prog < numPrograms; ++l_prog)
+        {
+          CSimProgPtr l_simProg (new CSimProg (*this, l_prog));
+
+          m_simProg.push_back (l_simProg);
+        }
+    }
+}
+
+CTwinCATADS::~CTwinCATADS ()
+{
+  if (m_createFuture.valid ())
+    {
+      m_createFuture.wait ();
+    }
+
+  // the connections may outlive this controller, its notifications must not...
+
+  for (auto&& l_twinCATADS : m_twinCATADS)
+    {
+      l_twinCATADS->UnRegisterNotification (this);
+    }
+}
+
+bool
+CTwinCATADS::Create (void)
+{
+  return Create_ ();
+}
+
+bool
+CTwinCATADS::Create (CString const & hostName, CString const & amsNetId)
+{
+  m_hostName = hostName;
+  m_amsNetId = amsNetId;
+
+  return Create_ ();
+}
+
+bool
+CTwinCATADS::Create (CString const & hostName, CString const & amsNetId, WORD analogPortNumber, WORD discretePortNumber)
+{
+  m_hostName = hostName;
+  m_amsNetId = amsNetId;
+
+  return Create (analogPortNumber, discretePortNumber);
+}
+
+bool
+CTwinCATADS::Create (SVirtualPLC const & virtualPLC)
+{
+  if ((virtualPLC.errorRate < 0.0) || (virtualPLC.errorRate > 1.0))
+    {
+      m_errorMessage = _T ("virtual PLC error rate is out of range");
+
+      return false;
+    }
+
+  m_virtualPLC = std::make_unique <SVirtualPLC> (virtualPLC);
+
+  return Create_ ();
+}
+
+bool
+CTwinCATADS::Create (SVirtualPLC const & virtualPLC, WORD analogPortNumber, WORD discretePortNumber)
+{
+  if ((virtualPLC.errorRate < 0.0) || (virtualPLC.errorRate > 1.0))
+    {
+      m_errorMessage = _T ("virtual PLC error rate is out of range");
+
+      return false;
+    }
+
+  m_virtualPLC = std::make_unique <SVirtualPLC> (virtualPLC);
+
+  return Create (analogPortNumber, discretePortNumber);
+}
+
+bool
+CTwinCATADS::Create (WORD analogPortNumber, WORD discretePortNumber)
+{
+  if (analogPortNumber == discretePortNumber)
+    {
+      m_errorMessage = _T ("analog and discrete port numbers must be unique");
+    }
+  else if ((analogPortNumber < AMSPORT_R0_IO) || (discretePortNumber < AMSPORT_R0_IO))
+    {
+      m_errorMessage = _T ("analog or discrete port number is out of range");
+    }
+  else if ((analogPortNumber < AMSPORT_R0_SPS) && (discretePortNumber < AMSPORT_R0_SPS))
+    {
+      return Create_ (analogPortNumber, discretePortNumber);
+    }
+  else
+    {
+      m_errorMessage = _T ("analog or discrete port number is out of range");
+    }
+
+  return false;
+}
+
+void
+CTwinCATADS::SetCreateProgress (CCreateProgress const & createProgress)
+{
+  m_createProgress = createProgress;
+}
+
+CTwinCATADS::CCreateFuture
+CTwinCATADS::CreateAsync (void)
+{
+  return CreateAsync_ ([this] { return Create (); });
+}
+
+CTwinCATADS::CCreateFuture
+CTwinCATADS::CreateAsync (WORD analogPortNumber, WORD discretePortNumber)
+{
+  return CreateAsync_ ([this, analogPortNumber, discretePortNumber] { return Create (analogPortNumber, discretePortNumber); });
+}
+
+CTwinCATADS::CCreateFuture
+CTwinCATADS::CreateAsync (CString const & hostName, CString const & amsNetId)
+{
+  return CreateAsync_ ([this, hostName, amsNetId] { return Create (hostName, amsNetId); });
+}
+
+CTwinCATADS::CCreateFuture
+CTwinCATADS::CreateAsync (CString const & hostName, CString const & amsNetId, WORD analogPortNumber, WORD discretePortNumber)
+{
+  return CreateAsync_ ([this, hostName, amsNetId, analogPortNumber, discretePortNumber] { return Create (hostName, amsNetId, analogPortNumber, discretePortNumber); });
+}
+
+CTwinCATADS::CCreateFuture
+CTwinCATADS::CreateAsync (SVirtualPLC const & virtualPLC)
+{
+  return CreateAsync_ ([this, virtualPLC] { return Create (virtualPLC); });
+}
+
+CTwinCATADS::CCreateFuture
+CTwinCATADS::CreateAsync (SVirtualPLC const & virtualPLC, WORD analogPortNumber, WORD discretePortNumber)
+{
+  return CreateAsync_ ([this, virtualPLC, analogPortNumber, discretePortNumber] { return Create (virtualPLC, analogPortNumber, discretePortNumber); });
+}
+
+template <typename F> CTwinCATADS::CCreateFuture
+CTwinCATADS::CreateAsync_ (F && create)
+{
+  // the future is also kept here, so that discarding it neither blocks the caller nor lets the
+  // controller be destroyed under the creating thread...
+
+  if (m_createFuture.valid () || !m_twinCATADS.empty ())
+    {
+      m_errorMessage = _T ("TwinCAT ADS interface has already been created");
+
+      std::promise <bool> l_promise;
+
+      l_promise.set_value (false);
+
+      return l_promise.get_future ().share ();
+    }
+
+  return m_createFuture = std::async (std::launch::async, std::forward <F> (create)).share ();
+}
+
+void
+CTwinCATADS::ReportProgress (ECreateStage createStage) const
+{
+  if (m_createProgress)
+    {
+      m_createProgress (createStage);
+    }
+}
+
+void
+CTwinCATADS::UpdateInputs (void)
+{
+  std::fill (m_changedAxes.begin (), m_changedAxes.end (), static_cast <BYTE> (0));
+  std::fill (m_changedPrograms.begin (), m_changedPrograms.end (), static_cast <BYTE> (0));
+
+  if (!m_simAxis.empty () || !m_simProg.empty ())
+    {
+      // the simulation stands in for the notification thread...
+
+      auto const l_timeStamp (GetHostFileTime ());
+
+      Publish (VAR_ACTUALPOSITION, m_actualPosition, m_actualPosition[1].data (), l_timeStamp);
+      Publish (VAR_ACTUALVELOCITY, m_actualVelocity, m_actualVelocity[1].data (), l_timeStamp);
+      Publish (VAR_MOTIONCOMPLETE, m_motionComplete, m_motionComplete[1].data (), l_timeStamp);
+      Publish (VAR_MOTIONSTOPPED, m_motionStopped, m_motionStopped[1].data (), l_timeStamp);
+      Publish (VAR_MOTIONFAULTED, m_motionFaulted, m_motionFaulted[1].data (), l_timeStamp);
+      Publish (VAR_FAULTCODE, m_faultCode, m_faultCode[1].data (), l_timeStamp);
+      Publish (VAR_PROGRAMCOMPLETE, m_programComplete, m_programComplete[1].data (), l_timeStamp);
+      Publish (VAR_PROGRAMSTATUS, m_programStatus, m_programStatus[1].data (), l_timeStamp);
+    }
+
+  if (m_controllerStatus.Acquire ())
+    {
+      // one sample carries every status variable from the same PLC cycle...
+
+      MC_Byte const * l_pData (m_controllerStatus[0].data ());
+
+      Unpack (m_actualPosition, l_pData, m_changedAxes);
+      Unpack (m_actualVelocity, l_pData, m_changedAxes);
+      Unpack (m_faultCode, l_pData, m_changedAxes);
+      Unpack (m_programStatus, l_pData, m_changedPrograms);
+      Unpack (m_motionComplete, l_pData, m_changedAxes);
+      Unpack (m_motionStopped, l_pData, m_changedAxes);
+      Unpack (m_motionFaulted, l_pData, m_changedAxes);
+      Unpack (m_programComplete, l_pData, m_changedPrograms);
+    }
+
+  // take the newest complete sample of each variable, never waiting on the notification thread...
+
+  AcquireInputs (m_actualPosition, m_changedAxes);
+  AcquireInputs (m_actualVelocity, m_changedAxes);
+  AcquireInputs (m_motionComplete, m_changedAxes);
+  AcquireInputs (m_motionStopped, m_changedAxes);
+  AcquireInputs (m_motionFaulted, m_changedAxes);
+  AcquireInputs (m_faultCode, m_changedAxes);
+  AcquireInputs (m_programComplete, m_changedPrograms);
+  AcquireInputs (m_programStatus, m_changedPrograms);
+
+  m_segmentRead.Acquire ();
+}
+
+CTwinCATADS::CChangeMask const &
+CTwinCATADS::GetChangedAxes (void) const
+{
+  return m_changedAxes;
+}
+
+CTwinCATADS::CChangeMask const &
+CTwinCATADS::GetChangedPrograms (void) const
+{
+  return m_changedPrograms;
+}
+
+bool
+CTwinCATADS::UpdateOutputs (void)
+{
+  CheckSymbolVersion ();
+
+  if (UpdateSegments () &&
+      UpdateOutputs_ (VAR_BEGINMOTION, m_beginMotion, m_motionComplete) &&
+      UpdateOutputs_ (VAR_STOPMOTION, m_stopMotion, m_motionStopped) &&
+      UpdateOutputs (VAR_RUNPROGRAM, m_runProgram, m_programComplete) &&
+      FlushVariables ())
+    {
+      for (auto&& l_simAxis : m_simAxis)
+        {
+          l_simAxis->Run ();
+        }
+
+      for (auto&& l_simProg : m_simProg)
+        {
+          l_simProg->Run ();
+        }
+
+      return true;
+    }
+
+  return false;
+}
+
+bool
+CTwinCATADS::UpdateOutputs (std::vector <CTwinCATADS *> const & twinCATADS)
+{
+  bool l_result (true);
+
+  // the requests of each combined mode controller are queued, then the queues of the controllers
+  // that share a connection are written together...
+
+  std::map <ITwinCATADS *, std::vector <CTwinCATADS *>> l_connection;
+
+  for (auto&& l_twinCATADS : twinCATADS)
+    {
+      if ((l_twinCATADS->m_writeMode != EWriteMode::Combined) || l_twinCATADS->m_twinCATADS.empty ())
+        {
+          l_result = l_twinCATADS->UpdateOutputs () && l_result;
+        }
+      else
+        {
+          l_twinCATADS->CheckSymbolVersion ();
+
+          if (l_twinCATADS->UpdateSegments () &&
+              l_twinCATADS->UpdateOutputs_ (VAR_BEGINMOTION, l_twinCATADS->m_beginMotion, l_twinCATADS->m_motionComplete) &&
+              l_twinCATADS->UpdateOutputs_ (VAR_STOPMOTION, l_twinCATADS->m_stopMotion, l_twinCATADS->m_motionStopped) &&
+              l_twinCATADS->UpdateOutputs (VAR_RUNPROGRAM, l_twinCATADS->m_runProgram, l_twinCATADS->m_programComplete))
+            {
+              l_connection[l_twinCATADS->m_twinCATADS[static_cast <int> (EADSInstance::PLC)].get ()].push_back (l_twinCATADS);
+            }
+          else
+            {
+              l_result = false;
+            }
+        }
+    }
+
+  for (auto&& l_connection_ : l_connection)
+    {
+      std::vector <ITwinCATADS::CVariable> l_variables;
+
+      for (auto&& l_twinCATADS : std::get <1> (l_connection_))
+        {
+          for (auto&& l_pendingVariable : l_twinCATADS->m_pendingVariable)
+            {
+              l_variables.emplace_back (std::get <0> (l_pendingVariable), std::get <1> (l_pendingVariable).size (), &std::get <1> (l_pendingVariable)[0]);
+            }
+        }
+
+      if (l_variables.empty ())
+        {
+          continue;
+        }
+
+      try
+        {
+          std::get <0> (l_connection_)->SetVariable (l_variables);
+
+          for (auto&& l_twinCATADS : std::get <1> (l_connection_))
+            {
+              l_twinCATADS->CommitPendingVariables ();
+            }
+        }
+      catch (CString const & errorMessage)
+        {
+          // pending writes are retained and retried on the next update...
+
+          for (auto&& l_twinCATADS : std::get <1> (l_connection_))
+            {
+              l_twinCATADS->m_errorMessage = errorMessage;
+            }
+
+          l_result = false;
+        }
+    }
+
+  return l_result;
+}
+
+bool
+CTwinCATADS::SetWriteMode (EWriteMode writeMode)
+{
+  auto const l_writeMode (m_writeMode);
+
+  m_writeMode = writeMode;
+
+  if ((l_writeMode == EWriteMode::Combined) && (writeMode != EWriteMode::Combined))
+    {
+      return FlushVariables ();
+    }
+  else if ((l_writeMode == EWriteMode::Asynchronous) && (writeMode != EWriteMode::Asynchronous) && m_asyncWriter)
+    {
+      // wait for the queue to drain, giving failed writes one more chance...
+
+      FlushVariables ();
+
+      m_asyncWriter->GetFuture ().wait ();
+
+      auto const l_result (FlushVariables ());
+
+      m_asyncWriter.reset ();
+
+      return l_result;
+    }
+
+  return true;
+}
+
+CTwinCATADS::CWriteFuture
+CTwinCATADS::GetWriteFuture (void)
+{
+  if (m_asyncWriter)
+    {
+      return m_asyncWriter->GetFuture ();
+    }
+
+  std::promise <bool> l_promise;
+
+  l_promise.set_value (true);
+
+  return l_promise.get_future ().share ();
+}
+
+bool
+CTwinCATADS::Rebind (void)
+{
+  // every connection is rebound even if one fails, the first failure is reported...
+
+  bool l_result (true);
+
+  for (auto&& l_twinCATADS : m_twinCATADS)
+    {
+      if (auto const l_errorMessage (l_twinCATADS->Rebind ()); !l_errorMessage.IsEmpty () && l_result)
+        {
+          m_errorMessage = l_errorMessage;
+
+          l_result = false;
+        }
+    }
+
+  ClrWrittenValues ();
+
+  return l_result;
+}
+
+bool
+CTwinCATADS::SetNotificationRate (CString const & identifier, SNotificationRate const & notificationRate)
+{
+  if (!m_twinCATADS.empty ())
+    {
+      m_errorMessage = _T ("notification rates must be set before the TwinCAT ADS interface is created");
+    }
+  else if ((notificationRate.transMode != ADSTRANS_SERVERCYCLE) && (notificationRate.transMode != ADSTRANS_SERVERONCHA))
+    {
+      m_errorMessage = _T ("notification transmission mode must be cyclic or on change");
+    }
+  else if ((notificationRate.cycleTime == 0) || (notificationRate.cycleTime > (ULONG_MAX / TICKS_PER_MILLISECOND)))
+    {
+      // the PLC takes both times in 100 ns units...
+
+      m_errorMessage.Format (_T ("notification cycle time must be from 1 to %lu ms"), ULONG_MAX / TICKS_PER_MILLISECOND);
+    }
+  else if (notificationRate.maxDelay > (ULONG_MAX / TICKS_PER_MILLISECOND))
+    {
+      m_errorMessage.Format (_T ("notification maximum delay must be at most %lu ms"), ULONG_MAX / TICKS_PER_MILLISECOND);
+    }
+  else if (auto const l_symbol (GetNotificationSymbol (identifier)); l_symbol >= 0)
+    {
+      m_notificationRate[l_symbol] = notificationRate;
+
+      return true;
+    }
+
+  return false;
+}
+
+bool
+CTwinCATADS::GetLatencyHistogram (CString const & identifier, CLatencyHistogram & latencyHistogram) const
+{
+  if (auto const l_symbol (GetNotificationSymbol (identifier)); l_symbol >= 0)
+    {
+      for (int l_bucket (0); l_bucket < NUM_LATENCY_BUCKETS; ++l_bucket)
+        {
+          latencyHistogram[l_bucket] = m_latencyHistogram[l_symbol][l_bucket].load (std::memory_order_relaxed);
+        }
+
+      return true;
+    }
+
+  return false;
+}
+
+void
+CTwinCATADS::ClrLatencyHistograms (void)
+{
+  for (auto&& l_latencyHistogram : m_latencyHistogram)
+    {
+      for (auto&& l_count : l_latencyHistogram)
+        {
+          l_count.store (0, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool
+CTwinCATADS::GetSampleTime (CString const & identifier, std::chrono::steady_clock::time_point & sampleTime) const
+{
+  if (auto const l_symbol (GetNotificationSymbol (identifier)); l_symbol >= 0)
+    {
+      // in the aggregated status mode the status variables share the time stamp of their structure...
+
+      auto const l_isStatus ((m_statusMode == EStatusMode::Aggregated) && (std::get <2> (m_symbolIdentifier[l_symbol]).transMode != ADSTRANS_NOTRANS) && (std::get <0> (m_symbolIdentifier[l_symbol]) == EADSInstance::PLC) && (l_symbol != VAR_SEGMENTREAD));
+
+      if (auto const l_timeStamp (GetTimeStamp (l_isStatus ? VAR_CONTROLLERSTATUS : static_cast <ESymbol> (l_symbol))); l_timeStamp != 0)
+        {
+          sampleTime = GetSteadyTime (l_timeStamp);
+
+          return true;
+        }
+
+      m_errorMessage.Format (_T ("no sample of %s has been taken yet"), (LPCTSTR) identifier);
+    }
+
+  return false;
+}
+
+int
+CTwinCATADS::GetNotificationSymbol (CString const & identifier) const
+{
+  for (int l_symbol (0); l_symbol < NUM_SYMBOLS; ++l_symbol)
+    {
+      if ((std::get <1> (m_symbolIdentifier[l_symbol]) == identifier) && (std::get <2> (m_symbolIdentifier[l_symbol]).transMode != ADSTRANS_NOTRANS))
+        {
+          return l_symbol;
+        }
+    }
+
+  m_errorMessage.Format (_T ("%s is not a notification variable"), (LPCTSTR) identifier);
+
+  return -1;
+}
+
+LONGLONG
+CTwinCATADS::GetTimeStamp (ESymbol symbol) const
+{
+  switch (symbol)
+    {
+      case VAR_ACTUALPOSITION:   return m_actualPosition.timeStamp ();
+      case VAR_ACTUALVELOCITY:   return m_actualVelocity.timeStamp ();
+      case VAR_MOTIONCOMPLETE:   return m_motionComplete.timeStamp ();
+      case VAR_MOTIONSTOPPED:    return m_motionStopped.timeStamp ();
+      case VAR_MOTIONFAULTED:    return m_motionFaulted.timeStamp ();
+      case VAR_FAULTCODE:        return m_faultCode.timeStamp ();
+      case VAR_PROGRAMCOMPLETE:  return m_programComplete.timeStamp ();
+      case VAR_PROGRAMSTATUS:    return m_programStatus.timeStamp ();
+      case VAR_CONTROLLERSTATUS: return m_controllerStatus.timeStamp ();
+      case VAR_SEGMENTREAD:      return m_segmentRead.timeStamp ();
+      case VAR_ANALOGINPUTS:     return m_analogInputs.timeStamp ();
+      case VAR_DISCRETEINPUTS:   return m_discreteInputs.timeStamp ();
+      default:                   return 0;
+    }
+}
+
+bool
+CTwinCATADS::Subscribe (CAxisEventHandler const & axisEventHandler)
+{
+  if (!m_twinCATADS.empty ())
+    {
+      m_errorMessage = _T ("event handlers must be subscribed before the TwinCAT ADS interface is created");
+
+      return false;
+    }
+
+  m_axisEventHandler.push_back (axisEventHandler);
+
+  return true;
+}
+
+bool
+CTwinCATADS::Subscribe (CProgramEventHandler const & programEventHandler)
+{
+  if (!m_twinCATADS.empty ())
+    {
+      m_errorMessage = _T ("event handlers must be subscribed before the TwinCAT ADS interface is created");
+
+      return false;
+    }
+
+  m_programEventHandler.push_back (programEventHandler);
+
+  return true;
+}
+
+void
+CTwinCATADS::SetPositionThreshold (int axis, double position)
+{
+  m_positionThreshold[axis] = position;
+}
+
+void
+CTwinCATADS::ClrPositionThreshold (int axis)
+{
+  m_positionThreshold[axis] = std::numeric_limits <double>::quiet_NaN ();
+}
+
+bool
+CTwinCATADS::SetStatusMode (EStatusMode statusMode)
+{
+  if (!m_twinCATADS.empty ())
+    {
+      m_errorMessage = _T ("the status mode must be set before the TwinCAT ADS interface is created");
+
+      return false;
+    }
+
+  m_statusMode = statusMode;
+
+  return true;
+}
+
+bool
+CTwinCATADS::SetSegmentQueue (bool isEnabled)
+{
+  if (!m_twinCATADS.empty ())
+    {
+      m_errorMessage = _T ("the segment queue must be set before the TwinCAT ADS interface is created");
+
+      return false;
+    }
+
+  auto const l_numAxes (isEnabled ? m_position.size () : 0);
+
+  m_segmentBuffer.assign (l_numAxes * SEGMENT_QUEUE_DEPTH * SEGMENT_FIELDS, 0.0);
+  m_segmentWritten.assign (l_numAxes, 0);
+  m_segmentQueue.assign (l_numAxes, std::deque <SMotionSegment> ());
+
+  AllocInputs (m_segmentRead, l_numAxes);
+
+  m_isSegmentQueue = isEnabled;
+
+  return true;
+}
+
+bool
+CTwinCATADS::QueueSegments (int axis, std::vector <SMotionSegment> const & segments)
+{
+  if (!m_isSegmentQueue)
+    {
+      m_errorMessage = _T ("the segment queue is not enabled");
+
+      return false;
+    }
+  else if ((axis < 0) || (static_cast <size_t> (axis) >= m_segmentQueue.size ()))
+    {
+      m_errorMessage.Format (_T ("axis %ld is out of range"), axis);
+
+      return false;
+    }
+
+  m_segmentQueue[axis].insert (m_segmentQueue[axis].end (), segments.begin (), segments.end ());
+
+  // the first segments go out now rather than on the next update...
+
+  return UpdateSegments ();
+}
+
+size_t
+CTwinCATADS::GetQueuedSegments (int axis) const
+{
+  if (!m_isSegmentQueue || (axis < 0) || (static_cast <size_t> (axis) >= m_segmentQueue.size ()))
+    {
+      return 0;
+    }
+
+  return m_segmentQueue[axis].size () + (m_segmentWritten[axis] - m_segmentRead[0][axis]);
+}
+
+bool
+CTwinCATADS::UpdateSegments (void)
+{
+  std::vector <std::pair <size_t, size_t>> l_slots; // first element and number of elements of the new slots
+
+  for (size_t l_axis (0); l_axis < m_segmentQueue.size (); ++l_axis)
+    {
+      auto & l_segmentQueue (m_segmentQueue[l_axis]);
+
+      // the counters wrap, their difference is the number of segments the PLC still holds...
+
+      while (!l_segmentQueue.empty () && ((m_segmentWritten[l_axis] - m_segmentRead[0][l_axis]) < static_cast <MC_UDInt> (SEGMENT_QUEUE_DEPTH)))
+        {
+          auto const & l_segment (l_segmentQueue.front ());
+
+          auto const l_index (((l_axis * SEGMENT_QUEUE_DEPTH) + (m_segmentWritten[l_axis] % SEGMENT_QUEUE_DEPTH)) * SEGMENT_FIELDS);
+          auto const l_pSlot (&m_segmentBuffer[l_index]);
+
+          l_pSlot[0] = l_segment.position;
+          l_pSlot[1] = l_segment.velocity;
+          l_pSlot[2] = l_segment.acceleration;
+          l_pSlot[3] = l_segment.deceleration;
+
+          ++m_segmentWritten[l_axis];
+
+          l_segmentQueue.pop_front ();
+
+          if (!l_slots.empty () && ((std::get <0> (l_slots.back ()) + std::get <1> (l_slots.back ())) == l_index))
+            {
+              std::get <1> (l_slots.back ()) += SEGMENT_FIELDS;
+            }
+          else
+            {
+              l_slots.emplace_back (l_index, SEGMENT_FIELDS);
+            }
+        }
+    }
+
+  if (l_slots.empty ())
+    {
+      return true;
+    }
+
+  // only the new slots are written when they can be written by address, the PLC must see the segments
+  // before the count that hands them over...
+
+  auto & l_writtenValue (m_writtenValue[VAR_SEGMENTBUFFER]);
+  bool   l_isWritten (true);
+
+  for (auto l_slot (l_slots.begin ()); l_isWritten && (l_slot != l_slots.end ()); ++l_slot)
+    {
+      auto const l_offset (std::get <0> (*l_slot) * sizeof (MC_LReal));
+      auto const l_cbLength (std::get <1> (*l_slot) * sizeof (MC_LReal));
+      auto const l_pSlot (reinterpret_cast <MC_Byte const *> (&m_segmentBuffer[std::get <0> (*l_slot)]));
+
+      if (!SetElement_ (VAR_SEGMENTBUFFER, l_offset, l_cbLength, l_pSlot, l_isWritten))
+        {
+          return false;
+        }
+      else if (l_isWritten && (l_writtenValue.size () == (m_segmentBuffer.size () * sizeof (MC_LReal))))
+        {
+          std::copy (l_pSlot, l_pSlot + l_cbLength, l_writtenValue.begin () + l_offset);
+        }
+    }
+
+  if (l_isWritten)
+    {
+      return SetVariable_ (VAR_SEGMENTWRITTEN, m_segmentWritten);
+    }
+
+  return WriteCombined ([this] { return SetVariable_ (VAR_SEGMENTBUFFER, m_segmentBuffer) && SetVariable_ (VAR_SEGMENTWRITTEN, m_segmentWritten); });
+}
+
+bool
+CTwinCATADS::SetAcceleration (int axis, double acceleration)
+{
+  return SetVariable_ (VAR_ACCELERATION, m_acceleration, axis, acceleration);
+}
+
+bool
+CTwinCATADS::SetDeceleration (int axis, double deceleration)
+{
+  return SetVariable_ (VAR_DECELERATION, m_deceleration, axis, deceleration);
+}
+
+bool
+CTwinCATADS::SetDirection (int axis, MC_Direction direction)
+{
+  return SetVariable_ (VAR_DIRECTION, m_direction, axis, direction);
+}
+
+bool
+CTwinCATADS::SetJerk (int axis, double jerk)
+{
+  return SetVariable_ (VAR_JERK, m_jerk, axis, jerk);
+}
+
+bool
+CTwinCATADS::SetPosition (int axis, double position)
+{
+  return SetVariable_ (VAR_POSITION, m_position, axis, position);
+}
+
+bool
+CTwinCATADS::SetVelocity (int axis, double velocity)
+{
+  return SetVariable_ (VAR_VELOCITY, m_velocity, axis, velocity);
+}
+
+bool CTwinCATADS::SetJogMode (int axis, double slewSpeed)
+{
+  return SetDirection (axis, (slewSpeed < 0.0) ? MC_Negative : MC_Positive) && SetVelocity (axis, std::abs (slewSpeed));
+}
+
+void CTwinCATADS::BeginMotion (int axis)
+{
+  m_beginMotion[0][axis] = MC_True;
+}
+
+bool
+CTwinCATADS::BeginMotion (std::vector <SAxisMove> const & axisMoves)
+{
+  for (auto&& l_axisMove : axisMoves)
+    {
+      if ((l_axisMove.axis < 0) || (static_cast <size_t> (l_axisMove.axis) >= m_position.size ()))
+        {
+          m_errorMessage.Format (_T ("axis %ld is out of range"), l_axisMove.axis);
+
+          return false;
+        }
+    }
+
+  for (auto&& l_axisMove : axisMoves)
+    {
+      m_position[l_axisMove.axis]     = l_axisMove.position;
+      m_velocity[l_axisMove.axis]     = l_axisMove.velocity;
+      m_acceleration[l_axisMove.axis] = l_axisMove.acceleration;
+      m_deceleration[l_axisMove.axis] = l_axisMove.deceleration;
+
+      // a move is to the position, an axis left in jog mode by SetJogMode or SetDirection is taken out of it...
+
+      m_direction[l_axisMove.axis] = MC_None;
+
+      m_beginMotion[0][l_axisMove.axis] = MC_True;
+    }
+
+  if (m_writeMode == EWriteMode::Asynchronous)
+    {
+      return SetVariable_ (VAR_ACCELERATION, m_acceleration) &&
+             SetVariable_ (VAR_DECELERATION, m_deceleration) &&
+             SetVariable_ (VAR_DIRECTION, m_direction) &&
+             SetVariable_ (VAR_POSITION, m_position) &&
+             SetVariable_ (VAR_VELOCITY, m_velocity);
+    }
+
+  // the handshake is queued behind the setpoints...
+
+  return WriteCombined ([this]
+                        {
+                          return SetVariable_ (VAR_ACCELERATION, m_acceleration) &&
+                                 SetVariable_ (VAR_DECELERATION, m_deceleration) &&
+                                 SetVariable_ (VAR_DIRECTION, m_direction) &&
+                                 SetVariable_ (VAR_POSITION, m_position) &&
+                                 SetVariable_ (VAR_VELOCITY, m_velocity) &&
+                                 UpdateOutputs_ (VAR_BEGINMOTION, m_beginMotion, m_motionComplete);
+                        });
+}
+
+template <typename F> bool
+CTwinCATADS::WriteCombined (F && write)
 {
-  { 0x4221, _T ("requested set velocity is not allowed") },
-  { 0x422F, _T ("acceleration less than or equal to 0.0 is not allowed") },
-  { 0x4230, _T ("absolute deceleration value less than or equal to 0.0 is not allowed") },
-  { 0x4231, _T ("set velocity less than or equal to 0.0 is not allowed") },
-  { 0x4260, _T ("controller not enabled") },
-  { 0x4263, _T ("motion command issued when current command was not completed") },
-  { 0x4357, _T ("limit switch triggered (negative direction)") },
-  { 0x4358, _T ("limit switch triggered (positive direction)") },
-  { 0x4359, _T ("set velocity not allowed") },
-  { 0x4650, _T ("drive not ready for operation/drive hardware failed") },
-  { 0x4B00, _T ("user abort fault") },
-  { 0x4B09, _T ("TwinCAT axis is not ready or enabled") },
-  { 0x4C00, _T ("TwinCAT issued MC_Stop, limit switch possibilly triggered") }
-};
+  // the writes are queued as in the combined write mode, in the immediate write mode the queue is
+  // then written with one sum request; the asynchronous writer already combines what it is given...
 
-class CTwinCATADS::CSimAxis final
+  if (m_writeMode == EWriteMode::Asynchronous)
+    {
+      return write ();
+    }
+
+  auto const l_writeMode (m_writeMode);
+
+  m_writeMode = EWriteMode::Combined;
+
+  auto const l_result (write ());
+
+  m_writeMode = l_writeMode;
+
+  return l_result && ((l_writeMode != EWriteMode::Immediate) || FlushVariables ());
+}
+
+void
+CTwinCATADS::StopMotion (int axis)
 {
-public:
-  explicit CSimAxis (CTwinCATADS & twinCATADS, int axis);
-  virtual ~CSimAxis () = default;
+  m_stopMotion[0][axis]  = MC_True;
+  m_beginMotion[0][axis] = MC_False;
 
-  void Run (void);
+  if (m_isSegmentQueue)
+    {
+      m_segmentQueue[axis].clear ();
+    }
+}
 
-private:
-  CTwinCATADS & m_twinCATADS;
-  int const m_axis;
-  bool m_beginMotion;
-  double m_p;
-  double m_v;
-  double m_t0;
-  double m_t1;
-  double m_t2;
-  double m_t3;
+bool
+CTwinCATADS::IsMotionComplete (int axis) const
+{
+  return (m_stopMotion[0][axis] ||
+          m_beginMotion[0][axis] ||
+          m_motionStopped[0][axis] ||
+          m_motionComplete[0][axis]) ? false : true;
+}
 
-  inline static double Distance (double a, double t) { return a * t * t / 2.0; }
+bool
+CTwinCATADS::IsMotionFaulted (int axis) const
+{
+  return (m_motionFaulted[0][axis] == MC_True) && (m_faultCode[0][axis] != AXIS_STOPPED_FAULT);
+}
 
-  static double const MS_PER_SECOND;
+DWORD
+CTwinCATADS::GetFaultCode (int axis) const
+{
+  return m_faultCode[0][axis];
+}
 
-public:
-  // copy construction and assignment not allowed for this class
+double
+CTwinCATADS::GetPosition (int axis) const
+{
+  return m_actualPosition[0][axis];
+}
 
-  CSimAxis (const CSimAxis &) = delete;
-  CSimAxis & operator = (const CSimAxis &) = delete;
-};
+double
+CTwinCATADS::GetVelocity (int axis) const
+{
+  return m_actualVelocity[0][axis];
+}
 
-double const CTwinCATADS::CSimAxis::MS_PER_SECOND (1000.0);
+void
+CTwinCATADS::GetPositions (double * positions, int numAxes) const
+{
+  auto const l_count (std::min (static_cast <size_t> (std::max (numAxes, 0)), m_actualPosition[0].size ()));
 
-CTwinCATADS::CSimAxis::CSimAxis (CTwinCATADS & twinCATADS, int axis)
-  : m_twinCATADS (twinCATADS)
-  , m_axis (axis)
-  , m_beginMotion (false)
-  , m_p (0.0)
-  , m_v (0.0)
-  , m_t0 (0.0)
-  , m_t1 (0.0)
-  , m_t2 (0.0)
-  , m_t3 (0.0)
+  if (l_count > 0)
+    {
+      ::memcpy_s (positions, l_count * sizeof (positions[0]), &m_actualPosition[0][0], l_count * sizeof (MC_LReal));
+    }
+}
+
+void
+CTwinCATADS::GetVelocities (double * velocities, int numAxes) const
+{
+  auto const l_count (std::min (static_cast <size_t> (std::max (numAxes, 0)), m_actualVelocity[0].size ()));
+
+  if (l_count > 0)
+    {
+      ::memcpy_s (velocities, l_count * sizeof (velocities[0]), &m_actualVelocity[0][0], l_count * sizeof (MC_LReal));
+    }
+}
+
+bool
+CTwinCATADS::SetVariable (const CString & identifier, int value)
+{
+  return SetVariable_ (identifier, value);
+}
+
+bool
+CTwinCATADS::SetVariable (const CString & identifier, BYTE value)
+{
+  return SetVariable_ (identifier, value);
+}
+
+bool
+CTwinCATADS::SetVariable (const CString & identifier, double value)
+{
+  return SetVariable_ (identifier, value);
+}
+
+bool
+CTwinCATADS::SetVariable (const CString & identifier, const std::vector <int> & value)
+{
+  return SetVariable_ (identifier, value);
+}
+
+bool
+CTwinCATADS::SetVariable (const CString & identifier, const std::vector <BYTE> & value)
+{
+  return SetVariable_ (identifier, value);
+}
+
+bool
+CTwinCATADS::SetVariable (const CString & identifier, const std::vector <double> & value)
+{
+  return SetVariable_ (identifier, value);
+}
+
+bool
+CTwinCATADS::RunProgram (int identifier, bool stopEnabled)
+{
+  if (!stopEnabled || SetVariable_ (VAR_STOPPROGRAM, m_stopProgram, identifier, MC_False))
+    {
+      m_runProgram[0][identifier] = MC_True;
+
+      return true;
+    }
+
+  return false;
+}
+
+bool
+CTwinCATADS::StopProgram (int identifier)
+{
+  return SetVariable_ (VAR_STOPPROGRAM, m_stopProgram, identifier, MC_True);
+}
+
+bool
+CTwinCATADS::IsProgramComplete (int identifier) const
+{
+  return (m_runProgram[0][identifier] || m_programComplete[0][identifier]) ? false : true;
+}
+
+template <typename F> bool
+CTwinCATADS::Wait (F && isComplete, DWORD timeout, CString const & description)
+{
+  auto const l_start (PDCLib::GetTickCount ());
+
+  for (;;)
+    {
+      auto const l_notificationCount (m_notificationCount.load ());
+
+      UpdateInputs ();
+
+      if (!UpdateOutputs ())
+        {
+          return false;
+        }
+      else if (isComplete ())
+        {
+          return true;
+        }
+
+      auto const l_elapsed (PDCLib::GetTickCount () - l_start);
+
+      if ((timeout != INFINITE) && (l_elapsed >= timeout))
+        {
+          m_errorMessage.Format (_T ("timed out after %lu ms waiting for %s"), timeout, (LPCTSTR) description);
+
+          return false;
+        }
+
+      // sleep until the next notification, polling at a low rate in case one is coalesced or the
+      // simulation is running...
+
+      auto const l_interval ((timeout == INFINITE) ? WAIT_POLL_INTERVAL : std::min <ULONGLONG> (timeout - l_elapsed, WAIT_POLL_INTERVAL));
+
+      ++m_waiterCount;
+
+      {
+        std::unique_lock <std::mutex> l_waitGate { m_waitGate };
+
+        m_waitCondition.wait_for (l_waitGate, std::chrono::milliseconds (l_interval), [this, l_notificationCount] { return m_notificationCount.load () != l_notificationCount; });
+      }
+
+      --m_waiterCount;
+    }
+}
+
+bool
+CTwinCATADS::WaitForMotionComplete (int axis, DWORD timeout)
+{
+  return Wait ([this, axis] { return IsMotionComplete (axis); }, timeout, PDCLib::StringWithFormat (_T ("axis %ld motion complete"), axis));
+}
+
+bool
+CTwinCATADS::WaitForProgramComplete (int identifier, DWORD timeout)
+{
+  return Wait ([this, identifier] { return IsProgramComplete (identifier); }, timeout, PDCLib::StringWithFormat (_T ("program %ld complete"), identifier));
+}
+
+bool
+CTwinCATADS::WaitForAny (std::vector <int> const & axes, std::vector <int> const & programs, DWORD timeout)
+{
+  return Wait ([this, &axes, &programs]
+               {
+                 return std::any_of (axes.begin (), axes.end (), [this] (int axis) { return IsMotionComplete (axis); }) ||
+                        std::any_of (programs.begin (), programs.end (), [this] (int identifier) { return IsProgramComplete (identifier); });
+               },
+               timeout,
+               _T ("any axis or program complete"));
+}
+
+bool
+CTwinCATADS::WaitForAll (std::vector <int> const & axes, std::vector <int> const & programs, DWORD timeout)
+{
+  return Wait ([this, &axes, &programs]
+               {
+                 return std::all_of (axes.begin (), axes.end (), [this] (int axis) { return IsMotionComplete (axis); }) &&
+                        std::all_of (programs.begin (), programs.end (), [this] (int identifier) { return IsProgramComplete (identifier); });
+               },
+               timeout,
+               _T ("all axes and programs complete"));
+}
+
+DWORD
+CTwinCATADS::GetProgramStatus (int identifier) const
+{
+  return m_programStatus[0][identifier];
+}
+
+CString
+CTwinCATADS::GetErrorMessage (void) const
+{
+  return m_errorMessage;
+}
+
+CString
+CTwinCATADS::GetErrorMessage (DWORD programStatus)
+{
+  if (programStatus < m_programStatusMessage.size ())
+    {
+      return m_programStatusMessage[programStatus];
+    }
+  else
+    {
+      return PDCLib::StringWithFormat (_T ("unrecognized TwinCAT ADS program status: 0x%08X"), programStatus);
+    }
+}
+
+CString
+CTwinCATADS::GetADSErrorMessage (DWORD faultCode)
+{
+  if (auto const l_adsErrorMessage (m_adsErrorMessage.find (faultCode)); l_adsErrorMessage == m_adsErrorMessage.end ())
+    {
+      return PDCLib::StringWithFormat (_T ("unrecognized TwinCAT ADS fault code: 0x%08X"), faultCode);
+    }
+  else
+    {
+      return PDCLib::StringWithFormat (_T ("%s: 0x%08X"), (LPCTSTR) std::get <1> (*l_adsErrorMessage), std::get <0> (*l_adsErrorMessage));
+    }
+}
+
+HMODULE
+CTwinCATADS::GetModuleHandle (void)
+{
+  return ITwinCATADS::GetModuleHandle ();
+}
+
+void
+CTwinCATADS::UpdateInputs (SAnalogInputs * analogInputs, SDiscreteInputs * discreteInputs)
 {
-  Run ();
+  UpdateInputs (m_analogInputs, analogInputs);
+  UpdateInputs (m_discreteInputs, discreteInputs);
 }
 
 void
-CTwinCATADS::CSimAxis::Run (void)
+CTwinCATADS::UpdateOutputs (SAnalogOutputs const * analogOutputs, SDiscreteOutputs const * discreteOutputs)
 {
-  if (m_twinCATADS.m_beginMotion[0][m_axis] || m_twinCATADS.m_stopMotion[0][m_axis])
+  SetVariable_ (VAR_ANALOGOUTPUTS, m_analogOutputs, analogOutputs);
+  SetVariable_ (VAR_DISCRETEOUTPUTS, m_discreteOutputs, discreteOutputs);
+}
+
+bool
+CTwinCATADS::Create_ (WORD analogPortNumber, WORD discretePortNumber)
+{
+  if (m_simAxis.empty () && m_simProg.empty ())
     {
-      double const l_acceleration (m_twinCATADS.m_acceleration[m_axis]);
-      double const l_deceleration (m_twinCATADS.m_deceleration[m_axis]);
-      double const l_position (m_twinCATADS.m_position[m_axis]);
-      double const l_velocity (m_twinCATADS.m_velocity[m_axis]);
-      double const l_actualPosition (m_twinCATADS.m_actualPosition[1][m_axis]);
-      DWORD  const l_direction (m_twinCATADS.m_direction[m_axis]);
+      ReportProgress (ECreateStage::Connecting);
 
-      if (m_beginMotion)
+      if (m_virtualPLC)
         {
-          double const l_t (static_cast <double> (PDCLib::GetTickCount ()) / MS_PER_SECOND);
+          return Create_ <CTwinCATADSSim> (analogPortNumber, discretePortNumber, *m_virtualPLC);
+        }
+      else if (!m_hostName.IsEmpty ())
+        {
+          return Create_ <CTwinCATADSTCP> (analogPortNumber, discretePortNumber, m_hostName, m_amsNetId);
+        }
+      else if (Create <CTwinCATADS3> (AMSPORT_R0_PLC_TC3))
+        {
+          ReportProgress (ECreateStage::ResolvingSymbols);
 
-          double l_p (0.0);
-          double l_v (0.0);
+          AddSymbols (EADSInstance::PLC);
 
-          if (l_t < m_t3)
-            {
-              l_p += Distance (l_acceleration, std::min (l_t, m_t1) - m_t0);
+          ReportProgress (ECreateStage::RegisteringNotifications);
 
-              if (l_t < m_t1)
+          if (RegisterStatusNotification (true))
+            {
+              if ((analogPortNumber == 0) && (discretePortNumber == 0))
                 {
-                  // acceleration phase of trajectory...
+                  ReportProgress (ECreateStage::WritingOutputs);
 
-                  l_v = l_acceleration * (l_t - m_t0);
+                  return UpdateOutputs ();
+                }
 
-                  if (m_twinCATADS.m_stopMotion[0][m_axis])
-                    {
-                      m_t1 = l_t;
+              ReportProgress (ECreateStage::ConnectingIO);
 
-                      m_t2 = l_t;
+              if (CreateIO <CTwinCATADS3> (analogPortNumber, discretePortNumber))
+                {
+                  AddSymbols (EADSInstance::AIO);
+                  AddSymbols (EADSInstance::DIO);
 
-                      m_t3 = l_t + l_v / l_deceleration;
-                    }
+                  return RegisterNotification (EADSInstance::AIO, { Notification (VAR_ANALOGINPUTS, m_analogInputs, OnAnalogInputsTC3) }) &&
+                         RegisterNotification (EADSInstance::DIO, { Notification (VAR_DISCRETEINPUTS, m_discreteInputs, OnDiscreteInputsTC3) }) &&
+                         UpdateOutputs ();
                 }
-              else
-                {
-                  l_p += m_v * (std::min (l_t, m_t2) - m_t1);
+            }
+        }
+      else if (Create <CTwinCATADS2> (AMSPORT_R0_PLC_RTS1))
+        {
+          ReportProgress (ECreateStage::ResolvingSymbols);
 
-                  if (l_t < m_t2)
-                    {
-                      // target velocity phase of trajectory...
+          AddSymbols (EADSInstance::PLC);
 
-                      l_v  = m_v;
+          ReportProgress (ECreateStage::RegisteringNotifications);
 
-                      if (m_twinCATADS.m_stopMotion[0][m_axis])
-                        {
-                          m_t2 = l_t;
+          if (RegisterStatusNotification (false))
+            {
+              if ((analogPortNumber == 0) && (discretePortNumber == 0))
+                {
+                  ReportProgress (ECreateStage::WritingOutputs);
 
-                          m_t3 = l_t + l_v / l_deceleration;
-                        }
-                    }
-                  else
-                    {
-                      // deceleration phase of trajectory...
+                  return UpdateOutputs ();
+                }
 
-                      l_p += Distance (l_deceleration, m_t3 - m_t2);
+              ReportProgress (ECreateStage::ConnectingIO);
 
-                      l_p -= Distance (l_deceleration, m_t3 - l_t);
+              if (CreateIO <CTwinCATADS2> (analogPortNumber, discretePortNumber))
+                {
+                  AddSymbols (EADSInstance::AIO);
+                  AddSymbols (EADSInstance::DIO);
 
-                      l_v  = l_deceleration * (m_t3 - l_t);
-                    }
+                  return RegisterNotification (EADSInstance::AIO, { Notification (VAR_ANALOGINPUTS, m_analogInputs, OnAnalogInputsTC2) }) &&
+                         RegisterNotification (EADSInstance::DIO, { Notification (VAR_DISCRETEINPUTS, m_discreteInputs, OnDiscreteInputsTC2) }) &&
+                         UpdateOutputs ();
                 }
             }
-          else
-            {
-              l_p += Distance (l_acceleration, m_t1 - m_t0);
-
-              l_p += m_v * (m_t2 - m_t1);
+        }
 
-              l_p += Distance (l_deceleration, m_t3 - m_t2);
+      return false;
+    }
 
-              if (m_twinCATADS.m_stopMotion[0][m_axis])
-                {
-                  m_twinCATADS.m_motionStopped[1][m_axis] = CTwinCATADS::MC_True;
+  return UpdateOutputs ();
+}
 
-                  m_twinCATADS.m_faultCode[1][m_axis] = CTwinCATADS::AXIS_STOPPED_FAULT;
+template <typename T, typename... Args> bool
+CTwinCATADS::Create_ (WORD analogPortNumber, WORD discretePortNumber, Args const & ... args)
+{
+  // backend without a router DLL, the notifications are dispatched by the backend with the TwinCAT 3 calling convention...
 
-                  PDCLib::Trace (_T ("stopped simulation axis (%ld)"), m_axis);
-                }
-              else
-                {
-                  m_twinCATADS.m_faultCode[1][m_axis] = CTwinCATADS::AXIS_NO_FAULT;
+  if (Create <T> (AMSPORT_R0_PLC_TC3, args...))
+    {
+      ReportProgress (ECreateStage::ResolvingSymbols);
 
-                  PDCLib::Trace (_T ("completed simulation axis (%ld)"), m_axis);
-                }
+      AddSymbols (EADSInstance::PLC);
 
-              m_twinCATADS.m_motionComplete[1][m_axis] = MC_True;
-            }
+      ReportProgress (ECreateStage::RegisteringNotifications);
 
-          if (l_direction)
-            {
-              m_twinCATADS.m_actualPosition[1][m_axis] = (l_direction == CTwinCATADS::MC_Positive) ? (m_p + l_p) : (m_p - l_p);
-            }
-          else
+      if (RegisterStatusNotification (true))
+        {
+          if ((analogPortNumber == 0) && (discretePortNumber == 0))
             {
-              m_twinCATADS.m_actualPosition[1][m_axis] = (l_position > m_p) ? (m_p + l_p) : (m_p - l_p);
+              ReportProgress (ECreateStage::WritingOutputs);
+
+              return UpdateOutputs ();
             }
 
-          m_twinCATADS.m_actualVelocity[1][m_axis] = l_v;
+          ReportProgress (ECreateStage::ConnectingIO);
 
-          PDCLib::Trace (_T ("simulation (%ld) axis actual position: %.3f"), m_axis, m_twinCATADS.m_actualPosition[1][m_axis]);
-          PDCLib::Trace (_T ("simulation (%ld) axis actual velocity: %.3f"), m_axis, m_twinCATADS.m_actualVelocity[1][m_axis]);
-        }
-      else if ((l_acceleration > 0.0) && (l_deceleration > 0.0) && (l_velocity > 0.0))
-        {
-          if (l_direction)
+          if (CreateIO <T> (analogPortNumber, discretePortNumber, args...))
             {
-              m_v = l_velocity;
+              AddSymbols (EADSInstance::AIO);
+              AddSymbols (EADSInstance::DIO);
 
-              m_t0 = static_cast <double> (PDCLib::GetTickCount ()) / MS_PER_SECOND;
+              return RegisterNotification (EADSInstance::AIO, { Notification (VAR_ANALOGINPUTS, m_analogInputs, OnAnalogInputsTC3) }) &&
+                     RegisterNotification (EADSInstance::DIO, { Notification (VAR_DISCRETEINPUTS, m_discreteInputs, OnDiscreteInputsTC3) }) &&
+                     UpdateOutputs ();
+            }
+        }
+    }
 
-              m_t1 = m_t0 + (m_v / l_acceleration);
+  return false;
+}
 
-              m_t2 = std::numeric_limits <double>::infinity ();
+template <typename T, typename... Args> bool
+CTwinCATADS::Create (WORD portNumber, Args const & ... args)
+{
+  try
+    {
+      m_twinCATADS.emplace_back (ITwinCATADS::Connect <T> (portNumber, args...));
 
-              m_t3 = m_t2;
+      return true;
+    }
+  catch (CString const & errorMessage)
+    {
+      PDCLib::Trace (_T ("%s"), (LPCTSTR) errorMessage);
 
-              m_p = l_actualPosition;
+      m_errorMessage = errorMessage;
+    }
 
-              m_beginMotion = true;
+  return false;
+}
 
-              PDCLib::Trace (_T ("started simulation axis (%ld)"), m_axis);
-              PDCLib::Trace (_T ("target velocity    : %.3f"), m_v);
-              PDCLib::Trace (_T ("acceleration begin : %.3f"), m_t0);
-              PDCLib::Trace (_T ("acceleration end   : %.3f"), m_t1);
-            }
-          else
-            {
-              double const l_c (((1.0 / l_acceleration) + (1.0 / l_deceleration)) / 2.0);
+template <typename T, typename... Args> bool
+CTwinCATADS::CreateIO (WORD analogPortNumber, WORD discretePortNumber, Args const & ... args)
+{
+  // the I/O ports are independent of each other, the discrete port is opened while the analog port is...
 
-              double const l_d (std::abs (l_position - l_actualPosition));
+  auto l_discrete (std::async (std::launch::async, [discretePortNumber, &args...] { return ITwinCATADS::Connect <T> (discretePortNumber, args...); }));
 
-              m_v = std::min (std::sqrt (l_d / l_c), l_velocity);
+  try
+    {
+      auto l_analog (ITwinCATADS::Connect <T> (analogPortNumber, args...));
 
-              m_t0 = static_cast <double> (PDCLib::GetTickCount ()) / MS_PER_SECOND;
+      m_twinCATADS.emplace_back (l_analog);
+      m_twinCATADS.emplace_back (l_discrete.get ());
 
-              m_t1 = m_t0 + (m_v / l_acceleration);
+      return true;
+    }
+  catch (CString const & errorMessage)
+    {
+      PDCLib::Trace (_T ("%s"), (LPCTSTR) errorMessage);
 
-              m_t2 = m_t1 + ((m_v > 0.0) ? ((l_d - m_v * m_v * l_c) / m_v) : 0.0);
+      m_errorMessage = errorMessage;
+    }
 
-              m_t3 = m_t2 + (m_v / l_deceleration);
+  return false;
+}
 
-              m_p = l_actualPosition;
+bool
+CTwinCATADS::UpdateOutputs (ESymbol    symbol,
+                            CRequest & reqVariable)
+{
+  // check for pending requests...
 
-              m_beginMotion = true;
+  if (reqVariable[0] == reqVariable[1])
+    {
+      // no pending requests...
 
-              PDCLib::Trace (_T ("started simulation axis (%ld)"), m_axis);
-              PDCLib::Trace (_T ("actual position    : %.3f"), l_actualPosition);
-              PDCLib::Trace (_T ("target position    : %.3f"), l_position);
-              PDCLib::Trace (_T ("target velocity    : %.3f"), m_v);
-              PDCLib::Trace (_T ("acceleration begin : %.3f"), m_t0);
-              PDCLib::Trace (_T ("acceleration end   : %.3f"), m_t1);
-              PDCLib::Trace (_T ("deceleration begin : %.3f"), m_t2);
-              PDCLib::Trace (_T ("deceleration end   : %.3f"), m_t3);
-            }
-        }
-      else
-        {
-          m_twinCATADS.m_motionComplete[1][m_axis] = CTwinCATADS::MC_True;
-        }
+      return true;
     }
-  else
+  else if (SetVariable_ (symbol, reqVariable[0]))
     {
-      m_twinCATADS.m_motionStopped[1][m_axis]  = CTwinCATADS::MC_False;
-      m_twinCATADS.m_motionComplete[1][m_axis] = CTwinCATADS::MC_False;
+      // clear pending requests...
 
-      m_beginMotion = false;
+      reqVariable[1] = reqVariable[0];
+
+      return true;
     }
+
+  return false;
 }
 
-class CTwinCATADS::CSimProg final
+bool
+CTwinCATADS::UpdateOutputs (ESymbol                         symbol,
+                            CRequest                      & reqVariable,
+                            CTripleBuffer <MC_Bool> const & ackVariable)
 {
-public:
-  explicit CSimProg (CTwinCATADS & twinCATADS, int prog);
-  virtual ~CSimProg () = default;
+  if (!reqVariable[0].empty ())
+    {
+      auto const l_req (reqVariable[0].data ());
+      auto const l_ack (ackVariable[0].data ());
+      auto const l_size (reqVariable[0].size ());
 
-  void Run (void);
+      size_t l_i (0);
 
-private:
-  CTwinCATADS & m_twinCATADS;
-  int const m_prog;
-  bool m_runProgram;
-  ULONGLONG m_t;
+      // sixteen programs at a time, a BOOL is 0 or 1 so an acknowledged request is req & ~ack...
 
-  static ULONGLONG const RUN_PROGRAM_DELAY;
+      for (; (l_i + HANDSHAKE_LANES) <= l_size; l_i += HANDSHAKE_LANES)
+        {
+          auto const l_req_ (_mm_loadu_si128 (reinterpret_cast <__m128i const *> (l_req + l_i)));
+          auto const l_ack_ (_mm_loadu_si128 (reinterpret_cast <__m128i const *> (l_ack + l_i)));
 
-public:
-  // copy construction and assignment not allowed for this class
+          _mm_storeu_si128 (reinterpret_cast <__m128i *> (l_req + l_i), _mm_andnot_si128 (l_ack_, l_req_));
+        }
 
-  CSimProg (const CSimProg &) = delete;
-  CSimProg & operator = (const CSimProg &) = delete;
-};
+      for (; l_i < l_size; ++l_i)
+        {
+          // check for acknowledgment...
 
-ULONGLONG const CTwinCATADS::CSimProg::RUN_PROGRAM_DELAY (5000);
+          if (l_req[l_i] && l_ack[l_i])
+            {
+              // request acknowledged, clear request...
 
-CTwinCATADS::CSimProg::CSimProg (CTwinCATADS & twinCATADS, int prog)
-  : m_twinCATADS (twinCATADS)
-  , m_prog (prog)
-  , m_runProgram (false)
-  , m_t (0)
-{
-  Run ();
+              l_req[l_i] = MC_False;
+            }
+        }
+
+      return UpdateOutputs (symbol, reqVariable);
+    }
+
+  return true;
 }
 
-void
-CTwinCATADS::CSimProg::Run (void)
+bool
+CTwinCATADS::UpdateOutputs_ (ESymbol                         symbol,
+                             CRequest                      & reqVariable,
+                             CTripleBuffer <MC_Bool> const & ackVariable)
 {
-  if (m_twinCATADS.m_runProgram[0][m_prog])
+  if (!reqVariable[0].empty ())
     {
-      if (m_runProgram)
+      // the handshake runs on the raw arrays, the request, acknowledge and fault blocks are each contiguous...
+
+      auto const l_req (reqVariable[0].data ());
+      auto const l_sent (reqVariable[1].data ());
+      auto const l_ack (ackVariable[0].data ());
+      auto const l_faulted (m_motionFaulted[0].data ());
+      auto const l_faultCode (m_faultCode[0].data ());
+      auto const l_size (reqVariable[0].size ());
+
+      size_t l_i (0);
+      bool   l_isPending (false);
+
+      // sixteen axes at a time with byte masks (a BOOL is 0 or 1), the same decisions as the loop below:
+      //
+      //   pending = req & ~sent            faulted' = faulted & ~pending
+      //   cleared = req & ~pending & (ack | (faulted & ~stopped))
+      //   req'    = req & ~cleared
+
+      auto const l_stoppedFault (_mm_set1_epi32 (static_cast <int> (AXIS_STOPPED_FAULT)));
+
+      for (; (l_i + HANDSHAKE_LANES) <= l_size; l_i += HANDSHAKE_LANES)
+        {
+          auto const l_req_     (_mm_loadu_si128 (reinterpret_cast <__m128i const *> (l_req + l_i)));
+          auto const l_sent_    (_mm_loadu_si128 (reinterpret_cast <__m128i const *> (l_sent + l_i)));
+          auto const l_ack_     (_mm_loadu_si128 (reinterpret_cast <__m128i const *> (l_ack + l_i)));
+          auto const l_faulted_ (_mm_loadu_si128 (reinterpret_cast <__m128i const *> (l_faulted + l_i)));
+
+          // the fault codes are 32 bits wide, their compares are narrowed to one byte per axis...
+
+          auto const l_stopped0 (_mm_cmpeq_epi32 (_mm_loadu_si128 (reinterpret_cast <__m128i const *> (l_faultCode + l_i)), l_stoppedFault));
+          auto const l_stopped1 (_mm_cmpeq_epi32 (_mm_loadu_si128 (reinterpret_cast <__m128i const *> (l_faultCode + l_i + 4)), l_stoppedFault));
+          auto const l_stopped2 (_mm_cmpeq_epi32 (_mm_loadu_si128 (reinterpret_cast <__m128i const *> (l_faultCode + l_i + 8)), l_stoppedFault));
+          auto const l_stopped3 (_mm_cmpeq_epi32 (_mm_loadu_si128 (reinterpret_cast <__m128i const *> (l_faultCode + l_i + 12)), l_stoppedFault));
+          auto const l_stopped  (_mm_packs_epi16 (_mm_packs_epi32 (l_stopped0, l_stopped1), _mm_packs_epi32 (l_stopped2, l_stopped3)));
+
+          auto const l_pending (_mm_andnot_si128 (l_sent_, l_req_));
+          auto const l_cleared (_mm_and_si128 (_mm_andnot_si128 (l_pending, l_req_), _mm_or_si128 (l_ack_, _mm_andnot_si128 (l_stopped, l_faulted_))));
+
+          _mm_storeu_si128 (reinterpret_cast <__m128i *> (l_faulted + l_i), _mm_andnot_si128 (l_pending, l_faulted_));
+          _mm_storeu_si128 (reinterpret_cast <__m128i *> (l_req + l_i), _mm_andnot_si128 (l_cleared, l_req_));
+
+          l_isPending = l_isPending || (_mm_movemask_epi8 (l_pending) != 0);
+        }
+
+      for (; l_i < l_size; ++l_i)
         {
-          if (!m_twinCATADS.m_runProgram[0][m_prog])
+          if ((l_req[l_i] == MC_True) && (l_sent[l_i] == MC_False))
             {
-              m_twinCATADS.m_programStatus[1][m_prog]   = CTwinCATADS::PROGRAM_STOPPED_FAULT;
+              // pending request, clear any prior error (it stays clear until the next sample arrives)...
 
-              m_twinCATADS.m_programComplete[1][m_prog] = CTwinCATADS::MC_True;
+              l_faulted[l_i] = MC_False;
 
-              PDCLib::Trace (_T ("stopped simulation program (%ld)"), m_prog);
+              l_isPending = true;
             }
-          else if ((PDCLib::GetTickCount () - m_t) > RUN_PROGRAM_DELAY)
+          else if (l_req[l_i] && (l_ack[l_i] || ((l_faulted[l_i] == MC_True) && (l_faultCode[l_i] != AXIS_STOPPED_FAULT))))
             {
-              m_twinCATADS.m_programStatus[1][m_prog]   = CTwinCATADS::PROGRAM_NO_FAULT;
-
-              m_twinCATADS.m_programComplete[1][m_prog] = CTwinCATADS::MC_True;
+              // positive acknowledgment or error (not axis stopped), clear request...
 
-              PDCLib::Trace (_T ("completed simulation program (%ld)"), m_prog);
+              l_req[l_i] = MC_False;
             }
         }
-      else
-        {
-          m_t = PDCLib::GetTickCount ();
 
-          m_runProgram = true;
+      // the fault is cleared in the samples not yet acquired as well, or the next UpdateInputs would
+      // bring the prior error back...
 
-          PDCLib::Trace (_T ("started simulation program (%ld)"), m_prog);
+      if (l_isPending)
+        {
+          m_motionFaulted.Modify ([l_req, l_sent, l_size] (std::vector <MC_Bool> & faulted)
+                                  {
+                                    for (size_t l_i (0); l_i < l_size; ++l_i)
+                                      {
+                                        if ((l_req[l_i] == MC_True) && (l_sent[l_i] == MC_False))
+                                          {
+                                            faulted[l_i] = MC_False;
+                                          }
+                                      }
+                                  });
         }
-    }
-  else
-    {
-      m_twinCATADS.m_programComplete[1][m_prog] = CTwinCATADS::MC_False;
 
-      m_runProgram = false;
+      return UpdateOutputs (symbol, reqVariable);
     }
+
+  return true;
 }
 
-CTwinCATADS::CTwinCATADS (int  controllerId,
-                          int  numAxes,
-                          int  numPrograms,
-                          bool simulationMode)
-  : m_controllerId (PDCLib::StringWithFormat (_T ("Controller%ld."), controllerId))
-  , m_acceleration (numAxes, 0.0)
-  , m_deceleration (numAxes, 0.0)
-  , m_jerk (numAxes, 0.0)
-  , m_position (numAxes, 0.0)
-  , m_velocity (numAxes, 0.0)
-  , m_direction (numAxes, MC_None)
-  , m_stopProgram (numPrograms, MC_False)
-  , m_analogInputs (XShim <SAnalogInputs>::size)
-  , m_discreteInputs (XShim <SDiscreteInputs>::size)
+void
+CTwinCATADS::AllocInputs (CRequest                            & buffer,
+                          std::vector <MC_Bool>::size_type      size,
+                          MC_Bool                               initValue1,
+                          MC_Bool                               initValue2)
 {
-  ASSERT (controllerId >= 0);
-  ASSERT (numAxes >= 0);
-  ASSERT (numPrograms >= 0);
+  buffer[0].assign (size, initValue1);
+  buffer[1].assign (size, initValue2);
+}
 
-  AllocInputs (m_beginMotion, numAxes, MC_False, MC_True);
-  AllocInputs (m_stopMotion, numAxes, MC_False, MC_True);
-  AllocInputs (m_motionComplete, numAxes);
-  AllocInputs (m_motionStopped, numAxes);
-  AllocInputs (m_motionFaulted, numAxes);
-  AllocInputs (m_runProgram, numPrograms, MC_False, MC_True);
-  AllocInputs (m_programComplete, numPrograms);
-  AllocInputs (m_faultCode, numAxes);
-  AllocInputs (m_programStatus, numPrograms);
-  AllocInputs (m_actualPosition, numAxes);
-  AllocInputs (m_actualVelocity, numAxes);
+bool
+CTwinCATADS::RegisterNotification (EADSInstance adsInstance, std::vector <CNotification> const & notifications)
+{
+  std::vector <ITwinCATADS::CNotification> l_notifications;
 
-  if (simulationMode)
+  for (auto&& l_notification : notifications)
     {
-      for (int l_axis (0); l_axis < numAxes; ++l_axis)
+      if (std::get <1> (l_notification) > 0)
         {
-          CSimAxisPtr l_simAxis (new CSimAxis (*this, l_axis));
+          auto const & l_notificationRate (m_notificationRate[std::get <0> (l_notification)]);
 
-          m_simAxis.push_back (l_simAxis);
-        }
+          AdsNotificationAttrib l_adsNotificationAttrib {};
 
-      for (int l_prog (0); l_prog < numPrograms; ++l_prog)
-        {
-          CSimProgPtr l_simProg (new CSimProg (*this, l_prog));
+          l_adsNotificationAttrib.cbLength   = static_cast <unsigned long> (std::get <1> (l_notification)); // total size of variable in bytes
+          l_adsNotificationAttrib.nTransMode = l_notificationRate.transMode;
+          l_adsNotificationAttrib.nMaxDelay  = l_notificationRate.maxDelay * TICKS_PER_MILLISECOND;
+          l_adsNotificationAttrib.nCycleTime = l_notificationRate.cycleTime * TICKS_PER_MILLISECOND;
 
-          m_simProg.push_back (l_simProg);
+          l_notifications.emplace_back (m_symbol[std::get <0> (l_notification)], l_adsNotificationAttrib, std::get <2> (l_notification));
         }
     }
-}
-
-CTwinCATADS::~CTwinCATADS ()
-{
-}
-
-bool
-CTwinCATADS::Create (void)
-{
-  return Create_ ();
-}
 
-bool
-CTwinCATADS::Create (WORD analogPortNumber, WORD discretePortNumber)
-{
-  if (analogPortNumber == discretePortNumber)
-    {
-      m_errorMessage = _T ("analog and discrete port numbers must be unique");
-    }
-  else if ((analogPortNumber < AMSPORT_R0_IO) || (discretePortNumber < AMSPORT_R0_IO))
-    {
-      m_errorMessage = _T ("analog or discrete port number is out of range");
-    }
-  else if ((analogPortNumber < AMSPORT_R0_SPS) && (discretePortNumber < AMSPORT_R0_SPS))
+  try
     {
-      return Create_ (analogPortNumber, discretePortNumber);
+      m_twinCATADS[static_cast <int> (adsInstance)]->RegisterNotification (l_notifications, this);
     }
-  else
+  catch (CString const & errorMessage)
     {
-      m_errorMessage = _T ("analog or discrete port number is out of range");
+      m_errorMessage = errorMessage;
+
+      return false;
     }
 
-  return false;
+  return true;
 }
 
-void
-CTwinCATADS::UpdateInputs (void)
+bool
+CTwinCATADS::RegisterStatusNotification (bool isTC3)
 {
-  std::unique_lock <std::mutex> l_notificationGate { m_notificationGate };
+  // the segment queue progress has its own notification, also in the aggregated status mode...
 
-  UpdateInputs (m_actualPosition);
-  UpdateInputs (m_actualVelocity);
-  UpdateInputs (m_motionComplete);
-  UpdateInputs (m_motionStopped);
-  UpdateInputs (m_motionFaulted);
-  UpdateInputs (m_faultCode);
-  UpdateInputs (m_programComplete);
-  UpdateInputs (m_programStatus);
-}
+  if (m_isSegmentQueue && !(isTC3 ? RegisterNotification (EADSInstance::PLC, { Notification (VAR_SEGMENTREAD, m_segmentRead, OnSegmentReadTC3) })
+                                  : RegisterNotification (EADSInstance::PLC, { Notification (VAR_SEGMENTREAD, m_segmentRead, OnSegmentReadTC2) })))
+    {
+      return false;
+    }
 
-bool
-CTwinCATADS::UpdateOutputs (void)
-{
-  if (UpdateOutputs_ (VAR_BEGINMOTION, m_beginMotion, m_motionComplete) &&
-      UpdateOutputs_ (VAR_STOPMOTION, m_stopMotion, m_motionStopped) &&
-      UpdateOutputs (VAR_RUNPROGRAM, m_runProgram, m_programComplete))
+  if (m_statusMode == EStatusMode::Aggregated)
     {
-      for (auto&& l_simAxis : m_simAxis)
+      // the unpacking relies on the layout of the PLC structure, check its size (allowing for trailing padding) first...
+
+      ULONG l_cbStatus (0);
+
+      try
         {
-          l_simAxis->Run ();
+          l_cbStatus = m_twinCATADS[static_cast <int> (EADSInstance::PLC)]->GetSymbolSize (m_symbol[VAR_CONTROLLERSTATUS]);
         }
+      catch (CString const & errorMessage)
+        {
+          m_errorMessage = errorMessage;
 
-      for (auto&& l_simProg : m_simProg)
+          return false;
+        }
+
+      if ((l_cbStatus < m_controllerStatus.size ()) || (l_cbStatus >= (m_controllerStatus.size () + sizeof (MC_LReal))))
         {
-          l_simProg->Run ();
+          m_errorMessage.Format (_T ("%s is %lu bytes, %lu bytes expected for %ld axes and %ld programs"),
+                                 (LPCTSTR) m_symbolName[VAR_CONTROLLERSTATUS],
+                                 l_cbStatus,
+                                 static_cast <ULONG> (m_controllerStatus.size ()),
+                                 static_cast <int> (m_actualPosition.size ()),
+                                 static_cast <int> (m_programStatus.size ()));
+
+          return false;
         }
 
-      return true;
+      return isTC3 ? RegisterNotification (EADSInstance::PLC, { Notification (VAR_CONTROLLERSTATUS, m_controllerStatus, OnControllerStatusTC3) })
+                   : RegisterNotification (EADSInstance::PLC, { Notification (VAR_CONTROLLERSTATUS, m_controllerStatus, OnControllerStatusTC2) });
+    }
+  else if (isTC3)
+    {
+      return RegisterNotification (EADSInstance::PLC, { Notification (VAR_ACTUALPOSITION, m_actualPosition, OnActualPositionTC3),
+                                                        Notification (VAR_ACTUALVELOCITY, m_actualVelocity, OnActualVelocityTC3),
+                                                        Notification (VAR_MOTIONCOMPLETE, m_motionComplete, OnMotionCompleteTC3),
+                                                        Notification (VAR_MOTIONSTOPPED, m_motionStopped, OnMotionStoppedTC3),
+                                                        Notification (VAR_MOTIONFAULTED, m_motionFaulted, OnMotionFaultedTC3),
+                                                        Notification (VAR_FAULTCODE, m_faultCode, OnFaultCodeTC3),
+                                                        Notification (VAR_PROGRAMCOMPLETE, m_programComplete, OnProgramCompleteTC3),
+                                                        Notification (VAR_PROGRAMSTATUS, m_programStatus, OnProgramStatusTC3) });
     }
 
-  return false;
+  return RegisterNotification (EADSInstance::PLC, { Notification (VAR_ACTUALPOSITION, m_actualPosition, OnActualPositionTC2),
+                                                    Notification (VAR_ACTUALVELOCITY, m_actualVelocity, OnActualVelocityTC2),
+                                                    Notification (VAR_MOTIONCOMPLETE, m_motionComplete, OnMotionCompleteTC2),
+                                                    Notification (VAR_MOTIONSTOPPED, m_motionStopped, OnMotionStoppedTC2),
+                                                    Notification (VAR_MOTIONFAULTED, m_motionFaulted, OnMotionFaultedTC2),
+                                                    Notification (VAR_FAULTCODE, m_faultCode, OnFaultCodeTC2),
+                                                    Notification (VAR_PROGRAMCOMPLETE, m_programComplete, OnProgramCompleteTC2),
+                                                    Notification (VAR_PROGRAMSTATUS, m_programStatus, OnProgramStatusTC2) });
 }
 
-bool
-CTwinCATADS::SetAcceleration (int axis, double acceleration)
+template <typename T> void
+CTwinCATADS::AcquireInputs (CTripleBuffer <T> & variable, CChangeMask & changeMask)
 {
-  return SetVariable_ (EADSInstance::PLC, VAR_ACCELERATION, m_acceleration, axis, acceleration);
-}
+  if (variable.Acquire ())
+    {
+      auto const & l_current (variable[0]);
+      auto const & l_previous (variable.previous ());
 
-bool
-CTwinCATADS::SetDeceleration (int axis, double deceleration)
-{
-  return SetVariable_ (EADSInstance::PLC, VAR_DECELERATION, m_deceleration, axis, deceleration);
+      for (int l_i (0); static_cast <size_t> (l_i) < l_current.size (); ++l_i)
+        {
+          if (l_current[l_i] != l_previous[l_i])
+            {
+              ::SetBit (changeMask, l_i);
+            }
+        }
+    }
 }
 
-bool
-CTwinCATADS::SetDirection (int axis, MC_Direction direction)
+template <typename T> void
+CTwinCATADS::Unpack (CTripleBuffer <T> & variable, MC_Byte const * & pData, CChangeMask & changeMask)
 {
-  return SetVariable_ (EADSInstance::PLC, VAR_DIRECTION, m_direction, axis, direction);
-}
+  auto & l_current (variable[0]);
 
-bool
-CTwinCATADS::SetJerk (int axis, double jerk)
-{
-  return SetVariable_ (EADSInstance::PLC, VAR_JERK, m_jerk, axis, jerk);
-}
+  for (int l_i (0); static_cast <size_t> (l_i) < l_current.size (); ++l_i, pData += sizeof (T))
+    {
+      // copied rather than cast, the sample is a plain byte buffer...
 
-bool
-CTwinCATADS::SetPosition (int axis, double position)
-{
-  return SetVariable_ (EADSInstance::PLC, VAR_POSITION, m_position, axis, position);
-}
+      T l_value;
 
-bool
-CTwinCATADS::SetVelocity (int axis, double velocity)
-{
-  return SetVariable_ (EADSInstance::PLC, VAR_VELOCITY, m_velocity, axis, velocity);
-}
+      ::memcpy_s (&l_value, sizeof (l_value), pData, sizeof (T));
 
-bool CTwinCATADS::SetJogMode (int axis, double slewSpeed)
-{
-  return SetDirection (axis, (slewSpeed < 0.0) ? MC_Negative : MC_Positive) && SetVelocity (axis, std::abs (slewSpeed));
-}
+      if (l_value != l_current[l_i])
+        {
+          l_current[l_i] = l_value;
 
-void CTwinCATADS::BeginMotion (int axis)
-{
-  m_beginMotion[0][axis] = MC_True;
+          ::SetBit (changeMask, l_i);
+        }
+    }
 }
 
-void
-CTwinCATADS::StopMotion (int axis)
+template <typename T> bool
+CTwinCATADS::SetVariable_ (ESymbol symbol, std::vector <T> & value, int index, T value_)
 {
-  m_stopMotion[0][axis]  = MC_True;
-  m_beginMotion[0][axis] = MC_False;
-}
+  CheckRebindCount ();
 
-bool
-CTwinCATADS::IsMotionComplete (int axis) const
-{
-  return (m_stopMotion[0][axis] ||
-          m_beginMotion[0][axis] ||
-          m_motionStopped[0][axis] ||
-          m_motionComplete[0][axis]) ? false : true;
-}
+  value[index] = value_;
 
-bool
-CTwinCATADS::IsMotionFaulted (int axis) const
-{
-  return (m_motionFaulted[0][axis] == MC_True) && (m_faultCode[0][axis] != AXIS_STOPPED_FAULT);
-}
+  auto const l_pValue (reinterpret_cast <MC_Byte const *> (&value[0]));
+  auto const l_cbValue (value.size () * sizeof (T));
+  auto const l_offset (index * sizeof (T));
+  auto & l_writtenValue (m_writtenValue[symbol]);
 
-DWORD
-CTwinCATADS::GetFaultCode (int axis) const
-{
-  return m_faultCode[0][axis];
-}
+  if (l_writtenValue.size () == l_cbValue)
+    {
+      // the element alone is written when the rest of the array is already on the PLC...
 
-double
-CTwinCATADS::GetPosition (int axis) const
-{
-  return m_actualPosition[0][axis];
-}
+      if (std::equal (l_writtenValue.begin (), l_writtenValue.begin () + l_offset, l_pValue) &&
+          std::equal (l_writtenValue.begin () + l_offset + sizeof (T), l_writtenValue.end (), l_pValue + l_offset + sizeof (T)))
+        {
+          if (std::equal (l_writtenValue.begin () + l_offset, l_writtenValue.begin () + l_offset + sizeof (T), l_pValue + l_offset))
+            {
+              // the PLC already has this value...
 
-double
-CTwinCATADS::GetVelocity (int axis) const
-{
-  return m_actualVelocity[0][axis];
-}
+              return true;
+            }
 
-bool
-CTwinCATADS::SetVariable (const CString & identifier, int value)
-{
-  return SetVariable_ (EADSInstance::PLC, identifier, value);
-}
+          bool l_isWritten (false);
 
-bool
-CTwinCATADS::SetVariable (const CString & identifier, BYTE value)
-{
-  return SetVariable_ (EADSInstance::PLC, identifier, value);
-}
+          if (!SetElement_ (symbol, l_offset, sizeof (T), l_pValue + l_offset, l_isWritten))
+            {
+              return false;
+            }
+          else if (l_isWritten)
+            {
+              std::copy (l_pValue + l_offset, l_pValue + l_offset + sizeof (T), l_writtenValue.begin () + l_offset);
 
-bool
-CTwinCATADS::SetVariable (const CString & identifier, double value)
-{
-  return SetVariable_ (EADSInstance::PLC, identifier, value);
-}
+              return true;
+            }
+        }
+    }
 
-bool
-CTwinCATADS::SetVariable (const CString & identifier, const std::vector <int> & value)
-{
-  return SetVariable_ (EADSInstance::PLC, identifier, value);
+  return SetVariable_ (symbol, value);
 }
 
-bool
-CTwinCATADS::SetVariable (const CString & identifier, const std::vector <BYTE> & value)
+template <typename T> bool
+CTwinCATADS::SetVariable_ (ESymbol symbol, std::vector <T> const & value)
 {
-  return SetVariable_ (EADSInstance::PLC, identifier, value);
-}
+  // every write of a whole array keeps the written value current, whichever setter made it...
 
-bool
-CTwinCATADS::SetVariable (const CString & identifier, const std::vector <double> & value)
-{
-  return SetVariable_ (EADSInstance::PLC, identifier, value);
-}
+  auto const l_pValue (reinterpret_cast <MC_Byte const *> (&value[0]));
+  auto const l_cbValue (value.size () * sizeof (T));
+  auto const l_adsInstance (std::get <0> (m_symbolIdentifier[symbol]));
+  auto & l_writtenValue (m_writtenValue[symbol]);
 
-bool
-CTwinCATADS::RunProgram (int identifier, bool stopEnabled)
-{
-  if (!stopEnabled || SetVariable_ (EADSInstance::PLC, VAR_STOPPROGRAM, m_stopProgram, identifier, MC_False))
+  if (!SetVariable_ (l_adsInstance, m_symbol[symbol], l_cbValue, l_pValue))
     {
-      m_runProgram[0][identifier] = MC_True;
+      l_writtenValue.clear ();
 
-      return true;
+      return false;
     }
 
-  return false;
-}
+  // a queued value is recorded once it is written, until then the PLC may still hold the old one...
 
-bool
-CTwinCATADS::StopProgram (int identifier)
-{
-  return SetVariable_ (EADSInstance::PLC, VAR_STOPPROGRAM, m_stopProgram, identifier, MC_True);
-}
+  if (IsWriteQueued (l_adsInstance))
+    {
+      l_writtenValue.clear ();
+    }
+  else
+    {
+      l_writtenValue.assign (l_pValue, l_pValue + l_cbValue);
+    }
 
-bool
-CTwinCATADS::IsProgramComplete (int identifier) const
-{
-  return (m_runProgram[0][identifier] || m_programComplete[0][identifier]) ? false : true;
+  return true;
 }
 
-DWORD
-CTwinCATADS::GetProgramStatus (int identifier) const
+template <typename T> bool
+CTwinCATADS::SetVariable_ (CString const & identifier, T const & value)
 {
-  return m_programStatus[0][identifier];
+  return SetVariable_ (identifier, sizeof (T), &value);
 }
 
-CString
-CTwinCATADS::GetErrorMessage (void) const
+template <typename T> bool
+CTwinCATADS::SetVariable_ (CString const & identifier, std::vector <T> const & value)
 {
-  return m_errorMessage;
+  return SetVariable_ (identifier, value.size () * sizeof (T), &value[0]);
 }
 
-CString
-CTwinCATADS::GetErrorMessage (DWORD programStatus)
+bool
+CTwinCATADS::SetElement_ (ESymbol symbol, size_t offset, size_t cbLength, void const * pData, bool & isWritten)
 {
-  if (programStatus < m_programStatusMessage.size ())
-    {
-      return m_programStatusMessage[programStatus];
-    }
-  else
+  // only the immediate write mode writes by address, the write queues hold whole symbols...
+
+  auto const l_adsInstance (std::get <0> (m_symbolIdentifier[symbol]));
+
+  isWritten = false;
+
+  if ((m_writeMode == EWriteMode::Immediate) && (static_cast <size_t> (l_adsInstance) < m_twinCATADS.size ()))
     {
-      return PDCLib::StringWithFormat (_T ("unrecognized TwinCAT ADS program status: 0x%08X"), programStatus);
+      try
+        {
+          isWritten = m_twinCATADS[static_cast <int> (l_adsInstance)]->SetElement (m_symbol[symbol], offset, cbLength, pData);
+        }
+      catch (CString const & errorMessage)
+        {
+          m_errorMessage = errorMessage;
+
+          return false;
+        }
     }
+
+  return true;
 }
 
-CString
-CTwinCATADS::GetADSErrorMessage (DWORD faultCode)
+bool
+CTwinCATADS::SetVariable_ (CString const & identifier, size_t cbLength, void const * pData)
 {
-  if (auto const l_adsErrorMessage (m_adsErrorMessage.find (faultCode)); l_adsErrorMessage == m_adsErrorMessage.end ())
-    {
-      return PDCLib::StringWithFormat (_T ("unrecognized TwinCAT ADS fault code: 0x%08X"), faultCode);
-    }
-  else
+  if (m_twinCATADS.empty ())
     {
-      return PDCLib::StringWithFormat (_T ("%s: 0x%08X"), (LPCTSTR) std::get <1> (*l_adsErrorMessage), std::get <0> (*l_adsErrorMessage));
+      return true;
     }
-}
 
-HMODULE
-CTwinCATADS::GetModuleHandle (void)
-{
-  return ITwinCATADS::GetModuleHandle ();
-}
+  // program variables are interned on first use...
 
-void
-CTwinCATADS::UpdateInputs (SAnalogInputs * analogInputs, SDiscreteInputs * discreteInputs)
-{
-  std::unique_lock <std::mutex> l_notificationGate { m_notificationGate };
+  auto const l_symbol (m_twinCATADS[static_cast <int> (EADSInstance::PLC)]->AddSymbol (GetSymbolName (EADSInstance::PLC, identifier)));
 
-  UpdateInputs (m_analogInputs, analogInputs);
-  UpdateInputs (m_discreteInputs, discreteInputs);
-}
+  // a program variable may name a controller symbol, whose written value is then no longer known...
 
-void
-CTwinCATADS::UpdateOutputs (SAnalogOutputs const * analogOutputs, SDiscreteOutputs const * discreteOutputs)
-{
-  SetVariable_ (EADSInstance::AIO, VAR_ANALOGOUTPUTS, m_analogOutputs, analogOutputs);
-  SetVariable_ (EADSInstance::DIO, VAR_DISCRETEOUTPUTS, m_discreteOutputs, discreteOutputs);
+  if (auto const l_symbol_ (FindSymbol (l_symbol)); l_symbol_ >= 0)
+    {
+      m_writtenValue[l_symbol_].clear ();
+    }
+
+  return SetVariable_ (EADSInstance::PLC, l_symbol, cbLength, pData);
 }
 
 bool
-CTwinCATADS::Create_ (WORD analogPortNumber, WORD discretePortNumber)
+CTwinCATADS::SetVariable_ (EADSInstance adsInstance, int symbol, size_t cbLength, void const * pData)
 {
-  if (m_simAxis.empty () && m_simProg.empty ())
+  if (static_cast <size_t> (adsInstance) < m_twinCATADS.size ())
     {
-      if (Create <CTwinCATADS3> (AMSPORT_R0_PLC_TC3))
+      try
         {
-          if (RegisterNotification (EADSInstance::PLC, VAR_ACTUALPOSITION, m_actualPosition, OnActualPositionTC3) &&
-              RegisterNotification (EADSInstance::PLC, VAR_ACTUALVELOCITY, m_actualVelocity, OnActualVelocityTC3) &&
-              RegisterNotification (EADSInstance::PLC, VAR_MOTIONCOMPLETE, m_motionComplete, OnMotionCompleteTC3) &&
-              RegisterNotification (EADSInstance::PLC, VAR_MOTIONSTOPPED, m_motionStopped, OnMotionStoppedTC3) &&
-              RegisterNotification (EADSInstance::PLC, VAR_MOTIONFAULTED, m_motionFaulted, OnMotionFaultedTC3) &&
-              RegisterNotification (EADSInstance::PLC, VAR_FAULTCODE, m_faultCode, OnFaultCodeTC3) &&
-              RegisterNotification (EADSInstance::PLC, VAR_PROGRAMCOMPLETE, m_programComplete, OnProgramCompleteTC3) &&
-              RegisterNotification (EADSInstance::PLC, VAR_PROGRAMSTATUS, m_programStatus, OnProgramStatusTC3))
+          auto const & l_twinCATADS (m_twinCATADS[static_cast <int> (adsInstance)]);
+
+          if (IsWriteQueued (adsInstance))
             {
-              if ((analogPortNumber == 0) && (discretePortNumber == 0))
+              // resolve the symbol now so that an unknown symbol is reported to the
+              // caller instead of stalling every subsequent flush...
+
+              l_twinCATADS->GetHandle (symbol);
+
+              if (m_writeMode == EWriteMode::Combined)
                 {
-                  return UpdateOutputs ();
+                  QueueVariable (m_pendingVariable, symbol, cbLength, pData);
                 }
-              else if (Create <CTwinCATADS3> (analogPortNumber) && Create <CTwinCATADS3> (discretePortNumber))
+              else
                 {
-                  return RegisterNotification (EADSInstance::AIO, VAR_ANALOGINPUTS, m_analogInputs, OnAnalogInputsTC3) &&
-                         RegisterNotification (EADSInstance::DIO, VAR_DISCRETEINPUTS, m_discreteInputs, OnDiscreteInputsTC3) &&
-                         UpdateOutputs ();
+                  if (!m_asyncWriter)
+                    {
+                      m_asyncWriter = std::make_unique <CAsyncWriter> (l_twinCATADS);
+                    }
+
+                  m_asyncWriter->Queue (symbol, cbLength, pData);
                 }
             }
-        }
-      else if (Create <CTwinCATADS2> (AMSPORT_R0_PLC_RTS1))
-        {
-          if (RegisterNotification (EADSInstance::PLC, VAR_ACTUALPOSITION, m_actualPosition, OnActualPositionTC2) &&
-              RegisterNotification (EADSInstance::PLC, VAR_ACTUALVELOCITY, m_actualVelocity, OnActualVelocityTC2) &&
-              RegisterNotification (EADSInstance::PLC, VAR_MOTIONCOMPLETE, m_motionComplete, OnMotionCompleteTC2) &&
-              RegisterNotification (EADSInstance::PLC, VAR_MOTIONSTOPPED, m_motionStopped, OnMotionStoppedTC2) &&
-              RegisterNotification (EADSInstance::PLC, VAR_MOTIONFAULTED, m_motionFaulted, OnMotionFaultedTC2) &&
-              RegisterNotification (EADSInstance::PLC, VAR_FAULTCODE, m_faultCode, OnFaultCodeTC2) &&
-              RegisterNotification (EADSInstance::PLC, VAR_PROGRAMCOMPLETE, m_programComplete, OnProgramCompleteTC2) &&
-              RegisterNotification (EADSInstance::PLC, VAR_PROGRAMSTATUS, m_programStatus, OnProgramStatusTC2))
+          else
             {
-              if ((analogPortNumber == 0) && (discretePortNumber == 0))
-                {
-                  return UpdateOutputs ();
-                }
-              else if (Create <CTwinCATADS2> (analogPortNumber) && Create <CTwinCATADS2> (discretePortNumber))
-                {
-                  return RegisterNotification (EADSInstance::AIO, VAR_ANALOGINPUTS, m_analogInputs, OnAnalogInputsTC2) &&
-                         RegisterNotification (EADSInstance::DIO, VAR_DISCRETEINPUTS, m_discreteInputs, OnDiscreteInputsTC2) &&
-                         UpdateOutputs ();
-                }
+              l_twinCATADS->SetVariable (symbol, cbLength, pData);
             }
         }
+      catch (CString const & errorMessage)
+        {
+          m_errorMessage = errorMessage;
 
-      return false;
+          return false;
+        }
     }
 
-  return UpdateOutputs ();
+  return true;
 }
 
-template <typename T> bool
-CTwinCATADS::Create (WORD portNumber)
+void
+CTwinCATADS::QueueVariable (CPendingVariable & pendingVariable, int symbol, size_t cbLength, void const * pData)
 {
-  try
-    {
-      auto const l_twinCATADS (std::make_shared <T> ());
-
-      l_twinCATADS->Create (portNumber);
-
-      m_twinCATADS.emplace_back (l_twinCATADS);
+  auto l_pos (std::find_if (pendingVariable.begin (),
+                            pendingVariable.end (),
+                            [symbol] (auto const & pendingVariable) { return std::get <0> (pendingVariable) == symbol; }));
 
-      return true;
+  if (l_pos == pendingVariable.end ())
+    {
+      pendingVariable.emplace_back (symbol, std::vector <MC_Byte> ());
     }
-  catch (CString const & errorMessage)
+  else
     {
-      PDCLib::Trace (_T ("%s"), (LPCTSTR) errorMessage);
+      // last writer wins; move the symbol behind all other pending symbols so
+      // that handshake requests are always written after their setpoints...
 
-      m_errorMessage = errorMessage;
+      std::rotate (l_pos, l_pos + 1, pendingVariable.end ());
     }
 
-  return false;
+  auto const l_pData (static_cast <MC_Byte const *> (pData));
+
+  std::get <1> (pendingVariable.back ()).assign (l_pData, l_pData + cbLength);
 }
 
 bool
-CTwinCATADS::UpdateOutputs (CString                              const & identifier,
-                            std::vector <std::vector <MC_Bool> >       & reqVariable)
+CTwinCATADS::FlushVariables (void)
 {
-  // check for pending requests...
-
-  if (reqVariable[0] == reqVariable[1])
+  if (m_asyncWriter)
     {
-      // no pending requests...
+      // errors from the writer thread are reported on the control thread...
 
-      return true;
+      return m_asyncWriter->Retry (m_errorMessage);
     }
-  else if (SetVariable_ (EADSInstance::PLC, identifier, reqVariable[0]))
+  else if (m_pendingVariable.empty ())
     {
-      // clear pending requests...
-
-      reqVariable[1] = reqVariable[0];
-
       return true;
     }
 
-  return false;
-}
+  std::vector <ITwinCATADS::CVariable> l_variables;
 
-bool
-CTwinCATADS::UpdateOutputs (CString                              const & identifier,
-                            std::vector <std::vector <MC_Bool> >       & reqVariable,
-                            std::vector <std::vector <MC_Bool> > const & ackVariable)
-{
-  if (!reqVariable.empty ())
+  l_variables.reserve (m_pendingVariable.size ());
+
+  for (auto&& l_pendingVariable : m_pendingVariable)
     {
-      for (int l_i (0); static_cast <size_t> (l_i) < reqVariable[0].size (); ++l_i)
-        {
-          // check for acknowledgment...
+      l_variables.emplace_back (std::get <0> (l_pendingVariable), std::get <1> (l_pendingVariable).size (), &std::get <1> (l_pendingVariable)[0]);
+    }
 
-          if (reqVariable[0][l_i] && ackVariable[0][l_i])
-            {
-              // request acknowledged, clear request...
+  try
+    {
+      m_twinCATADS[static_cast <int> (EADSInstance::PLC)]->SetVariable (l_variables);
+    }
+  catch (CString const & errorMessage)
+    {
+      // pending writes are retained and retried on the next update...
 
-              reqVariable[0][l_i] = MC_False;
-            }
-        }
+      m_errorMessage = errorMessage;
 
-      return UpdateOutputs (identifier, reqVariable);
+      return false;
     }
 
+  CommitPendingVariables ();
+
   return true;
 }
 
-bool
-CTwinCATADS::UpdateOutputs_ (CString                              const & identifier,
-                             std::vector <std::vector <MC_Bool> >       & reqVariable,
-                             std::vector <std::vector <MC_Bool> > const & ackVariable)
+void
+CTwinCATADS::CommitPendingVariables (void)
 {
-  if (!reqVariable.empty ())
+  // the flushed values are what the PLC holds now, a program variable has no written value...
+
+  for (auto&& l_pendingVariable : m_pendingVariable)
     {
-      for (int l_i (0); static_cast <size_t> (l_i) < reqVariable[0].size (); ++l_i)
+      if (auto const l_symbol (FindSymbol (std::get <0> (l_pendingVariable))); l_symbol >= 0)
         {
-          if ((reqVariable[0][l_i] == MC_True) && (reqVariable[1][l_i] == MC_False))
-            {
-              // pending request, clear any prior error...
+          m_writtenValue[l_symbol] = std::get <1> (l_pendingVariable);
+        }
+    }
 
-              m_motionFaulted[0][l_i] = m_motionFaulted[1][l_i] = MC_False;
-            }
-          else if (reqVariable[0][l_i] && (ackVariable[0][l_i] || IsMotionFaulted (l_i)))
-            {
-              // positive acknowledgment or error (not axis stopped), clear request...
+  m_pendingVariable.clear ();
+}
 
-              reqVariable[0][l_i] = MC_False;
-            }
+int
+CTwinCATADS::FindSymbol (int symbol) const
+{
+  for (int l_symbol (0); l_symbol < NUM_SYMBOLS; ++l_symbol)
+    {
+      if ((std::get <0> (m_symbolIdentifier[l_symbol]) == EADSInstance::PLC) && (m_symbol[l_symbol] == symbol))
+        {
+          return l_symbol;
         }
-
-      return UpdateOutputs (identifier, reqVariable);
     }
 
-  return true;
+  return -1;
 }
 
 template <typename T> void
-CTwinCATADS::AllocInputs (         std::vector <std::vector <T> >       & buffer,
-                          typename std::vector <T>::size_type             size,
-                                   T                              const & initValue)
+CTwinCATADS::CopyVariable (AdsNotificationHeader * pNotification, ESymbol symbol, CTripleBuffer <T> & variable)
 {
-  AllocInputs (buffer, size, initValue, initValue);
+  if (pNotification->cbSampleSize == (variable.size () * sizeof (T)))
+    {
+      RecordLatency (symbol, pNotification->nTimeStamp);
+
+      Publish (symbol, variable, reinterpret_cast <T const *> (ADSNOTIFICATION_PDATA (pNotification)), pNotification->nTimeStamp);
+    }
 }
 
 template <typename T> void
-CTwinCATADS::AllocInputs (         std::vector <std::vector <T> >       & buffer,
-                          typename std::vector <T>::size_type             size,
-                                   T                              const & initValue1,
-                                   T                              const & initValue2)
+CTwinCATADS::Publish (ESymbol symbol, CTripleBuffer <T> & variable, T const * pData, LONGLONG timeStamp)
 {
-  ASSERT (buffer.empty ());
+  // events are dispatched once the sample is visible to UpdateInputs, still in publishing order but
+  // outside the publisher gate, so a handler may start a request of its own...
+
+  variable.Publish (pData, timeStamp, [this, symbol, &variable, pData] { DispatchEvents (symbol, reinterpret_cast <MC_Byte const *> (pData), variable.size () * sizeof (T)); });
+
+  // wake any waits, the gate is only touched while someone is waiting so the wakeup is not lost...
+
+  m_notificationCount.fetch_add (1);
 
-  if (size > 0)
+  if (m_waiterCount.load () > 0)
     {
-      buffer.resize (2);
+      {
+        std::unique_lock <std::mutex> l_waitGate { m_waitGate };
+      }
 
-      buffer[0].resize (size, initValue1);
-      buffer[1].resize (size, initValue2);
+      m_waitCondition.notify_all ();
     }
 }
 
-template <typename T> void
-CTwinCATADS::UpdateInputs (std::vector <std::vector <T> > & buffer)
+void
+CTwinCATADS::RecordLatency (ESymbol symbol, LONGLONG timeStamp)
 {
-  if (buffer.empty ())
+  // bucket by the bit length of the latency in microseconds, lock free for the notification thread...
+
+  int l_bucket (0);
+
+  for (auto l_latency ((GetHostFileTime () - timeStamp) / 10); (l_latency > 0) && (l_bucket < (NUM_LATENCY_BUCKETS - 1)); l_latency >>= 1)
     {
-      return;
+      ++l_bucket;
     }
 
-  buffer[0] = buffer[1];
+  m_latencyHistogram[symbol][l_bucket].fetch_add (1, std::memory_order_relaxed);
 }
 
-template <typename T, typename U> bool
-CTwinCATADS::RegisterNotification (EADSInstance            adsInstance,
-                                   CString         const & identifier,
-                                   std::vector <T> const & variable,
-                                   U                       pNoteFunc)
+void
+CTwinCATADS::DispatchEvents (ESymbol symbol, MC_Byte const * pData, size_t cbData)
 {
-  if (!variable.empty ())
+  if (m_axisEventHandler.empty () && m_programEventHandler.empty ())
     {
-      try
+      return;
+    }
+
+  auto & l_previous (m_eventSample[symbol]);
+
+  if (l_previous.size () == cbData)
+    {
+      auto const l_onAxisEvent ([this] (int axis, EAxisEvent axisEvent)
+                                {
+                                  for (auto&& l_axisEventHandler : m_axisEventHandler)
+                                    {
+                                      l_axisEventHandler (axis, axisEvent);
+                                    }
+                                });
+
+      auto const l_onProgramEvent ([this] (int identifier, EProgramEvent programEvent, DWORD programStatus)
+                                   {
+                                     for (auto&& l_programEventHandler : m_programEventHandler)
+                                       {
+                                         l_programEventHandler (identifier, programEvent, programStatus);
+                                       }
+                                   });
+
+      switch (symbol)
         {
-          m_twinCATADS[static_cast <int> (adsInstance)]->RegisterNotification (GetSymbolName (adsInstance, identifier),
-                                                                               variable.size () * sizeof (T),
-                                                                               pNoteFunc,
-                                                                               this);
+          case VAR_MOTIONCOMPLETE:
+          case VAR_MOTIONSTOPPED:
+          case VAR_MOTIONFAULTED:
+            {
+              auto const l_axisEvent ((symbol == VAR_MOTIONCOMPLETE) ? EAxisEvent::MotionComplete :
+                                      (symbol == VAR_MOTIONSTOPPED)  ? EAxisEvent::MotionStopped : EAxisEvent::MotionFaulted);
+
+              DispatchEvents <MC_Bool> (l_previous, pData, cbData, [&] (int axis, MC_Bool previous, MC_Bool current)
+                                        {
+                                          if (!previous && current)
+                                            {
+                                              l_onAxisEvent (axis, l_axisEvent);
+                                            }
+                                        });
+            }
+            break;
+
+          case VAR_ACTUALPOSITION:
+            DispatchEvents <MC_LReal> (l_previous, pData, cbData, [&] (int axis, MC_LReal previous, MC_LReal current)
+                                       {
+                                         double const l_positionThreshold (m_positionThreshold[axis]);
+
+                                         // comparisons with NaN (no threshold) are all false...
+
+                                         if (((previous < l_positionThreshold) && (current >= l_positionThreshold)) ||
+                                             ((previous > l_positionThreshold) && (current <= l_positionThreshold)))
+                                           {
+                                             l_onAxisEvent (axis, EAxisEvent::PositionCrossed);
+                                           }
+                                       });
+            break;
+
+          case VAR_PROGRAMCOMPLETE:
+            DispatchEvents <MC_Bool> (l_previous, pData, cbData, [&] (int identifier, MC_Bool previous, MC_Bool current)
+                                      {
+                                        if (!previous && current)
+                                          {
+                                            l_onProgramEvent (identifier, EProgramEvent::ProgramComplete, PROGRAM_NO_FAULT);
+                                          }
+                                      });
+            break;
+
+          case VAR_PROGRAMSTATUS:
+            DispatchEvents <MC_UDInt> (l_previous, pData, cbData, [&] (int identifier, MC_UDInt previous, MC_UDInt current)
+                                       {
+                                         if (previous != current)
+                                           {
+                                             l_onProgramEvent (identifier, EProgramEvent::StatusChanged, current);
+                                           }
+                                       });
+            break;
+
+          default:
+            break;
         }
-      catch (CString const & errorMessage)
+    }
+
+  if (symbol == VAR_CONTROLLERSTATUS)
+    {
+      // split the structure into its variables, in the order documented in TwinCATADS.h...
+
+      std::array <std::tuple <ESymbol, size_t>, 8> const l_layout
+      {{
+        { VAR_ACTUALPOSITION,  m_actualPosition.size ()  * sizeof (MC_LReal) },
+        { VAR_ACTUALVELOCITY,  m_actualVelocity.size ()  * sizeof (MC_LReal) },
+        { VAR_FAULTCODE,       m_faultCode.size ()       * sizeof (MC_UDInt) },
+        { VAR_PROGRAMSTATUS,   m_programStatus.size ()   * sizeof (MC_UDInt) },
+        { VAR_MOTIONCOMPLETE,  m_motionComplete.size ()  * sizeof (MC_Bool)  },
+        { VAR_MOTIONSTOPPED,   m_motionStopped.size ()   * sizeof (MC_Bool)  },
+        { VAR_MOTIONFAULTED,   m_motionFaulted.size ()   * sizeof (MC_Bool)  },
+        { VAR_PROGRAMCOMPLETE, m_programComplete.size () * sizeof (MC_Bool)  }
+      }};
+
+      for (auto&& l_variable : l_layout)
         {
-          m_errorMessage = errorMessage;
+          DispatchEvents (std::get <0> (l_variable), pData, std::get <1> (l_variable));
 
-          return false;
+          pData += std::get <1> (l_variable);
         }
     }
-
-  return true;
+  else
+    {
+      l_previous.assign (pData, pData + cbData);
+    }
 }
 
-template <typename T> bool
-CTwinCATADS::SetVariable_ (EADSInstance adsInstance, CString const & identifier, std::vector <T> & value, int index, T value_)
+template <typename T, typename F> void
+CTwinCATADS::DispatchEvents (std::vector <MC_Byte> const & previous, MC_Byte const * pData, size_t cbData, F && onElement)
 {
-  value[index] = value_;
+  for (size_t l_i (0); (l_i + 1) * sizeof (T) <= cbData; ++l_i)
+    {
+      T l_previous;
+      T l_current;
 
-  return SetVariable_ (adsInstance, identifier, value);
+      ::memcpy_s (&l_previous, sizeof (l_previous), &previous[l_i * sizeof (T)], sizeof (T));
+      ::memcpy_s (&l_current, sizeof (l_current), pData + l_i * sizeof (T), sizeof (T));
+
+      onElement (static_cast <int> (l_i), l_previous, l_current);
+    }
 }
 
-template <typename T> bool
-CTwinCATADS::SetVariable_ (EADSInstance adsInstance, CString const & identifier, T const & value)
+void
+CTwinCATADS::AddSymbols (EADSInstance adsInstance)
 {
   if (static_cast <size_t> (adsInstance) < m_twinCATADS.size ())
     {
-      try
+      auto const & l_twinCATADS (m_twinCATADS[static_cast <int> (adsInstance)]);
+
+      std::vector <int> l_symbols;
+      std::vector <int> l_setpoints;
+
+      for (int l_symbol (0); l_symbol < NUM_SYMBOLS; ++l_symbol)
         {
-          m_twinCATADS[static_cast <int> (adsInstance)]->SetVariable (GetSymbolName (adsInstance, identifier), sizeof (T), &value);
+          if ((std::get <0> (m_symbolIdentifier[l_symbol]) == adsInstance) && IsSymbolUsed (l_symbol))
+            {
+              l_symbols.push_back (m_symbol[l_symbol] = l_twinCATADS->AddSymbol (m_symbolName[l_symbol]));
+
+              if (IsSetpoint (l_symbol))
+                {
+                  l_setpoints.push_back (m_symbol[l_symbol]);
+                }
+            }
         }
-      catch (CString const & errorMessage)
-        {
-          m_errorMessage = errorMessage;
 
-          return false;
+      // only the setpoints are written by address, the handshakes that act on them are written by
+      // handle. A write by address to a symbol that moved succeeds, into whatever now occupies the
+      // memory, until the online change is reported; the handshake that follows fails on its stale
+      // handle and rebinds, so a moved setpoint is never acted on, but the write that landed in the
+      // old place is not undone...
+
+      l_twinCATADS->GetHandles (l_symbols);
+      l_twinCATADS->ResolveAddresses (l_setpoints);
+
+      // watch the symbol version to detect a later online change, only the PLC runtime has one...
+
+      if (adsInstance == EADSInstance::PLC)
+        {
+          l_twinCATADS->WatchSymbolVersion ();
         }
     }
+}
 
-  return true;
+bool
+CTwinCATADS::IsSetpoint (int symbol)
+{
+  switch (symbol)
+    {
+      case VAR_ACCELERATION:
+      case VAR_DECELERATION:
+      case VAR_JERK:
+      case VAR_POSITION:
+      case VAR_VELOCITY:
+      case VAR_DIRECTION:
+      case VAR_SEGMENTBUFFER:
+      case VAR_ANALOGOUTPUTS:
+      case VAR_DISCRETEOUTPUTS: return true;
+      default:                  return false;
+    }
 }
 
-template <typename T> bool
-CTwinCATADS::SetVariable_ (EADSInstance adsInstance, CString const & identifier, std::vector <T> const & value)
+bool
+CTwinCATADS::IsSymbolUsed (int symbol) const
 {
-  if (static_cast <size_t> (adsInstance) < m_twinCATADS.size ())
+  // the controller status structure and the segment queue are optional, only look for them when they are used...
+
+  switch (symbol)
     {
-      try
+      case VAR_CONTROLLERSTATUS: return m_statusMode == EStatusMode::Aggregated;
+      case VAR_SEGMENTBUFFER:
+      case VAR_SEGMENTWRITTEN:
+      case VAR_SEGMENTREAD:      return m_isSegmentQueue;
+      default:                   return true;
+    }
+}
+
+void
+CTwinCATADS::CheckSymbolVersion (void)
+{
+  // the PLC reports an online change by notification, which stops writes by address at once and
+  // rebinds here; a target that cannot notify is polled at a low rate instead; a stale handle found
+  // by a write rebinds immediately; the I/O ports are task images without a symbol version, a stale
+  // I/O handle is found by its write...
+
+  for (auto&& l_twinCATADS : m_twinCATADS)
+    {
+      // a connection that lost its target asks to be rebound once it is back...
+
+      if (l_twinCATADS->IsRebindPending ())
         {
-          m_twinCATADS[static_cast <int> (adsInstance)]->SetVariable (GetSymbolName (adsInstance, identifier), value.size () * sizeof (T), &value[0]);
+          if (auto const l_errorMessage (l_twinCATADS->Rebind ()); !l_errorMessage.IsEmpty ())
+            {
+              PDCLib::Trace (_T ("%s"), (LPCTSTR) l_errorMessage);
+            }
         }
-      catch (CString const & errorMessage)
-        {
-          m_errorMessage = errorMessage;
+    }
 
-          return false;
+  if (auto const l_tick (PDCLib::GetTickCount ()); (l_tick - m_symbolVersionTick) >= SYMBOL_VERSION_INTERVAL)
+    {
+      m_symbolVersionTick = l_tick;
+
+      if (static_cast <size_t> (EADSInstance::PLC) < m_twinCATADS.size ())
+        {
+          m_twinCATADS[static_cast <int> (EADSInstance::PLC)]->CheckSymbolVersion ();
         }
     }
 
-  return true;
+  CheckRebindCount ();
 }
 
-template <typename T> void
-CTwinCATADS::CopyVariable (AdsNotificationHeader * pNotification, std::vector <T> & variable)
+void
+CTwinCATADS::CheckRebindCount (void)
 {
-  std::unique_lock <std::mutex> l_notificationGate { m_notificationGate };
+  // a connection may be rebound by another controller that shares it, or by a write that found a
+  // stale handle, its count tells this controller that the written values are no longer known...
 
-  if (pNotification->cbSampleSize == (variable.size () * sizeof (T)))
+  m_rebindCount.resize (m_twinCATADS.size (), 0);
+
+  bool l_isRebound (false);
+
+  for (size_t l_i (0); l_i < m_twinCATADS.size (); ++l_i)
+    {
+      if (auto const l_rebindCount (m_twinCATADS[l_i]->GetRebindCount ()); l_rebindCount != m_rebindCount[l_i])
+        {
+          m_rebindCount[l_i] = l_rebindCount;
+
+          l_isRebound = true;
+        }
+    }
+
+  if (l_isRebound)
     {
-      auto const l_pData (reinterpret_cast <T const *> (ADSNOTIFICATION_PDATA (pNotification)));
+      ClrWrittenValues ();
+    }
+}
 
-      std::copy (l_pData, l_pData + variable.size (), variable.begin ());
+void
+CTwinCATADS::ClrWrittenValues (void)
+{
+  // after an online change the PLC may no longer hold what was written, every setpoint is written again...
+
+  for (auto&& l_writtenValue : m_writtenValue)
+    {
+      l_writtenValue.clear ();
     }
 }
 
@@ -2036,5 +7497,45 @@ CTwinCATADS::GetSymbolName (EADSInstance adsInstance, CString const & identifier
 //  08/24/2018  MCC     updated TwinCAT ADS error message map
 //  08/24/2018  MCC     made TwinCAT ADS controller identifier constant
 //  10/24/2018  MCC     updated TwinCAT ADS program status message table
+//  10/17/2026  AGT     implemented TwinCAT ADS write combining mode
+//  10/17/2026  AGT     acquire TwinCAT ADS symbol handles with one sum request
+//  10/17/2026  AGT     register and delete TwinCAT ADS notifications with sum requests
+//  10/17/2026  AGT     serialize TwinCAT ADS requests per client port instead of per process
+//  10/17/2026  AGT     implemented TwinCAT ADS asynchronous write mode
+//  10/17/2026  AGT     intern TwinCAT ADS symbols in an indexed table
+//  10/17/2026  AGT     rebind TwinCAT ADS symbols after a PLC online change
+//  10/17/2026  AGT     added native AMS/TCP TwinCAT ADS backend
+//  10/17/2026  AGT     added in-process virtual PLC TwinCAT ADS backend
+//  10/17/2026  AGT     implemented per-variable TwinCAT ADS notification rates
+//  10/17/2026  AGT     implemented wait-free TwinCAT ADS notification ingestion
+//  10/17/2026  AGT     added aggregated TwinCAT ADS controller status notification
+//  10/17/2026  AGT     report the axes and programs changed by UpdateInputs
+//  10/17/2026  AGT     added notification driven motion and program completion waits
+//  10/17/2026  AGT     added axis and program event subscriptions
+//  10/17/2026  AGT     keep PLC time stamps and record TwinCAT ADS notification latency
+//  10/17/2026  AGT     share TwinCAT ADS connections between controllers on one port
+//  10/17/2026  AGT     added asynchronous TwinCAT ADS creation with progress
+//  10/17/2026  AGT     added compile-time sized TwinCAT ADS controller
+//  10/17/2026  AGT     evaluate TwinCAT ADS handshakes sixteen axes at a time
+//  10/17/2026  AGT     added synchronized multi-axis motion start
+//  10/17/2026  AGT     added host-queued motion segment streaming
+//  10/17/2026  AGT     skip unchanged setpoints and write single elements by address
+//  10/17/2026  AGT     write symbols by index group and offset, merging adjacent ranges
+//  10/17/2026  AGT     report TwinCAT ADS rebind failures and poll the PLC symbol version only
+//  10/17/2026  AGT     reconnect the AMS/TCP backend and cap its orphaned notification samples
+//  10/17/2026  AGT     stop writes by address as soon as the PLC notifies a symbol version change
+//  10/17/2026  AGT     forget written setpoints on any rebind of a shared connection, record queued ones once written
+//  10/17/2026  AGT     keep the written setpoints current on whole array and program variable writes
+//  10/17/2026  AGT     wait for callbacks in flight when a controller unregisters, drop expired pooled connections
+//  10/17/2026  AGT     pace the virtual PLC on the steady clock and answer the motion and program handshakes
+//  10/17/2026  AGT     write only the new motion segment slots, range check the queued segment axis
+//  10/17/2026  AGT     validate notification rates, restore the status rate as the default for every variable
+//  10/17/2026  AGT     clear the motion fault of a new request in every triple buffer slot
+//  10/17/2026  AGT     dispatch axis and program events after the triple buffer publisher gate is left
+//  10/17/2026  AGT     share one AMS/TCP connection per target, run notification callbacks off the receiver thread
+//  10/17/2026  AGT     a synchronized move takes its axes out of jog mode
+//  10/17/2026  AGT     read the symbol addresses with one sum request at create and rebind, never on a write
+//  10/17/2026  AGT     write only the setpoint arrays by address, the handshakes by handle
+//  10/17/2026  AGT     fall back to the process wide TwinCAT 2 interface when the router DLL has no Ex exports
 //
 // ============================================================================
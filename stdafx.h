@@ -75,17 +75,30 @@
 #undef max                     // undefine macro version of max function
 #endif
 
+#include <afxsock.h>           // MFC socket extensions
+#include <ws2tcpip.h>          // Windows Sockets TCP/IP extensions (for getaddrinfo)
+
 #include <comdef.h>            // Native C++ compiler COM support - main definitions header
 #include <msxml6.h>            // XML serialization support
 
+#include <emmintrin.h>         // SSE2 intrinsics (for the handshake masks)
+
 #include <algorithm>           // STL algorithms (for min and max template functions)
 #include <array>               // STL array support
 #include <atomic>              // STL atomic support
+#include <chrono>              // STL time utilities (for steady_clock)
+#include <condition_variable>  // STL condition variable support
+#include <deque>               // STL double-ended queue support
+#include <functional>          // STL function objects (for event handlers)
+#include <future>              // STL future and promise support
 #include <limits>              // STL limits (for numeric_limits)
 #include <map>                 // STL map container class support
 #include <memory>              // STL memory management
 #include <mutex>               // STL mutex support
+#include <random>              // STL random number generation (for virtual PLC jitter)
 #include <set>                 // STL set container class support
+#include <string>              // STL string support
+#include <thread>              // STL thread support (for sleep_for)
 #include <vector>              // STL vector container class support
 
 #include <strsafe.h>           // Safer C library string routine replacements
@@ -119,6 +132,13 @@
 //  12/17/2014  MCC     implemented critical sections with C++11 concurrency
 //  01/09/2015  MCC     templatized number of elements macro
 //  08/22/2018  MCC     corrected problem with TwinCAT ADS variable names
+//  10/17/2026  AGT     added STL condition variable and future support
+//  10/17/2026  AGT     added Windows Sockets support
+//  10/17/2026  AGT     added STL random, string and thread support
+//  10/17/2026  AGT     added STL time utilities
+//  10/17/2026  AGT     added STL function object support
+//  10/17/2026  AGT     added SSE2 intrinsics support
+//  10/17/2026  AGT     added STL double-ended queue support
 //
 // ============================================================================
 
@@ -0,0 +1,837 @@
+// ============================================================================
+//
+//                              CONFIDENTIAL
+//
+//        GENOMICS INSTITUTE OF THE NOVARTIS RESEARCH FOUNDATION (GNF)
+//
+//  This is an unpublished work of authorship, which contains trade secrets,
+//  created in 2026.  GNF owns all rights to this work and intends to maintain
+//  it in confidence to preserve its trade secret status.  GNF reserves the
+//  right, under the copyright laws of the United States or those of any other
+//  country that may have jurisdiction, to protect this work as an unpublished
+//  work, in the event of an inadvertent or deliberate unauthorized publication.
+//  GNF also reserves its rights under all copyright laws to protect this work
+//  as a published work, when appropriate.  Those having access to this work
+//  may not copy it, use it, modify it or disclose the information contained
+//  in it without the written authorization of GNF.
+//
+// ============================================================================
+
+// ============================================================================
+//
+//            Name: TwinCATLoopback.cpp
+//
+//     Description: TwinCAT DLL AMS/TCP backend loopback test
+//
+//          Author: agent
+//
+// ============================================================================
+
+// ============================================================================
+//
+//      %subsystem: 1 %
+//           %name: twincatloopback.cpp %
+//        %version: 1 %
+//          %state: %
+//         %cvtype: c++ %
+//     %derived_by: agent %
+//  %date_modified: %
+//
+// ============================================================================
+
+#include "StdAfx.h"
+#include "TwinCATADS.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+// the AMS/TCP backend is run against a stand-in target on the loopback interface, one line per
+// check is written to stdout and the exit code is the number of checks that failed:
+//
+//   PASS: <check>
+//   FAIL: <check>
+//
+// no TwinCAT installation or router is needed, the stand-in answers the requests the backend
+// sends (it is not a TwinCAT emulation, just enough of the protocol for the backend)...
+
+namespace
+{
+  CWinApp g_twinCATLoopback;
+
+  int   const NUM_AXES         (2);
+  DWORD const WAIT_TIMEOUT_    (10000);  // milliseconds a check waits for the backend
+  ULONG const NUM_ORPHANS      (10000);  // samples sent for handles that were never added
+  WORD  const AIO_PORT         (350);
+  WORD  const DIO_PORT         (351);
+
+  int g_failures (0);
+
+  void
+  Check (bool condition, LPCTSTR description)
+  {
+    _ftprintf (stdout, _T ("%s: %s\n"), condition ? _T ("PASS") : _T ("FAIL"), description);
+
+    ::fflush (stdout);
+
+    if (!condition)
+      {
+        ++g_failures;
+      }
+  }
+
+  template <typename F> bool
+  WaitFor (F && condition)
+  {
+    auto const l_start (PDCLib::GetTickCount ());
+
+    while (!condition ())
+      {
+        if (PDCLib::GetTickCount () - l_start >= WAIT_TIMEOUT_)
+          {
+            return false;
+          }
+
+        PDCLib::Sleep (1);
+      }
+
+    return true;
+  }
+
+  // stand-in for a TwinCAT target; every symbol name resolves (the variable is created the first
+  // time it is asked for) and the variables outlive a connection the way PLC memory does, while
+  // the notifications end with the connection that added them...
+
+  class CLoopbackTarget final
+  {
+  public:
+    explicit CLoopbackTarget (void);
+    ~CLoopbackTarget ();
+
+    WORD GetPort (void) const { return m_port; }
+    int  GetConnectionCount (void) const { return m_connectionCount; }
+
+    double GetValue (CString const & identifier, size_t index);
+    void   SetValue (CString const & identifier, size_t index, double value); // the subscribers are notified
+    void   SendOrphanSamples (ULONG count);                                   // samples for handles nobody added
+    void   Drop (void);                                                       // closes the connection as a lost link would
+
+  private:
+    enum : WORD
+    {
+      ADSCMD_READ                  = 0x0002,
+      ADSCMD_WRITE                 = 0x0003,
+      ADSCMD_ADDDEVICENOTIFICATION = 0x0006,
+      ADSCMD_DELDEVICENOTIFICATION = 0x0007,
+      ADSCMD_DEVICENOTIFICATION    = 0x0008,
+      ADSCMD_READWRITE             = 0x0009
+    };
+
+    enum : WORD
+    {
+      AMS_STATE_RESPONSE   = 0x0001,
+      AMS_STATE_ADSCOMMAND = 0x0004
+    };
+
+#pragma pack (push, 1)
+    struct SAmsTcpHeader
+    {
+      WORD  reserved;
+      ULONG length;
+    };
+
+    struct SAmsHeader
+    {
+      AmsAddr target;
+      AmsAddr source;
+      WORD    commandId;
+      WORD    stateFlags;
+      ULONG   length;
+      ULONG   errorCode;
+      ULONG   invokeId;
+    };
+
+    struct SAdsReadReq
+    {
+      ULONG indexGroup;
+      ULONG indexOffset;
+      ULONG length;
+    };
+
+    struct SAdsReadWriteReq
+    {
+      ULONG indexGroup;
+      ULONG indexOffset;
+      ULONG readLength;
+      ULONG writeLength;
+    };
+
+    struct SAdsAddDeviceNotificationReq
+    {
+      ULONG indexGroup;
+      ULONG indexOffset;
+      ULONG length;
+      ULONG transMode;
+      ULONG maxDelay;
+      ULONG cycleTime;
+      BYTE  reserved[16];
+    };
+#pragma pack (pop)
+
+    void Run (void);
+    void Close (void);
+    void Receive (SAmsHeader const & amsHeader, BYTE const * pData);
+
+    ULONG Read (ULONG indexGroup, ULONG indexOffset, ULONG length, std::vector <BYTE> & data);
+    ULONG Write (ULONG indexGroup, ULONG indexOffset, BYTE const * pData, ULONG cbData);
+    ULONG ReadWrite (ULONG indexGroup, ULONG indexOffset, ULONG readLength, BYTE const * pData, ULONG cbData, std::vector <BYTE> & data);
+
+    ULONG GetHandle (CString const & identifier); // m_gate must be held
+    void  Notify (ULONG hNotification);           // m_gate must be held
+    void  Send (AmsAddr const & target, AmsAddr const & source, WORD commandId, WORD stateFlags, ULONG invokeId, std::vector <BYTE> const & data);
+
+    template <typename T> static void Append (std::vector <BYTE> & data, T const & value);
+
+    static bool Wait (SOCKET socket, long timeout);
+
+    SOCKET                                m_listen;
+    SOCKET                                m_client;
+    WORD                                  m_port;
+    std::thread                           m_thread;
+    std::atomic_bool                      m_isStopping;
+    std::vector <BYTE>                    m_received;
+    std::mutex                            m_gate;
+    std::map <CString, ULONG>             m_handle;
+    std::vector <std::vector <BYTE>>      m_variable;
+    std::map <ULONG, std::tuple <ULONG, ULONG, AmsAddr, AmsAddr>> m_notification; // handle -> {variable handle, length, client, target}
+    ULONG                                 m_hNotification;
+    std::atomic_int                       m_connectionCount;
+    AmsAddr                               m_clientAddr;
+    AmsAddr                               m_targetAddr;
+
+  public:
+    CLoopbackTarget (CLoopbackTarget const &) = delete;
+    CLoopbackTarget & operator = (CLoopbackTarget const &) = delete;
+  };
+
+  CLoopbackTarget::CLoopbackTarget (void)
+    : m_listen          (INVALID_SOCKET)
+    , m_client          (INVALID_SOCKET)
+    , m_port            (0)
+    , m_isStopping      (false)
+    , m_hNotification   (0)
+    , m_connectionCount (0)
+    , m_clientAddr      {}
+    , m_targetAddr      {}
+  {
+    WSADATA l_wsaData;
+
+    if (auto const l_error (::WSAStartup (MAKEWORD (2, 2), &l_wsaData)); l_error != 0)
+      {
+        PDCLib::ThrowStringException (_T ("unable to start Windows Sockets; %s"), (LPCTSTR) PDCLib::GetErrorMessage (l_error));
+      }
+
+    sockaddr_in l_address {};
+
+    l_address.sin_family      = AF_INET;
+    l_address.sin_addr.s_addr = ::htonl (INADDR_LOOPBACK);
+    l_address.sin_port        = 0;
+
+    int l_cbAddress (sizeof (l_address));
+
+    if (((m_listen = ::socket (AF_INET, SOCK_STREAM, IPPROTO_TCP)) == INVALID_SOCKET) ||
+        (::bind (m_listen, reinterpret_cast <sockaddr const *> (&l_address), sizeof (l_address)) == SOCKET_ERROR) ||
+        (::listen (m_listen, 1) == SOCKET_ERROR) ||
+        (::getsockname (m_listen, reinterpret_cast <sockaddr *> (&l_address), &l_cbAddress) == SOCKET_ERROR))
+      {
+        auto const l_error (::WSAGetLastError ());
+
+        if (m_listen != INVALID_SOCKET)
+          {
+            ::closesocket (m_listen);
+          }
+
+        ::WSACleanup ();
+
+        PDCLib::ThrowStringException (_T ("unable to listen on the loopback interface; %s"), (LPCTSTR) PDCLib::GetErrorMessage (l_error));
+      }
+
+    m_port = ::ntohs (l_address.sin_port);
+
+    m_thread = std::thread ([this] { Run (); });
+  }
+
+  CLoopbackTarget::~CLoopbackTarget ()
+  {
+    m_isStopping = true;
+
+    m_thread.join ();
+
+    Close ();
+
+    ::closesocket (m_listen);
+
+    ::WSACleanup ();
+  }
+
+  double
+  CLoopbackTarget::GetValue (CString const & identifier, size_t index)
+  {
+    std::unique_lock <std::mutex> l_gate { m_gate };
+
+    auto const & l_variable (m_variable[GetHandle (identifier)]);
+
+    double l_value (0.0);
+
+    if (l_variable.size () >= (index + 1) * sizeof (l_value))
+      {
+        ::memcpy_s (&l_value, sizeof (l_value), &l_variable[index * sizeof (l_value)], sizeof (l_value));
+      }
+
+    return l_value;
+  }
+
+  void
+  CLoopbackTarget::SetValue (CString const & identifier, size_t index, double value)
+  {
+    std::unique_lock <std::mutex> l_gate { m_gate };
+
+    auto const l_handle (GetHandle (identifier));
+
+    auto & l_variable (m_variable[l_handle]);
+
+    if (l_variable.size () < (index + 1) * sizeof (value))
+      {
+        l_variable.resize ((index + 1) * sizeof (value));
+      }
+
+    ::memcpy_s (&l_variable[index * sizeof (value)], l_variable.size () - index * sizeof (value), &value, sizeof (value));
+
+    for (auto const & l_notification : m_notification)
+      {
+        if (std::get <0> (std::get <1> (l_notification)) == l_handle)
+          {
+            Notify (std::get <0> (l_notification));
+          }
+      }
+  }
+
+  void
+  CLoopbackTarget::SendOrphanSamples (ULONG count)
+  {
+    std::unique_lock <std::mutex> l_gate { m_gate };
+
+    for (ULONG l_i (0); l_i < count; ++l_i)
+      {
+        // handles well above any the target hands out, a sample each...
+
+        std::vector <BYTE> l_data;
+
+        Append <ULONG> (l_data, 4 + sizeof (LONGLONG) + 3 * sizeof (ULONG) + sizeof (double)); // stamps, stamp header and one sample
+        Append <ULONG> (l_data, 1);
+        Append <LONGLONG> (l_data, 0);
+        Append <ULONG> (l_data, 1);
+        Append <ULONG> (l_data, 0x10000000 + l_i);
+        Append <ULONG> (l_data, sizeof (double));
+        Append <double> (l_data, 0.0);
+
+        Send (m_clientAddr, m_targetAddr, ADSCMD_DEVICENOTIFICATION, AMS_STATE_ADSCOMMAND, 0, l_data);
+      }
+  }
+
+  void
+  CLoopbackTarget::Drop (void)
+  {
+    // the connection is shut down here and closed by the receive side when it sees the end of it,
+    // nothing more reaches the backend on it after this returns...
+
+    std::unique_lock <std::mutex> l_gate { m_gate };
+
+    if (m_client != INVALID_SOCKET)
+      {
+        ::shutdown (m_client, SD_BOTH);
+      }
+
+    m_notification.clear ();
+  }
+
+  void
+  CLoopbackTarget::Run (void)
+  {
+    while (!m_isStopping)
+      {
+        if (m_client == INVALID_SOCKET)
+          {
+            if (Wait (m_listen, 10))
+              {
+                auto const l_client (::accept (m_listen, nullptr, nullptr));
+
+                int l_noDelay (1);
+
+                ::setsockopt (l_client, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast <char const *> (&l_noDelay), sizeof (l_noDelay));
+
+                std::unique_lock <std::mutex> l_gate { m_gate };
+
+                m_client = l_client;
+
+                m_received.clear ();
+
+                ++m_connectionCount;
+              }
+
+            continue;
+          }
+
+        if (!Wait (m_client, 10))
+          {
+            continue;
+          }
+
+        char l_buffer[4096];
+
+        auto const l_cbReceived (::recv (m_client, l_buffer, sizeof (l_buffer), 0));
+
+        if (l_cbReceived <= 0)
+          {
+            Close ();
+
+            continue;
+          }
+
+        m_received.insert (m_received.end (), l_buffer, l_buffer + l_cbReceived);
+
+        // take every complete frame, a partial one waits for the rest...
+
+        size_t l_pos (0);
+
+        while (m_received.size () - l_pos >= sizeof (SAmsTcpHeader) + sizeof (SAmsHeader))
+          {
+            auto const l_amsTcpHeader (reinterpret_cast <SAmsTcpHeader const *> (&m_received[l_pos]));
+
+            if (m_received.size () - l_pos < sizeof (SAmsTcpHeader) + l_amsTcpHeader->length)
+              {
+                break;
+              }
+
+            auto const l_amsHeader (reinterpret_cast <SAmsHeader const *> (&m_received[l_pos + sizeof (SAmsTcpHeader)]));
+
+            Receive (*l_amsHeader, &m_received[l_pos + sizeof (SAmsTcpHeader) + sizeof (SAmsHeader)]);
+
+            l_pos += sizeof (SAmsTcpHeader) + l_amsTcpHeader->length;
+          }
+
+        m_received.erase (m_received.begin (), m_received.begin () + l_pos);
+      }
+  }
+
+  void
+  CLoopbackTarget::Close (void)
+  {
+    std::unique_lock <std::mutex> l_gate { m_gate };
+
+    if (m_client != INVALID_SOCKET)
+      {
+        ::closesocket (m_client);
+
+        m_client = INVALID_SOCKET;
+      }
+
+    m_notification.clear ();
+  }
+
+  void
+  CLoopbackTarget::Receive (SAmsHeader const & amsHeader, BYTE const * pData)
+  {
+    std::unique_lock <std::mutex> l_gate { m_gate };
+
+    m_clientAddr = amsHeader.source;
+    m_targetAddr = amsHeader.target;
+
+    std::vector <BYTE> l_response;
+    std::vector <BYTE> l_data;
+
+    ULONG l_hNotification (0);
+
+    switch (amsHeader.commandId)
+      {
+        case ADSCMD_READ:
+          {
+            auto const l_request (reinterpret_cast <SAdsReadReq const *> (pData));
+
+            Append <ULONG> (l_response, Read (l_request->indexGroup, l_request->indexOffset, l_request->length, l_data));
+            Append <ULONG> (l_response, static_cast <ULONG> (l_data.size ()));
+
+            break;
+          }
+
+        case ADSCMD_WRITE:
+          {
+            auto const l_request (reinterpret_cast <SAdsReadReq const *> (pData));
+
+            Append <ULONG> (l_response, Write (l_request->indexGroup, l_request->indexOffset, pData + sizeof (SAdsReadReq), l_request->length));
+
+            break;
+          }
+
+        case ADSCMD_READWRITE:
+          {
+            auto const l_request (reinterpret_cast <SAdsReadWriteReq const *> (pData));
+
+            Append <ULONG> (l_response, ReadWrite (l_request->indexGroup, l_request->indexOffset, l_request->readLength, pData + sizeof (SAdsReadWriteReq), l_request->writeLength, l_data));
+            Append <ULONG> (l_response, static_cast <ULONG> (l_data.size ()));
+
+            break;
+          }
+
+        case ADSCMD_ADDDEVICENOTIFICATION:
+          {
+            auto const l_request (reinterpret_cast <SAdsAddDeviceNotificationReq const *> (pData));
+
+            if ((l_request->indexGroup != ADSIGRP_SYM_VALBYHND) || (l_request->indexOffset >= m_variable.size ()))
+              {
+                Append <ULONG> (l_response, ADSERR_DEVICE_SYMBOLNOTFOUND);
+                Append <ULONG> (l_response, 0);
+              }
+            else
+              {
+                auto & l_variable (m_variable[l_request->indexOffset]);
+
+                if (l_variable.size () < l_request->length)
+                  {
+                    l_variable.resize (l_request->length);
+                  }
+
+                l_hNotification = ++m_hNotification;
+
+                m_notification[l_hNotification] = std::make_tuple (l_request->indexOffset, l_request->length, amsHeader.source, amsHeader.target);
+
+                Append <ULONG> (l_response, ADSERR_NOERR);
+                Append <ULONG> (l_response, l_hNotification);
+              }
+
+            break;
+          }
+
+        case ADSCMD_DELDEVICENOTIFICATION:
+          {
+            Append <ULONG> (l_response, (m_notification.erase (*reinterpret_cast <ULONG const *> (pData)) != 0) ? ADSERR_NOERR : ADSERR_DEVICE_NOTIFYHNDINVALID);
+
+            break;
+          }
+
+        default:
+          {
+            Append <ULONG> (l_response, ADSERR_DEVICE_SRVNOTSUPP);
+
+            break;
+          }
+      }
+
+    l_response.insert (l_response.end (), l_data.begin (), l_data.end ());
+
+    // the first sample goes out ahead of the response, as a busy target may send it, so the backend
+    // has to hold it until it knows the callback...
+
+    if (l_hNotification != 0)
+      {
+        Notify (l_hNotification);
+      }
+
+    Send (amsHeader.source, amsHeader.target, amsHeader.commandId, AMS_STATE_ADSCOMMAND | AMS_STATE_RESPONSE, amsHeader.invokeId, l_response);
+  }
+
+  ULONG
+  CLoopbackTarget::Read (ULONG indexGroup, ULONG indexOffset, ULONG length, std::vector <BYTE> & data)
+  {
+    switch (indexGroup)
+      {
+        case ADSIGRP_SYM_VERSION:
+          {
+            data.assign (1, 1);
+
+            return ADSERR_NOERR;
+          }
+
+        case ADSIGRP_SYM_VALBYHND:
+          {
+            if (indexOffset >= m_variable.size ())
+              {
+                return ADSERR_DEVICE_SYMBOLNOTFOUND;
+              }
+
+            auto const & l_variable (m_variable[indexOffset]);
+
+            data.assign (l_variable.begin (), l_variable.begin () + std::min (static_cast <size_t> (length), l_variable.size ()));
+
+            return ADSERR_NOERR;
+          }
+      }
+
+    return ADSERR_DEVICE_INVALIDGRP;
+  }
+
+  ULONG
+  CLoopbackTarget::Write (ULONG indexGroup, ULONG indexOffset, BYTE const * pData, ULONG cbData)
+  {
+    switch (indexGroup)
+      {
+        case ADSIGRP_SYM_VALBYHND:
+          {
+            if (indexOffset >= m_variable.size ())
+              {
+                return ADSERR_DEVICE_SYMBOLNOTFOUND;
+              }
+
+            m_variable[indexOffset].assign (pData, pData + cbData);
+
+            return ADSERR_NOERR;
+          }
+
+        case ADSIGRP_SYM_RELEASEHND:
+          {
+            return ADSERR_NOERR;
+          }
+      }
+
+    return ADSERR_DEVICE_INVALIDGRP;
+  }
+
+  ULONG
+  CLoopbackTarget::ReadWrite (ULONG indexGroup, ULONG indexOffset, ULONG readLength, BYTE const * pData, ULONG cbData, std::vector <BYTE> & data)
+  {
+    switch (indexGroup)
+      {
+        case ADSIGRP_SYM_HNDBYNAME:
+          {
+            CString const l_identifier (CStringA (reinterpret_cast <char const *> (pData), static_cast <int> (strnlen (reinterpret_cast <char const *> (pData), cbData))));
+
+            Append <ULONG> (data, GetHandle (l_identifier));
+
+            return ADSERR_NOERR;
+          }
+
+        case ADSIGRP_SYM_VALBYHND:
+          {
+            return (cbData == 0) ? Read (indexGroup, indexOffset, readLength, data) : ADSERR_DEVICE_SRVNOTSUPP;
+          }
+
+        case ADSIGRP_SUMUP_WRITE:
+          {
+            // {index group, index offset, length} per write followed by the data of each, one result per write...
+
+            auto l_pData (pData + indexOffset * sizeof (SAdsReadReq));
+
+            for (ULONG l_i (0); l_i < indexOffset; ++l_i)
+              {
+                auto const l_request (reinterpret_cast <SAdsReadReq const *> (pData) + l_i);
+
+                Append <ULONG> (data, Write (l_request->indexGroup, l_request->indexOffset, l_pData, l_request->length));
+
+                l_pData += l_request->length;
+              }
+
+            return ADSERR_NOERR;
+          }
+      }
+
+    // the sum read/write, sum notification and symbol information services are not offered, the
+    // backend falls back to the single requests...
+
+    return ADSERR_DEVICE_SRVNOTSUPP;
+  }
+
+  ULONG
+  CLoopbackTarget::GetHandle (CString const & identifier)
+  {
+    // symbols are matched by their last component, the controller prefix is not checked...
+
+    auto const l_identifier (identifier.Mid (identifier.ReverseFind (_T ('.')) + 1));
+
+    if (auto const l_handle (m_handle.find (l_identifier)); l_handle != m_handle.end ())
+      {
+        return std::get <1> (*l_handle);
+      }
+
+    m_variable.emplace_back ();
+
+    return m_handle[l_identifier] = static_cast <ULONG> (m_variable.size () - 1);
+  }
+
+  void
+  CLoopbackTarget::Notify (ULONG hNotification)
+  {
+    auto const & l_notification (m_notification[hNotification]);
+    auto const & l_variable (m_variable[std::get <0> (l_notification)]);
+
+    auto const l_length (std::get <1> (l_notification));
+
+    FILETIME l_fileTime;
+
+    ::GetSystemTimeAsFileTime (&l_fileTime);
+
+    std::vector <BYTE> l_data;
+
+    Append <ULONG> (l_data, static_cast <ULONG> (4 + sizeof (LONGLONG) + 3 * sizeof (ULONG) + l_length));
+    Append <ULONG> (l_data, 1);
+    Append <LONGLONG> (l_data, (static_cast <LONGLONG> (l_fileTime.dwHighDateTime) << 32) | l_fileTime.dwLowDateTime);
+    Append <ULONG> (l_data, 1);
+    Append <ULONG> (l_data, hNotification);
+    Append <ULONG> (l_data, l_length);
+
+    l_data.insert (l_data.end (), l_variable.begin (), l_variable.begin () + l_length);
+
+    // the sample goes to the port that added the notification, every port shares the one connection...
+
+    Send (std::get <2> (l_notification), std::get <3> (l_notification), ADSCMD_DEVICENOTIFICATION, AMS_STATE_ADSCOMMAND, 0, l_data);
+  }
+
+  void
+  CLoopbackTarget::Send (AmsAddr const & target, AmsAddr const & source, WORD commandId, WORD stateFlags, ULONG invokeId, std::vector <BYTE> const & data)
+  {
+    if (m_client == INVALID_SOCKET)
+      {
+        return;
+      }
+
+    SAmsHeader const l_amsHeader { target, source, commandId, stateFlags, static_cast <ULONG> (data.size ()), 0, invokeId };
+
+    std::vector <BYTE> l_frame;
+
+    Append (l_frame, SAmsTcpHeader { 0, static_cast <ULONG> (sizeof (SAmsHeader) + data.size ()) });
+    Append (l_frame, l_amsHeader);
+
+    l_frame.insert (l_frame.end (), data.begin (), data.end ());
+
+    // a short send means the client went away, the receive side notices and closes...
+
+    for (size_t l_pos (0); l_pos < l_frame.size (); )
+      {
+        auto const l_cbSent (::send (m_client, reinterpret_cast <char const *> (&l_frame[l_pos]), static_cast <int> (l_frame.size () - l_pos), 0));
+
+        if (l_cbSent <= 0)
+          {
+            break;
+          }
+
+        l_pos += l_cbSent;
+      }
+  }
+
+  template <typename T> void
+  CLoopbackTarget::Append (std::vector <BYTE> & data, T const & value)
+  {
+    auto const l_pValue (reinterpret_cast <BYTE const *> (&value));
+
+    data.insert (data.end (), l_pValue, l_pValue + sizeof (value));
+  }
+
+  bool
+  CLoopbackTarget::Wait (SOCKET socket, long timeout)
+  {
+    fd_set l_fdSet;
+
+    FD_ZERO (&l_fdSet);
+    FD_SET (socket, &l_fdSet);
+
+    timeval l_timeout { 0, timeout * 1000 };
+
+    return ::select (static_cast <int> (socket + 1), &l_fdSet, nullptr, nullptr, &l_timeout) > 0;
+  }
+
+  void
+  TestLoopback (void)
+  {
+    CLoopbackTarget l_target;
+
+    CString l_hostName;
+
+    l_hostName.Format (_T ("127.0.0.1:%u"), static_cast <unsigned int> (l_target.GetPort ()));
+
+    CTwinCATADS l_twinCATADS (0, NUM_AXES, 0, false);
+
+    Check (l_twinCATADS.Create (l_hostName, _T ("127.0.0.1.1.1")), _T ("create over AMS/TCP to host:port"));
+
+    // setpoints reach the target...
+
+    Check (l_twinCATADS.SetPosition (1, 10.0) && (l_target.GetValue (_T ("Position"), 1) == 10.0), _T ("write a setpoint"));
+
+    // samples reach the controller...
+
+    l_target.SetValue (_T ("ActualPosition"), 1, 11.0);
+
+    Check (WaitFor ([&] { l_twinCATADS.UpdateInputs (); return l_twinCATADS.GetPosition (1) == 11.0; }), _T ("receive a notification"));
+
+    // samples for handles nobody added are dropped once the cap is reached and do not disturb the live ones...
+
+    l_target.SendOrphanSamples (NUM_ORPHANS);
+    l_target.SetValue (_T ("ActualPosition"), 1, 12.0);
+
+    Check (WaitFor ([&] { l_twinCATADS.UpdateInputs (); return l_twinCATADS.GetPosition (1) == 12.0; }), _T ("receive a notification after orphaned samples"));
+
+    // the I/O ports of a second controller share the connection of the first, the target accepts
+    // one connection per client and the samples are routed by the port that added them...
+
+    {
+      CTwinCATADS l_twinCATIO (1, NUM_AXES, 0, false);
+
+      Check (l_twinCATIO.Create (l_hostName, _T ("127.0.0.1.1.1"), AIO_PORT, DIO_PORT) && (l_target.GetConnectionCount () == 1), _T ("create the I/O ports over the same connection"));
+    }
+
+    l_target.SetValue (_T ("ActualPosition"), 1, 13.0);
+
+    Check (WaitFor ([&] { l_twinCATADS.UpdateInputs (); return l_twinCATADS.GetPosition (1) == 13.0; }), _T ("receive a notification after other ports were opened"));
+
+    // the link is lost; the backend reconnects, the controller rebinds on its next update and the
+    // notifications are added again...
+
+    l_target.Drop ();
+
+    Check (WaitFor ([&] { l_twinCATADS.UpdateOutputs (); return l_twinCATADS.SetPosition (1, 20.0); }) && (l_target.GetValue (_T ("Position"), 1) == 20.0), _T ("write a setpoint after a reconnect"));
+
+    l_target.SetValue (_T ("ActualPosition"), 1, 21.0);
+
+    Check (WaitFor ([&] { l_twinCATADS.UpdateOutputs (); l_twinCATADS.UpdateInputs (); return l_twinCATADS.GetPosition (1) == 21.0; }), _T ("receive a notification after a reconnect"));
+  }
+}
+
+int
+_tmain (int /* argc */, TCHAR * /* argv */[])
+{
+  if (!::AfxWinInit (::GetModuleHandle (nullptr), nullptr, ::GetCommandLine (), 0))
+    {
+      _ftprintf (stderr, _T ("unable to initialize MFC\n"));
+
+      return 1;
+    }
+
+  try
+    {
+      TestLoopback ();
+    }
+  catch (CString const & errorMessage)
+    {
+      _ftprintf (stderr, _T ("%s\n"), (LPCTSTR) errorMessage);
+
+      return 1;
+    }
+
+  return g_failures;
+}
+
+// ============================================================================
+//  R E V I S I O N    N O T E S
+// ============================================================================
+//
+//  For each change to this file, record the following:
+//
+//   1. who made the change and when the change was made
+//   2. why the change was made and the intended result
+//
+// ============================================================================
+//
+//  Date        Author  Description
+// ----------------------------------------------------------------------------
+//  10/17/2026  AGT     initial revision
+//  10/17/2026  AGT     open the I/O ports over the same connection, notifications go to the port that added them
+//
+// ============================================================================